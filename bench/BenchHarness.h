@@ -0,0 +1,175 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+// C++ standard library headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal harness shared by the bench_* executables. Every case runs a warm-up and
+// then a fixed number of repetitions; the report holds the median and the minimum
+// per item. Output is JSON with one case per line in a fixed order, so two runs can
+// be compared with a plain diff.
+//
+// Common arguments: --reps N (default 5), --quick (smaller sizes), --out FILE
+namespace bench
+{
+    struct Options
+    {
+        int reps = 5;
+        bool quick = false;
+        std::string out; // stdout when empty
+    };
+
+    inline Options parseOptions(int argc, char *argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--reps" && i + 1 < argc)
+                options.reps = std::max(1, std::atoi(argv[++i]));
+            else if (arg == "--quick")
+                options.quick = true;
+            else if (arg == "--out" && i + 1 < argc)
+                options.out = argv[++i];
+            else
+                std::cerr << "Ignoring unknown argument " << arg << std::endl;
+        }
+        return options;
+    }
+
+    class Suite
+    {
+    public:
+        Suite(std::string name, Options options) : name(std::move(name)), options(std::move(options)) {}
+
+        const Options &opts() const { return options; }
+
+        // Time body reps times (after one warm-up call); body processes items items per call.
+        // setup runs untimed before every call, e.g. to restore a file the body deletes.
+        template <typename Body, typename Setup>
+        void run(const std::string &caseName, uint64_t items, Body &&body, Setup &&setup)
+        {
+            setup();
+            body(); // Warm-up: caches, page faults, lazy initialization
+            std::vector<double> seconds;
+            for (int r = 0; r < options.reps; ++r)
+            {
+                setup();
+                auto start = std::chrono::steady_clock::now();
+                body();
+                seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            add(caseName, items, seconds);
+        }
+
+        template <typename Body>
+        void run(const std::string &caseName, uint64_t items, Body &&body)
+        {
+            run(caseName, items, std::forward<Body>(body), [] {});
+        }
+
+        // Record externally timed repetitions
+        void add(const std::string &caseName, uint64_t items, std::vector<double> seconds)
+        {
+            std::sort(seconds.begin(), seconds.end());
+            Case result;
+            result.name = caseName;
+            result.items = items;
+            result.medianSeconds = seconds[seconds.size() / 2];
+            result.minSeconds = seconds.front();
+            cases.push_back(result);
+            std::cerr << name << "/" << caseName << ": " << std::fixed << std::setprecision(1)
+                      << perItemNs(result.medianSeconds, items) << " ns/item" << std::endl;
+        }
+
+        // Write the JSON report, return the process exit code
+        int finish() const
+        {
+            std::ostringstream json;
+            json << "{\n  \"suite\": \"" << name << "\",\n  \"reps\": " << options.reps
+                 << ",\n  \"quick\": " << (options.quick ? "true" : "false") << ",\n  \"cases\": [";
+            for (size_t i = 0; i < cases.size(); ++i)
+            {
+                const Case &c = cases[i];
+                double median = perItemNs(c.medianSeconds, c.items);
+                json << (i ? "," : "") << "\n    {\"name\": \"" << c.name << "\", \"items\": " << c.items
+                     << std::fixed << std::setprecision(1) << ", \"median_ns_per_item\": " << median
+                     << ", \"min_ns_per_item\": " << perItemNs(c.minSeconds, c.items)
+                     << std::setprecision(0) << ", \"items_per_sec\": " << (median > 0 ? 1e9 / median : 0.0)
+                     << "}";
+            }
+            json << "\n  ]\n}\n";
+
+            if (options.out.empty())
+            {
+                std::cout << json.str();
+                return 0;
+            }
+            std::ofstream file(options.out, std::ios::trunc);
+            file << json.str();
+            return file ? 0 : 1;
+        }
+
+    private:
+        struct Case
+        {
+            std::string name;
+            uint64_t items = 0;
+            double medianSeconds = 0;
+            double minSeconds = 0;
+        };
+
+        static double perItemNs(double seconds, uint64_t items) { return items ? seconds * 1e9 / items : 0.0; }
+
+        std::string name;
+        Options options;
+        std::vector<Case> cases;
+    };
+
+    // Discard what the benchmarked code prints to std::cout, which holds the JSON report
+    class QuietStdout
+    {
+    public:
+        QuietStdout() : saved(std::cout.rdbuf(nullptr)) {}
+        ~QuietStdout()
+        {
+            std::cout.rdbuf(saved);
+            std::cout.clear();
+        }
+
+    private:
+        std::streambuf *saved;
+    };
+
+    // Scratch directory under the system temp directory, removed again on destruction
+    class ScratchDirectory
+    {
+    public:
+        explicit ScratchDirectory(const std::string &name)
+            : path(std::filesystem::temp_directory_path() / ("clickscript_bench_" + name))
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+            std::filesystem::create_directories(path);
+        }
+        ~ScratchDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+
+        const std::filesystem::path path;
+    };
+}
+
+#endif // BENCH_HARNESS_H
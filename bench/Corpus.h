@@ -0,0 +1,79 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+// C++ standard library headers
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+// Deterministic inputs for the benchmarks. The raw mt19937 sequence is fixed by the
+// standard (distributions are not), so a seed gives the same corpus on every platform.
+namespace corpus
+{
+    // Script of about lines commands between #start and #end: clicks, enters, loop
+    // number keys, DELAYs (0 ms unless realDelays, so execution never sleeps) and
+    // small REPEAT blocks.
+    inline std::string makeScript(size_t lines, uint32_t seed = 1, bool realDelays = false)
+    {
+        std::mt19937 rng(seed);
+        std::string text = "Generated benchmark script\n#start\n";
+        size_t written = 0;
+        while (written < lines)
+        {
+            uint32_t pick = rng() % 100;
+            int x = static_cast<int>(rng() % 1920), y = static_cast<int>(rng() % 1080);
+            if (pick < 40)
+                text += "LEFT " + std::to_string(x) + " " + std::to_string(y) + "\n";
+            else if (pick < 55)
+                text += "RIGHT " + std::to_string(x) + " " + std::to_string(y) + "\n";
+            else if (pick < 70)
+                text += "ENTER\n";
+            else if (pick < 85)
+                text += "DELAY " + std::to_string(realDelays ? rng() % 50 : 0) + "\n";
+            else if (pick < 95 || lines - written < 3)
+                text += "LOOP_NUMBER_KEY\n";
+            else
+            {
+                text += "REPEAT " + std::to_string(2 + rng() % 3) + "\nLEFT " + std::to_string(x) + " " +
+                        std::to_string(y) + "\nEND\n";
+                written += 2;
+            }
+            ++written;
+        }
+        text += "#end\n";
+        return text;
+    }
+
+    inline bool writeScript(const std::filesystem::path &path, size_t lines, uint32_t seed = 1,
+                            bool realDelays = false)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << makeScript(lines, seed, realDelays);
+        return static_cast<bool>(out);
+    }
+
+    // Fill directory with files empty regular files named f000000.dat, f000001.dat...
+    // Files already there are kept, so growing a corpus only creates the new ones.
+    inline bool makeDirectory(const std::filesystem::path &directory, size_t files)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        for (size_t i = 0; i < files; ++i)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "f%06zu.dat", i);
+            std::filesystem::path path = directory / name;
+            if (std::filesystem::exists(path, ec))
+                continue;
+            std::ofstream out(path, std::ios::binary);
+            if (!out)
+                return false;
+        }
+        return true;
+    }
+}
+
+#endif // BENCH_CORPUS_H
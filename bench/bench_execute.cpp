@@ -0,0 +1,101 @@
+// Engine throughput: ClickScript::execute rounds against the NULL input backend,
+// with and without the per-action timing histograms, TYPE cost per character and
+// PASTE cost for a 10 KB payload on the in-memory clipboard.
+
+#include "BenchHarness.h"
+#include "Corpus.h"
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "clickscript.h"
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite("execute", bench::parseOptions(argc, argv));
+    bench::ScratchDirectory scratch("execute");
+    MyLogger::getInstance().setLogFile((scratch.path / "bench.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_WARNING);
+
+    const int rounds = suite.opts().quick ? 20 : 100;
+    for (size_t lines : {100, 10000})
+    {
+        std::filesystem::path file = scratch.path / ("script_" + std::to_string(lines) + ".clk");
+        corpus::writeScript(file, lines);
+
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        script.setInputBackend(createInputBackend("NULL"));
+
+        // Actions per round, counted once since REPEAT makes it differ from the line count
+        script.resetExecutedActions();
+        script.execute();
+        uint64_t actions = script.getExecutedActions() * rounds;
+
+        for (bool timing : {false, true})
+        {
+            script.setTimingEnabled(timing);
+            suite.run("execute/lines=" + std::to_string(lines) + "/timing=" + (timing ? "on" : "off"), actions, [&]
+                      {
+                          for (int r = 0; r < rounds; ++r)
+                          {
+                              script.setCurrentLoop(r);
+                              script.execute();
+                          }
+                      });
+        }
+    }
+
+    // Form filling: TYPE lines of literal text with one {loop} each
+    {
+        const std::string field = "Order {loop}: Widget, qty 12, ship to 221B Baker St. (ATTN: J. Smith)";
+        std::filesystem::path file = scratch.path / "type.clk";
+        {
+            std::ofstream out(file, std::ios::binary | std::ios::trunc);
+            out << "#start\n";
+            for (int i = 0; i < 100; ++i)
+                out << "TYPE \"" << field << "\"\nENTER\n";
+            out << "#end\n";
+        }
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.setTimingEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        script.setInputBackend(createInputBackend("NULL"));
+
+        uint64_t chars = (field.size() - std::string("{loop}").size() + 2) * 100 * static_cast<uint64_t>(rounds);
+        suite.run("type/chars_per_text=" + std::to_string(field.size()), chars, [&]
+                  {
+                      for (int r = 0; r < rounds; ++r)
+                      {
+                          script.setCurrentLoop(r);
+                          script.execute();
+                      }
+                  });
+    }
+
+    // Bulk entry: one PASTE of a 10 KB file per round, no settle time between rounds
+    {
+        std::filesystem::path payload = scratch.path / "payload.txt";
+        std::filesystem::path file = scratch.path / "paste.clk";
+        {
+            std::ofstream out(payload, std::ios::binary | std::ios::trunc);
+            out << std::string(10240, 'x');
+            std::ofstream script(file, std::ios::binary | std::ios::trunc);
+            script << "#start\nPASTE FILE \"" << payload.generic_string() << "\"\n#end\n";
+        }
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.setTimingEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        script.setInputBackend(createInputBackend("NULL"));
+        script.setClipboard(createClipboardBackend("MEMORY"));
+        script.setPasteSettleTime(std::chrono::milliseconds(0));
+
+        suite.run("paste/bytes=10240", static_cast<uint64_t>(rounds), [&]
+                  {
+                      for (int r = 0; r < rounds; ++r)
+                          script.execute();
+                  });
+    }
+    return suite.finish();
+}
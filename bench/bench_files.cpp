@@ -0,0 +1,52 @@
+// Directory checks of Number_of_Files_Check: the full-scan count_FilesInPath /
+// deleteLatestFileInPath, next to the notification-driven DirectoryIndex.
+
+#include <fstream>
+
+#include "BenchHarness.h"
+#include "Corpus.h"
+#include "DirectoryIndex.h"
+#include "MyLogger.h"
+#include "clickscript.h"
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite("files", bench::parseOptions(argc, argv));
+    bench::ScratchDirectory scratch("files");
+    MyLogger::getInstance().setLogFile((scratch.path / "bench.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_WARNING);
+
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    if (suite.opts().quick)
+        sizes.pop_back();
+
+    ClickScript script;
+    std::filesystem::path directory = scratch.path / "dir";
+    for (size_t files : sizes)
+    {
+        corpus::makeDirectory(directory, files); // Grows the previous size
+        std::string dir = directory.string();
+        std::string suffix = "/files=" + std::to_string(files);
+
+        suite.run("count_FilesInPath" + suffix, files, [&]
+                  { script.count_FilesInPath(dir); });
+
+        // Every call deletes the newest file, recreate it untimed so the size stays put
+        std::filesystem::path newest = directory / "newest.dat";
+        auto recreate = [&]
+        { std::ofstream(newest, std::ios::binary).put('x'); };
+        suite.run("deleteLatestFileInPath" + suffix, files, [&]
+                  {
+                      bench::QuietStdout quiet; // It reports every deletion
+                      script.deleteLatestFileInPath(dir);
+                  },
+                  recreate);
+
+        DirectoryIndex index(dir);
+        suite.run("DirectoryIndex::count" + suffix, files, [&]
+                  { index.count(); });
+        suite.run("DirectoryIndex::deleteNewest" + suffix, files, [&]
+                  { index.deleteNewest(nullptr); }, recreate);
+    }
+    return suite.finish();
+}
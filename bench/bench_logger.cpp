@@ -0,0 +1,49 @@
+// MyLogger::log throughput with several threads logging at once, in the
+// synchronous and the asynchronous (ring + writer thread) mode.
+
+#include <thread>
+#include <vector>
+
+#include "BenchHarness.h"
+#include "MyLogger.h"
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite("logger", bench::parseOptions(argc, argv));
+    bench::ScratchDirectory scratch("logger");
+    MyLogger &logger = MyLogger::getInstance();
+    logger.setLogFile((scratch.path / "bench.log").string());
+    logger.setLogLevel(MyLogger::LogLevel::LOG_INFO);
+
+    const int perThread = suite.opts().quick ? 10000 : 50000;
+    for (bool async : {false, true})
+    {
+        if (async)
+            logger.enableAsync(8192, MyLogger::OverflowPolicy::BLOCK);
+        else
+            logger.disableAsync();
+
+        for (int threads : {1, 2, 4, 8})
+        {
+            uint64_t messages = static_cast<uint64_t>(threads) * perThread;
+            suite.run(std::string("log/") + (async ? "async" : "sync") + "/threads=" + std::to_string(threads),
+                      messages, [&]
+                      {
+                          std::vector<std::thread> producers;
+                          for (int t = 0; t < threads; ++t)
+                          {
+                              producers.emplace_back([&, t]
+                                                     {
+                                                         for (int i = 0; i < perThread; ++i)
+                                                             MYLOG_INFO("bench thread {} message {}", t, i);
+                                                     });
+                          }
+                          for (auto &producer : producers)
+                              producer.join();
+                          logger.flush(); // Count the writer's work too
+                      });
+        }
+    }
+    logger.disableAsync();
+    return suite.finish();
+}
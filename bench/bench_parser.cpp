@@ -0,0 +1,76 @@
+// Parser throughput: ClickScript::parseCommandLine on single lines and
+// load_ClickScript_fromfile on whole generated scripts (cache off, so every
+// load reads and parses the file).
+
+#include <string_view>
+#include <vector>
+
+#include "BenchHarness.h"
+#include "Corpus.h"
+#include "MyLogger.h"
+#include "ScriptStream.h"
+#include "clickscript.h"
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite("parser", bench::parseOptions(argc, argv));
+    bench::ScratchDirectory scratch("parser");
+    MyLogger::getInstance().setLogFile((scratch.path / "bench.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_WARNING);
+
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    if (suite.opts().quick)
+        sizes.pop_back();
+
+    for (size_t lines : sizes)
+    {
+        std::string text = corpus::makeScript(lines);
+
+        // The command lines between #start and #end, as the loader hands them over
+        std::vector<std::string_view> commands;
+        std::string_view rest(text);
+        bool inBlock = false;
+        while (!rest.empty())
+        {
+            size_t newline = rest.find('\n');
+            std::string_view line = rest.substr(0, newline);
+            rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+            if (line == "#start" || line == "#end")
+                inBlock = line == "#start";
+            else if (inBlock)
+                commands.push_back(line);
+        }
+
+        ClickScript script;
+        suite.run("parseCommandLine/lines=" + std::to_string(lines), commands.size(), [&]
+                  {
+                      size_t n = 0;
+                      for (std::string_view line : commands)
+                          script.parseCommandLine(line, ++n);
+                  });
+
+        std::filesystem::path file = scratch.path / ("script_" + std::to_string(lines) + ".clk");
+        corpus::writeScript(file, lines);
+        script.setCacheEnabled(false);
+        suite.run("load_ClickScript_fromfile/lines=" + std::to_string(lines), commands.size(), [&]
+                  { script.load_ClickScript_fromfile(file.string()); });
+
+        // One streamed pass: parser thread, queue hand-off and REPEAT replay
+        ScriptStream stream(
+            file.string(), 4096,
+            [&](std::string_view line, size_t n, bool, Behavior &behavior, std::vector<ScriptError> &)
+            {
+                behavior = script.parseCommandLine(line, n);
+                return true;
+            });
+        stream.open();
+        uint64_t streamed = 0;
+        suite.run("ScriptStream/lines=" + std::to_string(lines), commands.size(), [&]
+                  {
+                      Behavior behavior;
+                      while (stream.next(behavior) == ScriptStream::Next::ACTION)
+                          ++streamed;
+                  });
+    }
+    return suite.finish();
+}
@@ -0,0 +1,99 @@
+// Screen checks: the region comparison kernels (scalar, SSE2, AVX2) over a
+// full-HD BGRA frame, MemoryScreenSource captures and a met WAIT_PIXEL.
+
+#include <fstream>
+#include <random>
+
+#include "BenchHarness.h"
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "PixelKernels.h"
+#include "ScreenSource.h"
+#include "clickscript.h"
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite("pixels", bench::parseOptions(argc, argv));
+    bench::ScratchDirectory scratch("pixels");
+    MyLogger::getInstance().setLogFile((scratch.path / "bench.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_WARNING);
+
+    // Two frames that differ by noise within the tolerance and in one pixel out of 1000
+    const int width = 1920, height = 1080;
+    const size_t count = static_cast<size_t>(width) * height;
+    const uint8_t tolerance = 8;
+    std::vector<uint32_t> before(count), after(count);
+    std::mt19937 random(42);
+    for (size_t i = 0; i < count; ++i)
+    {
+        before[i] = random() | 0xFF000000u;
+        uint32_t noise = random() & 0x00070707;
+        after[i] = i % 1000 == 0 ? ~before[i] : (before[i] & 0xFFF8F8F8) | noise;
+    }
+
+    // Every kernel must agree with the scalar loop, also on the odd tail
+    const size_t expected = pixels::countDifferent(before.data(), after.data(), count - 3, tolerance,
+                                                   pixels::Kernel::SCALAR);
+    volatile size_t sink = 0;
+    for (pixels::Kernel kernel : {pixels::Kernel::SCALAR, pixels::Kernel::SSE2, pixels::Kernel::AVX2})
+    {
+        if (!pixels::supported(kernel))
+            continue;
+        if (pixels::countDifferent(before.data(), after.data(), count - 3, tolerance, kernel) != expected)
+        {
+            std::cerr << "Kernel " << pixels::kernelName(kernel) << " disagrees with SCALAR" << std::endl;
+            return 1;
+        }
+        // A typical cache resident region, then a whole frame limited by memory bandwidth
+        for (size_t region : {size_t(200 * 200), count})
+        {
+            std::string size = region == count ? "1920x1080" : "200x200";
+            suite.run(std::string("countDifferent/") + pixels::kernelName(kernel) + "/pixels=" + size, region, [&]
+                      { sink = sink + pixels::countDifferent(before.data(), after.data(), region, tolerance, kernel); });
+        }
+    }
+
+    MemoryScreenSource screen(width, height);
+    Frame frame;
+    const int captures = suite.opts().quick ? 100 : 1000;
+    suite.run("MemoryScreenSource::capture/region=200x200", static_cast<uint64_t>(captures), [&]
+              {
+                  for (int i = 0; i < captures; ++i)
+                      screen.capture(860, 440, 200, 200, frame);
+              });
+
+    // WAIT_PIXEL that is met on the first capture: the overhead added to a round per check
+    {
+        auto ready = std::make_shared<MemoryScreenSource>(width, height);
+        ready->setPixel(10, 10, 0xFF00FF00);
+        std::filesystem::path file = scratch.path / "wait.clk";
+        {
+            std::ofstream out(file, std::ios::binary | std::ios::trunc);
+            out << "#start\n";
+            for (int i = 0; i < 100; ++i)
+                out << "WAIT_PIXEL 10 10 00FF00 0 1000\n";
+            out << "#end\n";
+        }
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        script.setInputBackend(createInputBackend("NULL"));
+        script.setScreenSource(ready);
+        script.setTimingEnabled(false);
+        const int rounds = suite.opts().quick ? 20 : 100;
+        suite.run("wait_pixel/met", static_cast<uint64_t>(rounds) * 100, [&]
+                  {
+                      for (int r = 0; r < rounds; ++r)
+                      {
+                          script.setCurrentLoop(r);
+                          script.execute();
+                      }
+                  });
+        if (script.runAborted())
+        {
+            std::cerr << script.getAbortReason() << std::endl;
+            return 1;
+        }
+    }
+    return suite.finish();
+}
@@ -0,0 +1,28 @@
+// Writes the benchmark inputs to disk, to inspect them or to run the main
+// program on them:
+//   bench_corpus script <file.clk> <lines> [seed] [--real-delays]
+//   bench_corpus dir <directory> <files>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "Corpus.h"
+
+int main(int argc, char *argv[])
+{
+    std::string mode = argc >= 2 ? argv[1] : "";
+    if (mode == "script" && argc >= 4)
+    {
+        uint32_t seed = argc >= 5 && std::string(argv[4]) != "--real-delays" ? std::atoi(argv[4]) : 1;
+        bool realDelays = std::string(argv[argc - 1]) == "--real-delays";
+        return corpus::writeScript(argv[2], std::strtoull(argv[3], nullptr, 10), seed, realDelays) ? 0 : 1;
+    }
+    if (mode == "dir" && argc >= 4)
+    {
+        return corpus::makeDirectory(argv[2], std::strtoull(argv[3], nullptr, 10)) ? 0 : 1;
+    }
+    std::cerr << "Usage: bench_corpus script <file.clk> <lines> [seed] [--real-delays]\n"
+              << "       bench_corpus dir <directory> <files>" << std::endl;
+    return 2;
+}
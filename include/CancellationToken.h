@@ -0,0 +1,67 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+// C++ standard library headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Stop / pause requests shared between the engine and the listener threads.
+// The engine polls state() once per action; waits block on a condition
+// variable that requestStop() and resume() wake immediately.
+class CancellationToken
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    enum class State : uint8_t
+    {
+        RUNNING,
+        PAUSED,
+        STOPPED
+    };
+
+    State state() const { return currentState.load(std::memory_order_relaxed); }
+    bool stopRequested() const { return state() == State::STOPPED; }
+    bool isPaused() const { return state() == State::PAUSED; }
+
+    // Requests from other threads
+    void requestStop();
+    void pause();
+    void resume();
+    void reset(); // Back to RUNNING and clear the stop latency
+
+    // Wait until deadline unless a stop arrives first, false when stopped
+    bool waitUntil(clock::time_point deadline);
+    bool waitFor(std::chrono::nanoseconds duration) { return waitUntil(clock::now() + duration); }
+
+    // Wait until ready() holds, re-checked after every wake(). False on a stop or at
+    // the deadline. ready runs with the token lock held and must not call back into it.
+    bool waitUntil(clock::time_point deadline, const std::function<bool()> &ready);
+
+    // Make waitUntil(deadline, ready) callers check their condition again, from any thread
+    void wake();
+
+    // Block while paused, return how long the pause lasted
+    std::chrono::nanoseconds waitWhilePaused();
+
+    // Called by the engine when it has stopped acting on a stop request.
+    // The first call records the time since requestStop().
+    void acknowledgeStop();
+    bool hasStopLatency() const { return stopLatencyNs.load() >= 0; }
+    std::chrono::nanoseconds stopLatency() const { return std::chrono::nanoseconds(stopLatencyNs.load()); }
+
+private:
+    void setState(State state);
+
+    std::atomic<State> currentState{State::RUNNING};
+    std::atomic<int64_t> stopRequestNs{0}; // steady_clock time of requestStop()
+    std::atomic<int64_t> stopLatencyNs{-1};
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+#endif // CANCELLATIONTOKEN_H
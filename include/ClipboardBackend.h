@@ -0,0 +1,61 @@
+#ifndef CLIPBOARDBACKEND_H
+#define CLIPBOARDBACKEND_H
+
+// C++ standard library headers
+#include <memory>
+#include <string>
+
+// Text clipboard used by PASTE. Text is UTF-8 on every backend.
+class ClipboardBackend
+{
+public:
+    virtual ~ClipboardBackend() = default;
+
+    // Backend name as used in the configuration file
+    virtual const char *name() const = 0;
+
+    // Current text, false if the clipboard holds no text or can not be read
+    virtual bool getText(std::string &text) = 0;
+
+    // Replace the clipboard contents with text
+    virtual bool setText(const std::string &text) = 0;
+
+    // Leave the clipboard empty
+    virtual bool clear() = 0;
+};
+
+#ifdef _WIN32
+// The system clipboard, as CF_UNICODETEXT
+class Win32ClipboardBackend : public ClipboardBackend
+{
+public:
+    const char *name() const override { return "WIN32"; }
+    bool getText(std::string &text) override;
+    bool setText(const std::string &text) override;
+    bool clear() override;
+};
+#endif
+
+// Clipboard held in memory, for headless runs and dry runs
+class MemoryClipboardBackend : public ClipboardBackend
+{
+public:
+    const char *name() const override { return "MEMORY"; }
+    bool getText(std::string &text) override;
+    bool setText(const std::string &text) override;
+    bool clear() override;
+
+    // Number of setText calls, e.g. to check what a run pasted
+    size_t writes() const { return writeCount; }
+
+private:
+    std::string contents;
+    bool hasText = false;
+    size_t writeCount = 0;
+};
+
+// Create a backend by configuration name (WIN32, MEMORY).
+// An empty or unknown name selects the platform default.
+std::shared_ptr<ClipboardBackend> createClipboardBackend(const std::string &name = "");
+
+#endif // CLIPBOARDBACKEND_H
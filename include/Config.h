@@ -2,7 +2,6 @@
 #define CONFIG_H
 
 // C++ standard library headers
-#include <windows.h>
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -19,6 +18,10 @@ public:
     // Load configuration file
     bool load();
 
+    // Configuration file used by load / save / create
+    void setFilename(const std::string &name) { filename = name; }
+    const std::string &getFilename() const { return filename; }
+
     // Get configuration item, return default value if not found
     std::string get(const std::string &key, const std::string &defaultValue = "") const;
 
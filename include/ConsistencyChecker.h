@@ -0,0 +1,95 @@
+#ifndef CONSISTENCYCHECKER_H
+#define CONSISTENCYCHECKER_H
+
+// C++ standard library headers
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project local headers
+#include "ThreadPool.h"
+
+// Compares groups of directory trees that should hold the same files: by relative
+// name, by size, and optionally by a streamed hash64 of the content. Listing and
+// hashing run in parallel on a thread pool. Hashes are cached by path, size and
+// modification time, so a check repeated every round only reads changed files.
+class ConsistencyChecker
+{
+public:
+    enum class Level
+    {
+        NAMES,
+        SIZES,
+        HASHES
+    };
+
+    // Parse NAMES / SIZES / HASH, false if name is none of them
+    static bool parseLevel(const std::string &name, Level &level);
+
+    // One directory group, the first directory is the reference for the others
+    struct Group
+    {
+        std::string name;
+        std::vector<std::string> directories;
+    };
+
+    struct Mismatch
+    {
+        std::string relative; // File path relative to the group directories
+        std::string detail;   // e.g. "missing in B", "size 10 in A, 12 in B"
+
+        bool operator<(const Mismatch &other) const
+        {
+            return relative != other.relative ? relative < other.relative : detail < other.detail;
+        }
+    };
+
+    struct Report
+    {
+        std::vector<Mismatch> appeared; // Not present at the previous check
+        size_t resolved = 0;            // Present at the previous check, gone now
+        size_t total = 0;               // Mismatches now
+        uint64_t bytesHashed = 0;       // Content read for this check
+    };
+
+    ConsistencyChecker(Level level, int threads);
+
+    // Parse "dirA;dirB;dirC" groups
+    void addGroup(const std::string &name, const std::string &directories);
+    const std::vector<Group> &groups() const { return groupList; }
+
+    // Check group index, comparing with what the previous check of that group found
+    Report check(size_t index);
+
+private:
+    struct FileRecord
+    {
+        std::string relative;
+        uint64_t size = 0;
+        std::filesystem::file_time_type mtime;
+    };
+
+    struct CachedHash
+    {
+        uint64_t size;
+        std::filesystem::file_time_type mtime;
+        uint64_t hash;
+    };
+
+    static void listTree(const std::string &directory, std::vector<FileRecord> &files);
+    bool hashFile(const std::filesystem::path &path, const FileRecord &record, uint64_t &hash, uint64_t &bytesRead);
+
+    Level level;
+    ThreadPool pool;
+    std::vector<Group> groupList;
+    std::vector<std::set<Mismatch>> previous; // Per group
+
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, CachedHash> hashCache;
+};
+
+#endif // CONSISTENCYCHECKER_H
@@ -0,0 +1,104 @@
+#ifndef DELAYSCHEDULER_H
+#define DELAYSCHEDULER_H
+
+// C++ standard library headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Project local headers
+#include "CancellationToken.h"
+#include "LatencyHistogram.h"
+
+// Measured timing error of one DELAY position within a round
+struct DelayStats
+{
+    int intendedMs = 0;      // Delay as written in the script
+    uint64_t count = 0;      // Number of rounds that reached this delay
+    int64_t minErrorNs = 0;  // Wake-up time minus target time, negative is early
+    int64_t maxErrorNs = 0;
+    int64_t sumErrorNs = 0;
+    int64_t sumAbsErrorNs = 0;
+};
+
+// Schedules DELAY actions against absolute deadlines measured from the
+// start of the round, so time spent injecting input and error of earlier
+// waits does not accumulate. Waits sleep for the coarse part and spin for
+// the rest, using the sleep granularity calibrated at startup.
+class DelayScheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // DELAY positions with their own jitter line, bounded for huge (streamed) scripts
+    static constexpr size_t MAX_TRACKED_DELAYS = 256;
+
+    // Measure the platform sleep granularity, called once at startup
+    static void calibrate(int samples = 20);
+    static std::chrono::nanoseconds sleepGranularity();
+
+    // Start a new round, deadlines restart from now
+    void beginRound();
+
+    // Advance the deadline by delayMs and wait until it is reached.
+    // With a token the wait ends early on a stop request and returns false.
+    bool waitFor(int delayMs, CancellationToken *token = nullptr);
+
+    // Virtual clock for dry runs: waits advance simulated time instead of sleeping,
+    // and no jitter is recorded. Enabling it restarts simulated time at zero.
+    void setVirtualClock(bool enabled);
+    bool isVirtualClock() const { return virtualClock; }
+    std::chrono::nanoseconds virtualElapsed() const { return virtualNow.time_since_epoch(); }
+
+    // Move the remaining deadlines of the round later, e.g. by a pause
+    void shiftDeadline(std::chrono::nanoseconds offset) { deadline += offset; }
+
+    // Moves the remaining deadlines by its own lifetime, so DELAYs after a blocking
+    // command (a pause, WAIT_FILE, a screen wait, a paste settling) count from its end
+    class ExcludedWait
+    {
+    public:
+        explicit ExcludedWait(DelayScheduler &scheduler) : scheduler(scheduler), start(clock::now()) {}
+        ~ExcludedWait() { scheduler.shiftDeadline(clock::now() - start); }
+
+        ExcludedWait(const ExcludedWait &) = delete;
+        ExcludedWait &operator=(const ExcludedWait &) = delete;
+
+        clock::time_point started() const { return start; }
+
+    private:
+        DelayScheduler &scheduler;
+        const clock::time_point start;
+    };
+    ExcludedWait excludeWait() { return ExcludedWait(*this); }
+
+    // Report how long an input submission took, used to wake up early
+    // enough for the following input to land on the deadline
+    void recordInjection(std::chrono::nanoseconds latency);
+    std::chrono::nanoseconds injectionEstimate() const { return injectionLatency; }
+
+    const std::vector<DelayStats> &delayStats() const { return stats; }
+    // Wake-up error of every real DELAY, never early since the wait spins up to the target
+    const LatencyHistogram &errorHistogram() const { return errors; }
+    void resetStats()
+    {
+        stats.clear();
+        errors.reset();
+    }
+
+    // Print one line per DELAY position with the measured jitter
+    void report(std::ostream &out) const;
+
+private:
+    clock::time_point deadline;
+    std::chrono::nanoseconds injectionLatency{0}; // Moving average of the submission time
+    size_t delayIndex = 0;                        // Position of the next DELAY within the round
+    std::vector<DelayStats> stats;
+    LatencyHistogram errors;
+    bool virtualClock = false;
+    clock::time_point virtualNow{}; // Simulated time, starts at the clock epoch
+};
+
+#endif // DELAYSCHEDULER_H
@@ -0,0 +1,94 @@
+#ifndef DIRECTORYINDEX_H
+#define DIRECTORYINDEX_H
+
+// C++ standard library headers
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Project local headers
+#include "ThreadManager.h"
+
+// Live index of the regular files directly inside one directory, kept up to date
+// from change notifications (inotify / ReadDirectoryChangesW) instead of scans.
+// Queries first apply the notifications the OS has already queued, so they see
+// every change made before the call. An overflowed notification queue, or a
+// directory that can not be watched, falls back to a full rescan.
+class DirectoryIndex
+{
+public:
+    using Name = std::filesystem::path::string_type;
+
+    explicit DirectoryIndex(const std::string &directory);
+    ~DirectoryIndex();
+
+    DirectoryIndex(const DirectoryIndex &) = delete;
+    DirectoryIndex &operator=(const DirectoryIndex &) = delete;
+
+    const std::string &path() const { return directory; }
+    bool isWatching() const { return watching; } // False: every query rescans
+
+    // Also apply notifications on the reactor thread, so long rounds can not overflow the queue
+    void watch(ThreadManager &reactor);
+
+    // Called on the reactor thread after it applied a batch of notifications, without the
+    // index lock held. Set before watch().
+    void onChange(std::function<void()> callback) { changeCallback = std::move(callback); }
+
+    // Number of regular files, O(1) after the pending notifications are applied
+    size_t count();
+
+    // Path of the file with the newest modification time, false if there is none
+    bool newest(std::string &file);
+
+    // Whether a file name matches pattern (UTF-8, * and ? wildcards), with its path in file
+    bool findMatching(const std::string &pattern, std::string *file = nullptr);
+
+    // Delete the newest file. Return false if there is none or it can not be removed.
+    bool deleteNewest(std::string *deleted = nullptr);
+
+    // Throw the index away and list the directory again
+    void rescan();
+    uint64_t rescans() const { return rescanCount; }
+
+private:
+    void refresh(); // Apply queued notifications, mtx held
+    void applyChange(const Name &name);
+    void applyRemoval(const Name &name);
+    void rebuild();
+    bool openWatch();
+    void closeWatch(); // mtx held, also from the reactor thread
+    void leaveReactor();
+
+    std::string directory;
+    std::filesystem::path root;
+
+    std::mutex mtx; // Guards the index and the notification handle
+    std::unordered_map<Name, std::filesystem::file_time_type> files;
+    std::set<std::pair<std::filesystem::file_time_type, Name>> byTime; // Oldest first
+    uint64_t rescanCount = 0;
+    std::atomic<bool> watching{false}; // Cleared on the reactor thread when the watch fails
+
+    ThreadManager *reactor = nullptr;
+    int reactorHandle = 0; // Guarded by mtx, the callback may remove it
+    std::function<void()> changeCallback;
+
+#ifdef _WIN32
+    HANDLE directoryHandle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped{};
+    std::vector<DWORD> buffer; // DWORD aligned as FILE_NOTIFY_INFORMATION requires
+    bool issueRead();
+#else
+    int notifyFd = -1;
+    std::vector<char> buffer;
+#endif
+};
+
+#endif // DIRECTORYINDEX_H
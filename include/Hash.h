@@ -0,0 +1,12 @@
+#ifndef HASH_H
+#define HASH_H
+
+// C++ standard library headers
+#include <cstddef>
+#include <cstdint>
+
+// Fast non-cryptographic 64-bit hash (MurmurHash64A).
+// Hash a buffer in pieces by passing the previous result as the seed.
+uint64_t hash64(const void *data, size_t size, uint64_t seed = 0);
+
+#endif // HASH_H
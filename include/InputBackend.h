@@ -0,0 +1,216 @@
+#ifndef INPUTBACKEND_H
+#define INPUTBACKEND_H
+
+// C++ standard library headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Virtual key codes shared by all backends (Win32 numbering)
+namespace VirtualKey
+{
+    constexpr uint16_t TAB = 0x09;
+    constexpr uint16_t RETURN = 0x0D;
+    constexpr uint16_t SHIFT = 0x10;
+    constexpr uint16_t CONTROL = 0x11;
+}
+
+// Key, and whether Shift is held, that types one character
+struct KeyStroke
+{
+    uint16_t vk = 0; // 0 if the character can not be typed
+    bool shift = false;
+};
+
+namespace detail
+{
+    // US layout: letters and digits share their ASCII code with the virtual key,
+    // punctuation sits on the OEM keys
+    constexpr std::array<KeyStroke, 128> makeAsciiKeyTable()
+    {
+        std::array<KeyStroke, 128> table{};
+        for (char c = 'a'; c <= 'z'; ++c)
+        {
+            table[c] = {static_cast<uint16_t>(c - 'a' + 'A'), false};
+            table[c - 'a' + 'A'] = {static_cast<uint16_t>(c - 'a' + 'A'), true};
+        }
+        for (char c = '0'; c <= '9'; ++c)
+            table[c] = {static_cast<uint16_t>(c), false};
+        constexpr std::string_view shiftedDigits = ")!@#$%^&*(";
+        for (size_t i = 0; i < shiftedDigits.size(); ++i)
+            table[shiftedDigits[i]] = {static_cast<uint16_t>('0' + i), true};
+
+        struct Oem
+        {
+            char plain;
+            char shifted;
+            uint16_t vk;
+        };
+        constexpr Oem oemKeys[] = {{';', ':', 0xBA}, {'=', '+', 0xBB}, {',', '<', 0xBC}, {'-', '_', 0xBD},
+                                   {'.', '>', 0xBE}, {'/', '?', 0xBF}, {'`', '~', 0xC0}, {'[', '{', 0xDB},
+                                   {'\\', '|', 0xDC}, {']', '}', 0xDD}, {'\'', '"', 0xDE}};
+        for (const Oem &key : oemKeys)
+        {
+            table[key.plain] = {key.vk, false};
+            table[key.shifted] = {key.vk, true};
+        }
+        table[' '] = {0x20, false};
+        table['\t'] = {VirtualKey::TAB, false};
+        table['\n'] = {VirtualKey::RETURN, false};
+        return table;
+    }
+}
+
+// Built at compile time, typing a character is one table load
+inline constexpr std::array<KeyStroke, 128> ASCII_KEYS = detail::makeAsciiKeyTable();
+
+constexpr KeyStroke keyForChar(char ch)
+{
+    unsigned char c = static_cast<unsigned char>(ch);
+    return c < ASCII_KEYS.size() ? ASCII_KEYS[c] : KeyStroke{};
+}
+
+static_assert(keyForChar('a').vk == 'A' && !keyForChar('a').shift && keyForChar('A').shift);
+static_assert(keyForChar('@').vk == '2' && keyForChar('@').shift && keyForChar('\x7F').vk == 0);
+
+enum class InputEventType : uint8_t
+{
+    MOUSE_MOVE, // Move cursor to absolute screen coordinates
+    MOUSE_DOWN,
+    MOUSE_UP,
+    KEY_DOWN,
+    KEY_UP
+};
+
+enum class MouseButton : uint8_t
+{
+    LEFT,
+    RIGHT
+};
+
+struct InputEvent
+{
+    InputEventType type = InputEventType::MOUSE_MOVE;
+    MouseButton button = MouseButton::LEFT;
+    uint16_t key = 0; // Virtual key code for KEY_DOWN / KEY_UP
+    int x = 0;        // Screen coordinates for mouse events
+    int y = 0;
+};
+
+// Run of input events that are injected together in one submission
+class InputBatch
+{
+public:
+    void moveCursor(int x, int y);
+    void mouseButton(MouseButton button, bool down, int x, int y);
+    void key(uint16_t vk, bool down);
+
+    // Move + button down + button up
+    void click(MouseButton button, int x, int y);
+    // Key down + key up
+    void keyPress(uint16_t vk);
+    // Key presses that type text, Shift held over each run of shifted characters.
+    // Returns the number of characters that have no key and were skipped.
+    size_t typeText(std::string_view text);
+    // Copy events queued elsewhere, e.g. text typed ahead of time
+    void append(const InputEvent *first, size_t count) { events.insert(events.end(), first, first + count); }
+
+    const InputEvent *data() const { return events.data(); }
+    size_t size() const { return events.size(); }
+    bool empty() const { return events.empty(); }
+    void clear() { events.clear(); } // Keeps the capacity for the next batch
+
+private:
+    std::vector<InputEvent> events;
+};
+
+class InputBackend
+{
+public:
+    virtual ~InputBackend() = default;
+
+    // Backend name as used in the configuration file
+    virtual const char *name() const = 0;
+
+    // Inject a run of events as one submission, in order
+    virtual void submit(const InputEvent *events, size_t count) = 0;
+
+    void submitBatch(const InputBatch &batch) { submit(batch.data(), batch.size()); }
+    void send(const InputEvent &event) { submit(&event, 1); }
+};
+
+#ifdef _WIN32
+#include <windows.h>
+
+// Injects input into the desktop through the Win32 API
+class Win32InputBackend : public InputBackend
+{
+public:
+    const char *name() const override { return "WIN32"; }
+    // All events of the run go through a single SendInput call
+    void submit(const InputEvent *events, size_t count) override;
+
+private:
+    std::vector<INPUT> inputs; // Reused between submissions
+};
+#endif
+
+// Discards every event, used to measure raw engine throughput
+class NullInputBackend : public InputBackend
+{
+public:
+    const char *name() const override { return "NULL"; }
+    void submit(const InputEvent *, size_t) override {}
+};
+
+// Keeps an in-memory, timestamped copy of every event
+class RecordingInputBackend : public InputBackend
+{
+public:
+    struct RecordedEvent
+    {
+        InputEvent event;
+        int64_t timestampNs = 0; // Nanoseconds since the recording started
+        uint64_t submission = 0; // Index of the submission the event arrived in
+    };
+
+    RecordingInputBackend();
+
+    const char *name() const override { return "RECORDING"; }
+    void submit(const InputEvent *events, size_t count) override;
+
+    const std::vector<RecordedEvent> &events() const { return recorded; }
+    void clear();
+
+    // Take timestamps from nowNs instead of the steady clock, e.g. a virtual clock
+    void setClock(std::function<int64_t()> nowNs) { timeSource = std::move(nowNs); }
+
+    // Submissions made since the recording started / since the last reset
+    uint64_t totalSubmissions() const { return submissionCount; }
+    uint64_t submissions() const { return submissionCount - submissionMark; }
+    void resetSubmissions() { submissionMark = submissionCount; }
+
+    // Write the event stream as text, one event per line,
+    // optionally prefixed with the timestamp and submission index
+    void write(std::ostream &out, bool withTimestamps = true) const;
+    bool save(const std::string &filename, bool withTimestamps = true) const;
+
+private:
+    std::vector<RecordedEvent> recorded;
+    std::chrono::steady_clock::time_point start;
+    std::function<int64_t()> timeSource;
+    uint64_t submissionCount = 0;
+    uint64_t submissionMark = 0;
+};
+
+// Create a backend by configuration name (WIN32, NULL, RECORDING).
+// An empty or unknown name selects the platform default.
+std::shared_ptr<InputBackend> createInputBackend(const std::string &name = "");
+
+#endif // INPUTBACKEND_H
@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+// C++ standard library headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Fixed-bucket log-linear histogram of nanosecond durations: every power of two
+// is split into 32 linear sub-buckets, so a percentile is within ~3% of the true
+// value. Recording is a bit scan and an increment, no allocation and no lock
+// (single writer), which keeps it cheap enough to stay on during real runs.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 5;      // 32 sub-buckets per power of two
+    static constexpr int MAX_EXPONENT = 42; // Values from 2^42 ns (~73 min) on share the last bucket
+    static constexpr size_t BUCKETS = static_cast<size_t>(MAX_EXPONENT - SUB_BITS + 1) << SUB_BITS;
+
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minimum : 0; }
+    uint64_t max() const { return maximum; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Highest value of the bucket holding the q-th percentile (0..100), clamped to min / max
+    uint64_t percentile(double q) const;
+
+    // Named histograms, e.g. one per action kind
+    using Named = std::vector<std::pair<std::string, const LatencyHistogram *>>;
+
+    // Table with count, min, p50, p90, p99 and max in microseconds, empty histograms are skipped
+    static void printTable(std::ostream &out, const Named &histograms);
+    // JSON object "name": {count, min, p50, p90, p99, max, mean} in nanoseconds
+    static void writeJson(std::ostream &out, const Named &histograms, int indent = 2);
+
+private:
+    static size_t bucketOf(uint64_t ns);
+    static uint64_t bucketHighest(size_t bucket);
+
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t total = 0;
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+    uint64_t sum = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
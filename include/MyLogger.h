@@ -1,16 +1,104 @@
 #ifndef MyLogger_H
 #define MyLogger_H
 
-#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+
+#include "RingBuffer.h"
 
 #define OVERWRITE_LOG_FILE 1 // overwrite the log file on each run
 
+// Build-time minimum log level: 0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR.
+// MYLOG_* calls below it are compiled out entirely.
+#ifndef MYLOGGER_MIN_LEVEL
+#define MYLOGGER_MIN_LEVEL 0
+#endif
+
+// Minimal std::format-style formatting: every "{}" is replaced by the next
+// argument, "{{" and "}}" produce literal braces.
+namespace logfmt
+{
+    inline void appendArg(std::string &out, const std::string &value) { out += value; }
+    inline void appendArg(std::string &out, const char *value) { out += value; }
+    inline void appendArg(std::string &out, char value) { out += value; }
+    inline void appendArg(std::string &out, bool value) { out += value ? "true" : "false"; }
+
+    template <typename T>
+    void appendArg(std::string &out, const T &value)
+    {
+        if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>)
+        {
+            out += std::to_string(value);
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            out += std::to_string(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else
+        {
+            std::ostringstream oss;
+            oss << value;
+            out += oss.str();
+        }
+    }
+
+    // Append literal text up to the next placeholder, return false at the end of fmt
+    inline bool appendLiteral(std::string &out, const char *&fmt)
+    {
+        while (*fmt)
+        {
+            if (fmt[0] == '{' && fmt[1] == '}')
+            {
+                fmt += 2;
+                return true;
+            }
+            if ((fmt[0] == '{' && fmt[1] == '{') || (fmt[0] == '}' && fmt[1] == '}'))
+            {
+                ++fmt;
+            }
+            out += *fmt++;
+        }
+        return false;
+    }
+
+    inline void formatTo(std::string &out, const char *fmt)
+    {
+        while (appendLiteral(out, fmt))
+        {
+            // Placeholder without argument is dropped
+        }
+    }
+
+    template <typename First, typename... Rest>
+    void formatTo(std::string &out, const char *fmt, const First &first, const Rest &...rest)
+    {
+        if (appendLiteral(out, fmt))
+        {
+            appendArg(out, first);
+            formatTo(out, fmt, rest...);
+        }
+    }
+
+    template <typename... Args>
+    std::string format(const char *fmt, const Args &...args)
+    {
+        std::string out;
+        formatTo(out, fmt, args...);
+        return out;
+    }
+}
+
 class MyLogger
 {
 public:
@@ -22,6 +110,14 @@ public:
         LOG_ERROR
     };
 
+    // What an async producer does when the queue is full
+    enum class OverflowPolicy
+    {
+        BLOCK,     // Wait for the writer to make room
+        DROP,      // Discard the message
+        DROP_COUNT // Discard the message and report the number of drops in the log
+    };
+
     // Singleton instance access
     static MyLogger &getInstance();
 
@@ -30,15 +126,41 @@ public:
 
     // Set the minimum log level to output
     void setLogLevel(LogLevel level);
+    LogLevel getLogLevel() const { return currentLogLevel.load(std::memory_order_relaxed); }
+
+    // Async mode: messages are queued and written by a background thread.
+    // Disabling it drains the queue and stops the writer.
+    void enableAsync(size_t queueSize = 8192, OverflowPolicy policy = OverflowPolicy::BLOCK);
+    void disableAsync();
+    bool isAsync() const { return asyncEnabled.load(std::memory_order_acquire); }
+
+    // Block until every message logged so far has been written
+    void flush();
+
+    // Messages discarded by the DROP / DROP_COUNT policies
+    uint64_t droppedMessages() const { return dropped.load(std::memory_order_relaxed); }
+
+    // True if a message of this level would be written
+    bool isEnabled(LogLevel level) const { return level >= currentLogLevel.load(std::memory_order_relaxed); }
 
     // Log a message with a specific log level
-    void log(LogLevel level, const std::string &message);
+    void log(LogLevel level, std::string message);
+
+    // Format and log, the arguments are only rendered if the level is enabled
+    template <typename... Args>
+    void logf(LogLevel level, const char *fmt, const Args &...args)
+    {
+        if (isEnabled(level))
+        {
+            log(level, logfmt::format(fmt, args...));
+        }
+    }
 
     // Convenience methods for specific log levels
-    void info(const std::string &message);
-    void warning(const std::string &message);
-    void error(const std::string &message);
-    void debug(const std::string &message);
+    void info(std::string message);
+    void warning(std::string message);
+    void error(std::string message);
+    void debug(std::string message);
 
     // Split line for better readability in logs
     void splitLine()
@@ -52,12 +174,58 @@ private:
     MyLogger(const MyLogger &) = delete;
     MyLogger &operator=(const MyLogger &) = delete;
 
+    struct Record
+    {
+        LogLevel level = LogLevel::LOG_INFO;
+        std::time_t time = 0;
+        std::string message;
+    };
+
     std::ofstream logFile;
-    LogLevel currentLogLevel;
-    std::mutex logMutex;
+    std::atomic<LogLevel> currentLogLevel;
+    std::mutex logMutex; // Guards logFile
+
+    // Async mode state
+    std::unique_ptr<MpscRingBuffer<Record>> queue;
+    OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+    std::atomic<bool> asyncEnabled{false};
+    std::atomic<bool> stopWriter{false};
+    std::atomic<bool> writerIdle{false};
+    std::atomic<int> activeProducers{0}; // Producers currently inside the async path
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::thread writerThread;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    void writerLoop();
+    void wakeWriter();
+
+    // Format and write one record, logMutex must be held
+    void writeRecord(const Record &record, std::string &buffer);
 
     // Helper to convert LogLevel to string
     std::string logLevelToString(LogLevel level);
 };
 
-#endif // MyLogger_H
\ No newline at end of file
+// Logging macros, filtered at build time by MYLOGGER_MIN_LEVEL and at run
+// time by the logger level before any argument is formatted.
+// Usage: MYLOG_DEBUG("Clicked at ({}, {})", x, y);
+#define MYLOG_AT(minLevel, level, ...)                                  \
+    do                                                                  \
+    {                                                                   \
+        if constexpr (MYLOGGER_MIN_LEVEL <= (minLevel))                 \
+        {                                                               \
+            MyLogger &myLogger_ = MyLogger::getInstance();              \
+            if (myLogger_.isEnabled(level))                             \
+                myLogger_.log(level, logfmt::format(__VA_ARGS__));      \
+        }                                                               \
+    } while (0)
+
+#define MYLOG_DEBUG(...) MYLOG_AT(0, MyLogger::LogLevel::LOG_DEBUG, __VA_ARGS__)
+#define MYLOG_INFO(...) MYLOG_AT(1, MyLogger::LogLevel::LOG_INFO, __VA_ARGS__)
+#define MYLOG_WARNING(...) MYLOG_AT(2, MyLogger::LogLevel::LOG_WARNING, __VA_ARGS__)
+#define MYLOG_ERROR(...) MYLOG_AT(3, MyLogger::LogLevel::LOG_ERROR, __VA_ARGS__)
+
+#endif // MyLogger_H
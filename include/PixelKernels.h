@@ -0,0 +1,44 @@
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+// C++ standard library headers
+#include <cstddef>
+#include <cstdint>
+
+// Comparison of BGRA pixels (one uint32_t 0xAARRGGBB per pixel, alpha ignored).
+// Rows are compared with SSE2 or AVX2 when the CPU has them, the widest kernel
+// is picked once at run time; other CPUs use the scalar loop.
+namespace pixels
+{
+    enum class Kernel : uint8_t
+    {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    // Widest kernel this build and CPU can run
+    Kernel best();
+    bool supported(Kernel kernel);
+    const char *kernelName(Kernel kernel);
+
+    // True if the blue, green or red channel of a and b differ by more than tolerance
+    inline bool differs(uint32_t a, uint32_t b, uint8_t tolerance)
+    {
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            int delta = static_cast<int>((a >> shift) & 0xFF) - static_cast<int>((b >> shift) & 0xFF);
+            if (delta > tolerance || -delta > tolerance)
+                return true;
+        }
+        return false;
+    }
+
+    // Number of pixels of a that differ from the same pixel of b, with the best kernel
+    size_t countDifferent(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance);
+
+    // Same with a given kernel, which must be supported (benchmarks)
+    size_t countDifferent(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance, Kernel kernel);
+}
+
+#endif // PIXELKERNELS_H
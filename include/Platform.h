@@ -0,0 +1,32 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// C++ standard library headers
+#include <string>
+
+// System-specific headers
+#ifdef _WIN32
+#include <windows.h>
+#include <shellapi.h>
+#include <shobjidl.h> // For ITaskbarList3
+#endif
+
+// Thin wrappers over console and desktop functions that differ per platform
+namespace platform
+{
+    void sleepMs(int milliseconds);
+    void clearScreen();
+    void setConsoleTitle(const std::string &title);
+    void warningBeep();
+
+    // Raise the system timer resolution to 1 ms while timing sensitive work runs
+    void beginHighResolutionTimer();
+    void endHighResolutionTimer();
+
+    // Desktop queries, return false where no desktop is available
+    bool isEscapePressed();
+    bool isPauseKeyPressed(); // Pause/Break key
+    bool getCursorPosition(int &x, int &y);
+}
+
+#endif // PLATFORM_H
@@ -0,0 +1,170 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+// C++ standard library headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Opcodes of the compiled ClickScript program
+enum class OpCode : uint8_t
+{
+    LEFT_CLICK,
+    RIGHT_CLICK,
+    ENTER_KEY,
+    DELAY,
+    LOOP_NUMBER_KEY,
+    TYPE_TEXT,  // Operand: index into the text table
+    PASTE_TEXT, // Operand: index into the text table, aux PASTE_FROM_FILE if the text is a file path
+    WAIT_FILE,          // Operand: index into the wait table
+    WAIT_FILE_COUNT,    // Operand: index into the wait table
+    WAIT_PIXEL,         // Operand: index into the wait table
+    WAIT_REGION_CHANGE, // Operand: index into the wait table
+    // Control flow, everything from REPEAT on is not counted as an action
+    REPEAT,     // Operand: repeat count, pushes a loop counter (0 skips the body)
+    END_REPEAT, // Operand: address of the first body instruction
+    CALL,       // Operand: entry address of the subroutine
+    RET,        // Return after the calling CALL
+    HALT        // End of the main program, subroutine bodies follow it
+};
+
+// Depth limit of the loop counter and return stacks at run time
+constexpr size_t MAX_NESTING = 64;
+
+// Instruction flags
+enum : uint8_t
+{
+    OPERAND_INLINE = 0x00, // Operand is encoded in the instruction itself
+    OPERAND_POOLED = 0x01  // Operand is an index into the operand pool
+};
+
+// aux of PASTE_TEXT
+constexpr uint16_t PASTE_FROM_FILE = 1;
+
+// What the WAIT_* commands do when the timeout passes
+enum class WaitPolicy : uint8_t
+{
+    CONTINUE, // Go on with the next command
+    SKIP,     // End this round, start the next one
+    STOP      // End the run
+};
+
+// WaitSpec flags
+enum : uint8_t
+{
+    WAIT_LITERAL_DIRECTORY = 0x01, // directory is a path, not a configuration key
+    WAIT_RELATIVE_COUNT = 0x02,    // count is added to the file count at the start of the round
+    WAIT_SCREEN = 0x04             // WAIT_PIXEL / WAIT_REGION_CHANGE, reads the screen instead of a directory
+};
+
+// Operand of the WAIT_* commands, fixed size so the table is cached as is
+struct WaitSpec
+{
+    uint32_t timeoutMs = 0;
+    WaitPolicy policy = WaitPolicy::STOP;
+    uint8_t flags = 0;
+    uint8_t tolerance = 0; // Largest difference per colour channel that still counts as equal (screen waits)
+    uint8_t reserved = 0;
+
+    // WAIT_FILE / WAIT_FILE_COUNT
+    uint32_t directory = 0; // Text table index of the configuration key or path
+    uint32_t pattern = 0;   // Text table index of the file name pattern (WAIT_FILE)
+    uint32_t count = 0;     // File count to reach (WAIT_FILE_COUNT)
+
+    // WAIT_PIXEL / WAIT_REGION_CHANGE
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t width = 1; // Region size, 1x1 for WAIT_PIXEL
+    uint32_t height = 1;
+    uint32_t color = 0; // 0xRRGGBB to wait for (WAIT_PIXEL)
+};
+
+static_assert(sizeof(WaitSpec) == 40, "WaitSpec is written to the cache byte for byte");
+
+// Fixed-width (8 bytes) instruction.
+// Click coordinates are packed as two int16 into the operand when they fit,
+// otherwise the operand indexes two consecutive entries (x, y) of the pool.
+struct Instruction
+{
+    OpCode op = OpCode::HALT;
+    uint8_t flags = OPERAND_INLINE;
+    uint16_t aux = 0; // Reserved for opcode specific data
+    uint32_t operand = 0;
+};
+
+static_assert(sizeof(Instruction) == 8, "Instruction must stay 8 bytes wide");
+
+class Program
+{
+public:
+    // Remove all instructions and pooled operands
+    void clear();
+
+    // Emit instructions, return the index of the emitted instruction
+    size_t emit(OpCode op);
+    size_t emitPoint(OpCode op, int x, int y);
+    size_t emitValue(OpCode op, uint32_t value, uint16_t aux = 0);
+
+    // Change the operand of an emitted instruction (forward CALL targets)
+    void patchOperand(size_t index, uint32_t value) { code[index].operand = value; }
+
+    // Subroutine names by entry address, kept for printing and decompiling
+    struct Symbol
+    {
+        uint32_t address = 0;
+        std::string name;
+    };
+    void addSymbol(uint32_t address, const std::string &name) { symbolTable.push_back({address, name}); }
+    const std::vector<Symbol> &symbols() const { return symbolTable; }
+
+    // Texts as written in the script: TYPE / PASTE operands, WAIT_FILE directories and patterns
+    uint32_t addText(const std::string &text);
+    const std::vector<std::string> &texts() const { return textTable; }
+
+    // WAIT_* parameters, indexed by their operand
+    uint32_t addWait(const WaitSpec &wait);
+    const std::vector<WaitSpec> &waits() const { return waitTable; }
+
+    // Replace the whole program, e.g. with one loaded from a cache file
+    void assign(std::vector<Instruction> instructions, std::vector<int32_t> operands, std::vector<Symbol> symbols,
+                std::vector<std::string> texts, std::vector<WaitSpec> waits);
+
+    // Check opcodes, pool, text and wait references, jump targets and the HALT terminator
+    bool validate() const;
+
+    // Decode the point operand of a click instruction
+    void decodePoint(const Instruction &instruction, int &x, int &y) const
+    {
+        if (instruction.flags & OPERAND_POOLED)
+        {
+            x = pool[instruction.operand];
+            y = pool[instruction.operand + 1];
+        }
+        else
+        {
+            x = static_cast<int16_t>(instruction.operand & 0xFFFF);
+            y = static_cast<int16_t>(instruction.operand >> 16);
+        }
+    }
+
+    const Instruction *data() const { return code.data(); }
+    size_t size() const { return code.size(); }
+    bool empty() const { return code.empty() || code.front().op == OpCode::HALT; }
+    const Instruction &operator[](size_t index) const { return code[index]; }
+
+    const std::vector<Instruction> &instructions() const { return code; }
+    const std::vector<int32_t> &operandPool() const { return pool; }
+
+    // Approximate memory footprint of the program in bytes
+    size_t byteSize() const { return code.size() * sizeof(Instruction) + pool.size() * sizeof(int32_t); }
+
+private:
+    std::vector<Instruction> code;
+    std::vector<int32_t> pool; // Operands that do not fit inline
+    std::vector<Symbol> symbolTable;
+    std::vector<std::string> textTable;
+    std::vector<WaitSpec> waitTable;
+};
+
+#endif // PROGRAM_H
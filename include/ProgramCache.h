@@ -0,0 +1,38 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+// C++ standard library headers
+#include <cstdint>
+#include <string>
+
+// Project local headers
+#include "Program.h"
+
+// Compiled programs are cached next to their script as "<script>c"
+// (task.clk -> task.clkc). The cache header stores the format version and the
+// size, modification time and content hash of the source script; the cache is
+// ignored when any of them no longer matches.
+namespace ProgramCache
+{
+    constexpr uint32_t FORMAT_VERSION = 6;
+
+    std::string cachePathFor(const std::string &scriptPath);
+
+    // Size and modification time of a script
+    struct SourceStamp
+    {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+    bool stamp(const std::string &scriptPath, SourceStamp &stamp);
+
+    // Load the cached program of scriptPath, false if missing or stale
+    bool load(const std::string &scriptPath, Program &program);
+
+    // Write the cache for scriptPath compiled from source. sourceStamp must be taken
+    // before source was read, so an edit in between leaves the cache stale.
+    bool save(const std::string &scriptPath, const SourceStamp &sourceStamp, const std::string &source,
+              const Program &program);
+}
+
+#endif // PROGRAMCACHE_H
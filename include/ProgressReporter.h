@@ -0,0 +1,159 @@
+#ifndef PROGRESSREPORTER_H
+#define PROGRESSREPORTER_H
+
+// C++ standard library headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Project local headers
+#include "ThreadManager.h"
+
+// One observation of the run, derived from the engine counters
+struct ProgressSample
+{
+    int round = 0; // Rounds finished
+    int totalRounds = 0;
+    uint64_t actions = 0;
+    double elapsedSeconds = 0;
+    double roundsPerSecond = 0;
+    double actionsPerSecond = 0; // Since the previous sample
+    double etaSeconds = -1;      // -1 while unknown
+    double lastRoundSeconds = 0;
+};
+
+// Destination for progress samples. All calls come from the reactor thread.
+class ProgressSink
+{
+public:
+    virtual ~ProgressSink() = default;
+
+    virtual const char *name() const = 0;
+    virtual void publish(const ProgressSample &sample) = 0;
+    virtual void finish(const ProgressSample &sample, bool success) { (void)success; publish(sample); }
+    virtual void close() {}
+
+    // True if the final state stays visible until close(), e.g. the taskbar colour
+    virtual bool showsFinalState() const { return false; }
+};
+
+// Console title: "ClickScript - Progress: 12/100 (12.0%) ETA 00:01:23"
+class TitleProgressSink : public ProgressSink
+{
+public:
+    const char *name() const override { return "TITLE"; }
+    void publish(const ProgressSample &sample) override;
+
+private:
+    std::string title; // Reused for every update
+};
+
+// One line per sample on stdout
+class TerminalProgressSink : public ProgressSink
+{
+public:
+    const char *name() const override { return "TERMINAL"; }
+    void publish(const ProgressSample &sample) override;
+    void finish(const ProgressSample &sample, bool success) override;
+
+private:
+    std::string line;
+};
+
+// CSV lines appended to a file: elapsed,round,total,actions,rounds/s,actions/s,eta,last round
+class FileProgressSink : public ProgressSink
+{
+public:
+    explicit FileProgressSink(const std::string &path);
+    const char *name() const override { return "FILE"; }
+    bool isOpen() const { return out.is_open(); }
+    void publish(const ProgressSample &sample) override;
+    void close() override;
+
+private:
+    std::ofstream out;
+};
+
+// Windows taskbar progress bar. COM is initialised on the reactor thread on first use.
+class TaskbarProgressSink : public ProgressSink
+{
+public:
+    ~TaskbarProgressSink() override;
+    const char *name() const override { return "TASKBAR"; }
+    void publish(const ProgressSample &sample) override;
+    void finish(const ProgressSample &sample, bool success) override;
+    void close() override;
+    bool showsFinalState() const override { return available; }
+
+private:
+    bool open();
+
+    bool opened = false;
+    bool available = false;
+#ifdef _WIN32
+    HWND window = nullptr;
+    ITaskbarList3 *taskbar = nullptr;
+#endif
+};
+
+// Create a sink by its configuration name (TASKBAR, TITLE, TERMINAL, FILE), nullptr if unknown
+std::unique_ptr<ProgressSink> createProgressSink(const std::string &name, const std::string &file);
+
+// Samples the engine counters on the reactor thread at a fixed rate and fans the
+// result out to the sinks. The engine only does relaxed stores, so reporting cost
+// does not depend on how short the rounds are.
+class ProgressReporter
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit ProgressReporter(ThreadManager &reactor) : reactor(reactor) {}
+    ~ProgressReporter() { close(); }
+
+    void addSink(std::unique_ptr<ProgressSink> sink);
+    // Add the comma separated sinks of spec, e.g. "TASKBAR,TITLE,TERMINAL"
+    void addSinks(const std::string &spec, const std::string &file);
+    bool empty() const { return sinks.empty(); }
+    bool showsFinalState() const;
+
+    // Start sampling actions every interval, until finish()
+    void begin(int totalRounds, const std::atomic<uint64_t> *actions, std::chrono::milliseconds interval);
+
+    // Called by the round loop, a clock read and relaxed stores
+    void roundFinished(int round);
+
+    // Publish the final sample; close() then clears the sinks and releases them
+    void finish(bool success);
+    void close();
+
+private:
+    ProgressSample sample(); // Reactor thread only
+    void tick();
+    void runOnReactor(const std::function<void()> &work); // Run work there and wait for it
+
+    ThreadManager &reactor;
+    std::vector<std::unique_ptr<ProgressSink>> sinks; // Used on the reactor thread once begin() ran
+    int timerId = 0;
+    bool closed = true;
+
+    // Written by the round loop
+    const std::atomic<uint64_t> *actionCounter = nullptr;
+    std::atomic<int> roundsDone{0};
+    std::atomic<int64_t> lastRoundNs{0};
+    clock::time_point roundEnd;
+
+    // Reactor thread only
+    int totalRounds = 0;
+    clock::time_point start;
+    clock::time_point previousTime;
+    uint64_t previousActions = 0;
+    int publishedRound = -1;
+    uint64_t publishedActions = 0;
+};
+
+#endif // PROGRESSREPORTER_H
@@ -0,0 +1,162 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+// C++ standard library headers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Bounded lock-free queue for many producers and a single consumer.
+// Every slot carries a sequence number telling whether it is free for the
+// producer of a given position or filled for the consumer (Vyukov's design).
+// The capacity is rounded up to a power of two.
+template <typename T>
+class MpscRingBuffer
+{
+public:
+    explicit MpscRingBuffer(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        slots = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRingBuffer(const MpscRingBuffer &) = delete;
+    MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+    // Producer side, return false when the buffer is full
+    bool tryPush(T &&value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // Full
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, return false when the buffer is empty
+    bool tryPop(T &value)
+    {
+        Slot &slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+            return false;
+        value = std::move(slot.value);
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    // Consumer side
+    bool empty() const { return slots[head & mask].sequence.load(std::memory_order_acquire) != head + 1; }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> tail{0}; // Next position to produce
+    alignas(64) size_t head = 0;             // Next position to consume, owned by the consumer
+};
+
+// Bounded lock-free queue for one producer and one consumer. Each side keeps a
+// cached copy of the other's index and only reloads it when the queue looks full
+// or empty. The wait functions block on the index with std::atomic::wait, so an
+// idle side sleeps instead of spinning. The capacity is rounded up to a power of two.
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        slots = std::make_unique<T[]>(size);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    // Producer side, return false when the buffer is full
+    bool tryPush(T &&value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        if (pos - cachedHead > mask)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (pos - cachedHead > mask)
+                return false; // Full
+        }
+        slots[pos & mask] = std::move(value);
+        tail.store(pos + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    // Consumer side, return false when the buffer is empty
+    bool tryPop(T &value)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        if (pos == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (pos == cachedTail)
+                return false; // Empty
+        }
+        value = std::move(slots[pos & mask]);
+        head.store(pos + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    // Producer side, after tryPush failed: sleep until the consumer pops
+    void waitForSpace() const { head.wait(tail.load(std::memory_order_relaxed) - mask - 1, std::memory_order_acquire); }
+
+    // Consumer side, after tryPop failed: sleep until the producer pushes
+    void waitForData() const { tail.wait(head.load(std::memory_order_relaxed), std::memory_order_acquire); }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> tail{0}; // Next position to produce
+    size_t cachedHead = 0;                   // Producer's view of head
+    alignas(64) std::atomic<size_t> head{0}; // Next position to consume
+    size_t cachedTail = 0;                   // Consumer's view of tail
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,73 @@
+#ifndef ROUNDVERIFIER_H
+#define ROUNDVERIFIER_H
+
+// C++ standard library headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs the post-round checks on a worker thread so they overlap with the next
+// rounds. Finished rounds wait in a bounded queue; the barrier policy decides
+// when the round loop has to wait for the worker.
+class RoundVerifier
+{
+public:
+    // Check round and fix what is wrong, return true if a discrepancy was found
+    using Hook = std::function<bool(int round)>;
+
+    enum class Barrier
+    {
+        NEVER,         // Only wait when the queue is full
+        LAG,           // Round N is verified before round N + lag starts
+        ON_DISCREPANCY // Wait for the queue to drain after a discrepancy was found
+    };
+
+    // Parse NEVER / LAG / DISCREPANCY, LAG if unknown
+    static Barrier parseBarrier(const std::string &name);
+    static const char *barrierName(Barrier barrier);
+
+    RoundVerifier(Hook hook, size_t queueSize, Barrier barrier, int lag);
+    ~RoundVerifier();
+
+    RoundVerifier(const RoundVerifier &) = delete;
+    RoundVerifier &operator=(const RoundVerifier &) = delete;
+
+    // Round loop: apply the barrier before round starts, queue round once it is done
+    void beforeRound(int round);
+    void submit(int round);
+
+    // Verify everything queued and stop the worker
+    void finish();
+
+    int verifiedRounds() const;
+    uint64_t discrepancies() const;
+    std::chrono::nanoseconds barrierWait() const { return waited; } // Time the round loop spent waiting
+
+private:
+    void workerLoop();
+
+    Hook hook;
+    size_t capacity;
+    Barrier barrier;
+    int lag;
+
+    mutable std::mutex mtx;
+    std::condition_variable queued;   // Worker waits for rounds
+    std::condition_variable verified; // Round loop waits for progress
+    std::deque<int> pending;
+    bool busy = false;                // Worker is inside hook
+    bool stopping = false;
+    bool discrepancyPending = false;  // ON_DISCREPANCY: next round must wait
+    int lastVerified = 0;
+    uint64_t discrepancyCount = 0;
+    std::chrono::nanoseconds waited{0}; // Round loop only
+
+    std::thread worker;
+};
+
+#endif // ROUNDVERIFIER_H
@@ -0,0 +1,112 @@
+#ifndef SCREENSOURCE_H
+#define SCREENSOURCE_H
+
+// C++ standard library headers
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Project local headers
+#include "Platform.h"
+
+// Captured screen rectangle, one BGRA pixel (0xAARRGGBB) per uint32_t,
+// rows top to bottom without padding
+struct Frame
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+
+    uint32_t at(int x, int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+};
+
+// Screen pixels read by WAIT_PIXEL / WAIT_REGION_CHANGE
+class ScreenSource
+{
+public:
+    virtual ~ScreenSource() = default;
+
+    // Source name as used in the configuration file
+    virtual const char *name() const = 0;
+
+    // Copy the rectangle at (x, y) into frame, false if it is off the screen or can not be read
+    virtual bool capture(int x, int y, int width, int height, Frame &frame) = 0;
+};
+
+#ifdef _WIN32
+// The desktop through GDI. The memory DC and bitmap are kept for the next
+// capture of the same size.
+class GdiScreenSource : public ScreenSource
+{
+public:
+    GdiScreenSource() = default;
+    ~GdiScreenSource() override;
+
+    GdiScreenSource(const GdiScreenSource &) = delete;
+    GdiScreenSource &operator=(const GdiScreenSource &) = delete;
+
+    const char *name() const override { return "GDI"; }
+    bool capture(int x, int y, int width, int height, Frame &frame) override;
+
+private:
+    void releaseBitmap();
+
+    HDC screenDc = nullptr;
+    HDC memoryDc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ previous = nullptr;
+    void *bits = nullptr; // Top-down 32-bit DIB section
+    int bitmapWidth = 0;
+    int bitmapHeight = 0;
+};
+#endif
+
+// Framebuffer in memory, for headless runs and benchmarks. It may be drawn
+// from another thread while a script waits on it.
+class MemoryScreenSource : public ScreenSource
+{
+public:
+    explicit MemoryScreenSource(int width = 0, int height = 0, uint32_t color = 0xFF000000);
+
+    const char *name() const override { return "MEMORY"; }
+    bool capture(int x, int y, int width, int height, Frame &frame) override;
+
+    // Paint a rectangle, clipped to the framebuffer
+    void fill(int x, int y, int width, int height, uint32_t color);
+    void setPixel(int x, int y, uint32_t color) { fill(x, y, 1, 1, color); }
+
+private:
+    std::mutex mtx;
+    Frame screen;
+};
+
+// Screen read from a binary PPM (P6, maxval 255) file, loaded again whenever
+// the file changes, so another process can play the UI by rewriting it
+class PpmScreenSource : public ScreenSource
+{
+public:
+    explicit PpmScreenSource(const std::string &path) : path(path) {}
+
+    const char *name() const override { return "PPM"; }
+    bool capture(int x, int y, int width, int height, Frame &frame) override;
+
+    // Decode a P6 image, false with a log message if it is malformed
+    static bool decode(const std::string &data, Frame &frame);
+
+private:
+    std::string path;
+    Frame screen;
+    std::filesystem::file_time_type loadedTime{}; // Stamp of the last version read
+    uintmax_t loadedSize = 0;
+    bool loaded = false; // screen holds a decoded image
+};
+
+// Create a source by configuration name (GDI, MEMORY, PPM). PPM reads file.
+// An empty or unknown name selects the platform default: GDI on Windows,
+// otherwise PPM when a file is given and MEMORY without.
+std::shared_ptr<ScreenSource> createScreenSource(const std::string &name = "", const std::string &file = "");
+
+#endif // SCREENSOURCE_H
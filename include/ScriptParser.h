@@ -0,0 +1,81 @@
+#ifndef SCRIPTPARSER_H
+#define SCRIPTPARSER_H
+
+// C++ standard library headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Command keywords of the .clk language
+enum class Keyword : uint8_t
+{
+    UNKNOWN,
+    LEFT,
+    RIGHT,
+    DELAY,
+    ENTER,
+    LOOP_NUMBER_KEY,
+    TYPE,   // TYPE "text"
+    PASTE,  // PASTE "text" or PASTE FILE "path"
+    WAIT_FILE,       // WAIT_FILE dir "pattern" timeout [policy]
+    WAIT_FILE_COUNT, // WAIT_FILE_COUNT dir [+]count timeout [policy]
+    WAIT_PIXEL,         // WAIT_PIXEL x y RRGGBB tolerance timeout [policy]
+    WAIT_REGION_CHANGE, // WAIT_REGION_CHANGE x y width height tolerance timeout [policy]
+    REPEAT, // REPEAT n ... END
+    SUB,    // SUB name ... END
+    CALL,   // CALL name
+    END
+};
+
+// Map a command word to its keyword without building a string
+Keyword lookupKeyword(std::string_view word);
+
+// Parse problem located in the script, line and column are 1-based
+struct ScriptError
+{
+    size_t line = 0;
+    size_t column = 0;
+    std::string message;
+
+    // "file:line:column: message"
+    std::string toString(const std::string &filename) const;
+};
+
+// Splits one script line into whitespace separated tokens, all views into the line
+class LineTokenizer
+{
+public:
+    explicit LineTokenizer(std::string_view line) : text(line) {}
+
+    // Next token, false at the end of the line
+    bool next(std::string_view &token);
+
+    // Next token as a decimal integer, false if missing or not a number
+    bool nextInt(int &value);
+
+    // Next token as a double-quoted string with the escapes \" \\ \n \t decoded,
+    // false if missing, unterminated or holding another escape
+    bool nextQuoted(std::string &value);
+
+    // True when only whitespace is left
+    bool atEnd();
+
+    // 1-based column of the last token returned (or of the end of the line)
+    size_t column() const { return tokenStart + 1; }
+
+private:
+    void skipSpace();
+
+    std::string_view text;
+    size_t pos = 0;
+    size_t tokenStart = 0;
+};
+
+// Remove leading and trailing blanks (space, tab, CR)
+std::string_view trimLine(std::string_view line);
+
+// Read the whole file into content with a single bulk read
+bool readWholeFile(const std::string &filename, std::string &content);
+
+#endif // SCRIPTPARSER_H
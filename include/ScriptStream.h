@@ -0,0 +1,102 @@
+#ifndef SCRIPTSTREAM_H
+#define SCRIPTSTREAM_H
+
+// C++ standard library headers
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Project local headers
+#include "RingBuffer.h"
+#include "ScriptParser.h"
+#include "clickscript.h"
+
+// Reads the #start ... #end block of a script on a parser thread and hands the
+// decoded actions to the executing thread through a bounded SPSC queue, so memory
+// use does not depend on the script size and the first action is ready as soon
+// as its line is parsed. Every pass re-reads the file from the line after #start;
+// the parser runs one pass ahead, so the next round starts from a filled queue.
+//
+// REPEAT bodies are not buffered: the parser keeps a counter and the file offset
+// of the body per open REPEAT and reads the body again for every repetition.
+//
+// Commands a stream rejects, failing at their line:
+// - SUB / CALL: a CALL may come before its SUB, which the parser has not read yet
+// - TYPE / PASTE: their texts live in the text table of a loaded script
+// - WAIT_FILE / WAIT_FILE_COUNT / WAIT_PIXEL / WAIT_REGION_CHANGE: their settings
+//   live in the wait table of a loaded script
+class ScriptStream
+{
+public:
+    // Fills behavior, false if the line is invalid, with the problems added to errors.
+    // report is false on every pass after the first, which sees the same problems again.
+    using LineParser = std::function<bool(std::string_view line, size_t lineNumber, bool report, Behavior &behavior,
+                                          std::vector<ScriptError> &errors)>;
+
+    enum class Next
+    {
+        ACTION,      // behavior holds the next action
+        END_OF_PASS, // The round is complete, the following call starts the next pass
+        FAILED       // Unreadable file, invalid line or structure error
+    };
+
+    // queueSize is in actions. parse is called on the parser thread.
+    ScriptStream(std::string path, size_t queueSize, LineParser parse);
+    ~ScriptStream();
+
+    ScriptStream(const ScriptStream &) = delete;
+    ScriptStream &operator=(const ScriptStream &) = delete;
+
+    // Find the #start marker, false if the file can not be read or has none
+    bool open();
+
+    // Next action of the current pass, blocks while the parser is behind
+    Next next(Behavior &behavior);
+
+    // Stop the parser thread and drop what it read ahead
+    void stop();
+
+    // Problems that made the last next() return FAILED, consumer thread only
+    const std::vector<ScriptError> &errors() const { return failure; }
+
+    const std::string &path() const { return filePath; }
+    uint64_t passesParsed() const { return passes.load(std::memory_order_relaxed); }
+
+private:
+    // Actions travel in batches, one queue hand-off (and at most one wake-up) per batch
+    static constexpr size_t BATCH_ACTIONS = 64;
+    struct Entry
+    {
+        Next kind = Next::ACTION;
+        uint32_t count = 0; // Actions in batch, only for ACTION
+        std::array<Behavior, BATCH_ACTIONS> batch;
+        std::vector<ScriptError> errors; // Only for FAILED
+    };
+
+    void parserLoop();
+    bool parsePass(bool reportErrors, std::vector<ScriptError> &errors); // false on failure or stop
+    bool push(Entry &&entry);           // false once stopped
+    bool pushAction(const Behavior &b); // Add to the pending batch, hand it over when full
+    bool flushBatch();                  // Hand over a partly filled batch
+
+    std::string filePath;
+    LineParser parse;
+    SpscRingBuffer<Entry> queue;
+    Entry pending; // Batch being filled, parser thread only
+    Entry current; // Batch being executed, consumer only
+    std::vector<ScriptError> failure; // Consumer only
+    size_t currentIndex = 0;
+    std::thread parser;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> passes{0};
+    std::streamoff startOffset = -1; // First byte after the #start line
+    size_t startLine = 0;            // Line number of #start
+};
+
+#endif // SCRIPTSTREAM_H
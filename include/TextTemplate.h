@@ -0,0 +1,80 @@
+#ifndef TEXTTEMPLATE_H
+#define TEXTTEMPLATE_H
+
+// C++ standard library headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project local headers
+#include "InputBackend.h"
+
+// Text of a TYPE or PASTE command, compiled once.
+//
+// Placeholders: {loop} (round number, from 1), {round_start_time} (HH:MM:SS
+// when the round started) and {config:Key} (value from the configuration).
+// {{ and }} type a literal brace. For TYPE, literal text and config values
+// become ready key events at compile time; only {loop} and {round_start_time}
+// are turned into keys while running. PASTE text is kept as a string and may
+// hold any character.
+class TextTemplate
+{
+public:
+    enum class Output : uint8_t
+    {
+        KEYS, // appendTo(), characters must have a key
+        TEXT  // expand()
+    };
+
+    // Values of the run-time placeholders
+    struct Context
+    {
+        int loop = 0;
+        std::string_view roundStartTime;
+    };
+
+    // Value of {config:Key}, false if the key is not set
+    using ConfigLookup = std::function<bool(const std::string &key, std::string &value)>;
+
+    // Build the key events or text of source. Without config, config placeholders are only
+    // checked. False on a syntax error or, for KEYS, a character without a key, with the
+    // message and the offset of the problem in source.
+    bool compile(std::string_view source, const ConfigLookup &config, std::string &message, size_t &offset,
+                 Output output = Output::KEYS);
+
+    // Queue the keys that type the text (KEYS)
+    void appendTo(InputBatch &batch, const Context &context) const;
+
+    // Append the text with the placeholders filled in (TEXT)
+    void expand(std::string &out, const Context &context) const;
+
+    bool usesRoundStartTime() const { return needsRoundStartTime; }
+
+    // Local wall-clock time as HH:MM:SS
+    static std::string formatClock(std::chrono::system_clock::time_point time);
+
+private:
+    enum class PieceKind : uint8_t
+    {
+        LITERAL,         // [begin, begin + count) of keys or of text
+        LOOP,            // {loop}
+        ROUND_START_TIME // {round_start_time}
+    };
+    struct Piece
+    {
+        PieceKind kind = PieceKind::LITERAL;
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+
+    std::vector<Piece> pieces;
+    InputBatch keys;  // Key events of all literal runs (KEYS)
+    std::string text; // All literal runs (TEXT)
+    bool needsRoundStartTime = false;
+};
+
+#endif // TEXTTEMPLATE_H
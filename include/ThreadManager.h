@@ -4,40 +4,100 @@
 // C++ standard library headers
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <string>
 #include <thread>
-
-// System-specific headers
-#include <windows.h>
+#include <vector>
 
 // Project local headers
+#include "CancellationToken.h"
 #include "MyLogger.h"
+#include "Platform.h"
 
+// Single reactor thread for everything that happens beside the engine:
+// hotkeys, timers (progress sampling), posted work and native handle notifications.
+// It blocks on epoll (Linux) or MsgWaitForMultipleObjects (Windows) and
+// only wakes when something is due, so an idle reactor costs no CPU.
 class ThreadManager
 {
 public:
-    static ThreadManager &getInstance();
-
-    // Emergency stop control
-    void setEmergencyStop(bool stop);
-    bool isEmergencyStop() const;
+    using clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+#ifdef _WIN32
+    using NativeHandle = HANDLE; // Waitable object
+#else
+    using NativeHandle = int; // Pollable file descriptor
+#endif
+
+    // Consolidated state of the current run
+    enum class RunState : uint8_t
+    {
+        IDLE,
+        COUNTDOWN,
+        RUNNING,
+        PAUSED,
+        STOPPING,
+        STOPPED,
+        FINISHED
+    };
+
+    enum class Hotkey : uint8_t
+    {
+        ESCAPE,
+        PAUSE
+    };
+
+    struct RunStatus
+    {
+        RunState state;
+        int current;
+        int total;
+    };
 
-    // Running state
-    void setRunning(bool running);
+    static ThreadManager &getInstance();
+    static const char *runStateName(RunState state);
+
+    // Reactor lifetime, stop() joins the thread after the current dispatch
+    bool start();
+    void stop();
+    bool isStarted() const { return reactorThread.joinable(); }
+
+    // Run state. beginRun() arms the hotkeys for token, endRun() disarms them.
+    void beginRun(CancellationToken *token, int total);
+    void endRun(RunState finalState);
+    void setRunState(RunState state);
+    RunState getRunState() const { return runState.load(); }
+    RunStatus status() const;
     bool isRunning() const;
+    bool isEmergencyStop() const;
 
-    // Progress information
+    // Progress information, plain relaxed stores; ProgressReporter samples and publishes it
     void setProgress(int current, int total);
-    int getCurrentProgress() const;
-    int getTotalProgress() const;
+    int getCurrentProgress() const { return currentProgress.load(); }
+    int getTotalProgress() const { return totalProgress.load(); }
 
-    // Thread management
-    void startEmergencyListener();
-    void stopEmergencyListener();
+    // Handle a hotkey as if it was pressed, from any thread
+    void onHotkey(Hotkey key);
 
-    // Reset state
-    void reset();
+    // Timers, callbacks run on the reactor thread. Return an id for cancelTimer().
+    int addTimer(std::chrono::milliseconds interval, Callback callback, bool repeat = true);
+    void cancelTimer(int id);
+
+    // Call callback on the reactor thread whenever handle becomes signalled / readable.
+    // The callback must consume the notification (e.g. read the fd), otherwise it fires again.
+    // The caller keeps ownership of handle and must remove it before closing it.
+    int addHandle(NativeHandle handle, Callback callback);
+    void removeHandle(int id);
+
+    // Run callback once on the reactor thread
+    void post(Callback callback);
+
+    // Wait until every callback running or posted so far has finished. Returns at
+    // once when the reactor is not started or when called on the reactor thread.
+    void sync();
 
 private:
     ThreadManager() = default;
@@ -46,20 +106,58 @@ private:
     ThreadManager(const ThreadManager &) = delete;
     ThreadManager &operator=(const ThreadManager &) = delete;
 
-    // Emergency stop listener thread
-    void emergencyListenerThread();
-
-    // Atomic variables
-    std::atomic<bool> emergencyStop{false};
-    std::atomic<bool> isRunningState{false};
+    struct Timer
+    {
+        int id;
+        clock::time_point deadline;
+        std::chrono::milliseconds interval;
+        Callback callback;
+        bool repeat;
+    };
+
+    struct Watch
+    {
+        int id;
+        NativeHandle handle;
+        Callback callback;
+    };
+
+    // Reactor thread
+    void reactorLoop();
+    void wake();
+    int nextTimeoutMs();
+    void runDueTimers();
+    void runPosted();
+    void dispatchHandle(int id);
+    void updateHotkeys();
+    void pollHotkeys();
+
+    // Consolidated run state
+    std::atomic<RunState> runState{RunState::IDLE};
     std::atomic<int> currentProgress{0};
     std::atomic<int> totalProgress{0};
-
-    // Thread management
-    std::thread emergencyThread;
-    std::atomic<bool> shouldStopListener{false};
-
-    mutable std::mutex mtx;
+    std::atomic<CancellationToken *> runToken{nullptr};
+
+    // Reactor thread state
+    std::thread reactorThread;
+    std::atomic<bool> quit{false};
+    std::atomic<bool> hotkeysWanted{false};
+    bool hotkeysArmed = false;   // Reactor thread only
+    int hotkeyPollTimer = 0;     // Fallback polling when hotkeys cannot be registered
+    bool pauseKeyDown = false;   // Edge detection for the polling fallback
+
+    mutable std::mutex mtx; // Guards timers, watches and posted
+    std::vector<Timer> timers;
+    std::vector<Watch> watches;
+    std::vector<Callback> posted;
+    int nextId = 1;
+
+#ifdef _WIN32
+    HANDLE wakeEvent = nullptr;
+#else
+    int epollFd = -1;
+    int wakeFd = -1;
+#endif
 };
 
-#endif // THREADMANAGER_H
\ No newline at end of file
+#endif // THREADMANAGER_H
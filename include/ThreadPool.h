@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// C++ standard library headers
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. The workers stay alive
+// between calls, so a check repeated every round does not create threads.
+class ThreadPool
+{
+public:
+    // threads <= 0 uses one thread per hardware core
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Call body(i) for every i in [0, count) on the workers and wait for all of them.
+    // The calling thread helps, so nested or concurrent calls can not deadlock.
+    void parallelFor(size_t count, const std::function<void(size_t)> &body);
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t)> *body = nullptr;
+        size_t count = 0;
+        size_t next = 0;     // Next index to hand out
+        size_t finished = 0; // Indices done
+    };
+
+    void workerLoop();
+    bool runOne(std::unique_lock<std::mutex> &lock, Job &job); // mtx held on entry and exit
+
+    std::mutex mtx;
+    std::condition_variable wakeWorkers;
+    std::condition_variable jobDone;
+    std::vector<Job *> jobs; // Jobs with indices left to hand out
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // THREADPOOL_H
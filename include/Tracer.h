@@ -0,0 +1,123 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+// C++ standard library headers
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Optional timeline of a run written as Chrome trace-event JSON (open it in
+// Perfetto or chrome://tracing). Every thread appends complete spans to its own
+// buffer without locking; the buffers are only read when the trace is written.
+// While tracing is off, instrumented code pays one relaxed load and a branch.
+//
+// Names, categories and argument names must be string literals, only the pointers
+// are stored.
+class Tracer
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static Tracer &getInstance();
+
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    // Drop the previous trace and start recording
+    void start();
+    void stop();
+
+    // Record a finished span on the calling thread
+    void complete(const char *category, const char *name, clock::time_point begin, clock::time_point end,
+                  const char *argName = nullptr, int64_t arg = 0);
+
+    // Name shown for the calling thread, e.g. "engine" or "verifier"
+    static void setThreadName(const char *name);
+
+    // Write everything recorded since start(), false if path can not be written
+    bool write(const std::string &path) const;
+
+    uint64_t eventCount() const;
+    uint64_t droppedEvents() const; // Events beyond the per-thread capacity
+
+private:
+    struct Event
+    {
+        const char *category;
+        const char *name;
+        const char *argName;
+        int64_t arg;
+        int64_t beginNs; // steady_clock time since its epoch
+        int64_t durationNs;
+    };
+
+    // Written only by its thread, which also resets it when it first records in a new
+    // generation; count is published with release so the writer sees complete events.
+    // Chunks are allocated on demand and kept for reuse.
+    struct ThreadBuffer
+    {
+        static constexpr size_t CHUNK_EVENTS = 4096;
+        static constexpr size_t MAX_CHUNKS = 1024; // ~4M events per thread
+
+        ~ThreadBuffer();
+
+        std::array<std::atomic<Event *>, MAX_CHUNKS> chunks{};
+        std::atomic<size_t> count{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> generation{0}; // start() the count belongs to
+        std::atomic<bool> retired{false};    // Thread has exited
+        uint32_t tid = 0;
+        std::string threadName;
+    };
+
+    friend struct TracerRegistration;
+
+    Tracer() = default;
+    ThreadBuffer &threadBuffer();
+    bool isCurrent(const ThreadBuffer &buffer) const; // Recorded since the last start()
+
+    static std::atomic<bool> active;
+
+    mutable std::mutex mtx; // Guards the buffer list and thread names, never taken per event
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid = 1;
+    std::atomic<uint64_t> generation{0}; // Bumped by start(), published after epochNs
+    std::atomic<int64_t> epochNs{0};     // steady_clock time of the last start()
+};
+
+// Span from construction to destruction, recorded only if tracing was on at construction
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const char *name, const char *argName = nullptr, int64_t arg = 0)
+        : category(category), name(name), argName(argName), arg(arg), recording(Tracer::enabled())
+    {
+        if (recording)
+            begin = Tracer::clock::now();
+    }
+    ~TraceSpan()
+    {
+        if (recording)
+            Tracer::getInstance().complete(category, name, begin, Tracer::clock::now(), argName, arg);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void setArg(int64_t value) { arg = value; }
+    void cancel() { recording = false; } // Nothing worth showing happened
+
+private:
+    const char *category;
+    const char *name;
+    const char *argName;
+    int64_t arg;
+    bool recording;
+    Tracer::clock::time_point begin;
+};
+
+#endif // TRACER_H
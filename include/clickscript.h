@@ -2,17 +2,37 @@
 #define CLICKSCRIPT_H
 
 // C++ standard library headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
-// System-specific headers
-#include <windows.h> // For Windows API functions like SetCursorPos and mouse_event
-
 // Project local headers
+#include "CancellationToken.h"
+#include "ClipboardBackend.h"
+#include "Config.h"
+#include "DelayScheduler.h"
+#include "DirectoryIndex.h"
+#include "InputBackend.h"
+#include "LatencyHistogram.h"
 #include "MyLogger.h"
+#include "Platform.h"
+#include "Program.h"
+#include "ProgramCache.h"
+#include "ScreenSource.h"
+#include "ScriptParser.h"
+#include "TextTemplate.h"
+#include "Tracer.h"
 #include "system.h"
 
 // For file operations
@@ -27,6 +47,16 @@ typedef enum
     ENTER_KEY,
     DELAY,
     LOOP_NUMBER_KEY,
+    TYPE_TEXT,    // TYPE "text"
+    PASTE_TEXT,   // PASTE "text" or PASTE FILE "path"
+    WAIT_FILE,       // WAIT_FILE dir "pattern" timeout [policy]
+    WAIT_FILE_COUNT, // WAIT_FILE_COUNT dir [+]count timeout [policy]
+    WAIT_PIXEL,         // WAIT_PIXEL x y RRGGBB tolerance timeout [policy]
+    WAIT_REGION_CHANGE, // WAIT_REGION_CHANGE x y width height tolerance timeout [policy]
+    REPEAT_BEGIN, // REPEAT count
+    SUB_BEGIN,    // SUB name, definition of a subroutine
+    BLOCK_END,    // END of the innermost REPEAT or SUB
+    CALL_SUB,     // CALL name
     NONE
 } Action;
 
@@ -42,26 +72,115 @@ typedef struct
     char key = -1; // Key to simulate click
     int delay = -1;
     bool loop_number_input = false; // True if stimulate loop number keyboard input
+    int count = 0;                  // REPEAT count
+    int sub = -1;                   // Subroutine index for SUB and CALL
+    int end = -1;                   // Index of the matching END for REPEAT and SUB
+    int text = -1;                  // Text index for TYPE and PASTE
+    bool from_file = false;         // PASTE FILE, the text is a file path
+    int wait = -1;                  // Wait index for the WAIT_* commands
+    int line = 0;                   // Script line, for error messages
 
     Action action = NONE;
 } Behavior;
 
+class ScriptStream;
+
 class ClickScript
 {
 public:
     ClickScript();
+    ~ClickScript();
     void addBehavior(const Behavior &behavior);
     void removeBehavior(int index);
-    void execute();
+    void execute();          // Run the compiled program
+    void executeReference(); // Interpret the behaviors list directly (reference path)
+    void compile();          // Lower the behaviors list into the compiled program
+    void decompile();        // Rebuild the behaviors list from the compiled program
+    bool verifyProgram();    // Cross-check the compiled program against the behaviors list
     void assert_behavior();
     void save_ClickScript_tofile(const std::string &filename);
     void load_ClickScript_fromfile(const std::string &filename);
+    // Alternative to loading: execute() reads the script from disk on a parser thread
+    // every round, memory use does not grow with the script (see ScriptStream)
+    bool openStream(const std::string &filename, size_t queueSize = 4096);
+    bool isStreaming() const { return stream != nullptr; }
+    bool streamFailed() const { return streamError; } // Structure error or read failure while streaming
+    // A WAIT_* command with the STOP policy timed out, or its directory or screen is unusable
+    bool runAborted() const { return !abortReason.empty(); }
+    const std::string &getAbortReason() const { return abortReason; }
     void print_ClickScript();
     int get_loops();
-    Behavior parseCommandLine(const std::string &line);
+    void set_loops(int n) { loops = n; } // Non-interactive alternative to get_loops
+    Behavior parseCommandLine(std::string_view line, size_t lineNumber = 0);
+    const std::vector<ScriptError> &getErrors() const { return errors; } // Problems found by the last load
     int count_FilesInPath(const std::string &path);
     void deleteLatestFileInPath(const std::string &path);
 
+    const Program &getProgram() const { return program; }
+
+    // Use and refresh the compiled .clkc cache next to the script (on by default)
+    void setCacheEnabled(bool enabled) { cacheEnabled = enabled; }
+
+    // Source of the {config:Key} values in TYPE texts, read when a script is loaded
+    void setConfig(const Config *settings) { config = settings; }
+
+    // Input backend used by the simulate functions
+    void setInputBackend(std::shared_ptr<InputBackend> backend) { input = std::move(backend); }
+    InputBackend &getInputBackend() { return *input; }
+
+    // Clipboard used by PASTE. What it held before is put back once a paste has had
+    // settle time to be read by the target, at the next DELAY or round end after that.
+    void setClipboard(std::shared_ptr<ClipboardBackend> backend) { clipboard = std::move(backend); }
+    void setPasteSettleTime(std::chrono::milliseconds settle) { pasteSettle = settle; }
+
+    // Screen read by WAIT_PIXEL / WAIT_REGION_CHANGE. Polling starts at minInterval, every
+    // miss doubles the interval up to maxInterval, and it stays above four times the time
+    // a capture takes.
+    void setScreenSource(std::shared_ptr<ScreenSource> source) { screen = std::move(source); }
+    void setScreenPolling(std::chrono::milliseconds minInterval, std::chrono::milliseconds maxInterval)
+    {
+        screenPollMin = minInterval;
+        screenPollMax = std::max(minInterval, maxInterval);
+    }
+    // Restore the clipboard now, waiting out the settle time of the last paste
+    void restoreClipboard();
+
+    // Number of actions executed since the last reset. Only the engine writes it,
+    // with relaxed stores, so a progress reporter can sample it from another thread.
+    uint64_t getExecutedActions() const { return executed_actions.load(std::memory_order_relaxed); }
+    void resetExecutedActions() { executed_actions.store(0, std::memory_order_relaxed); }
+    const std::atomic<uint64_t> &executedActionsCounter() const { return executed_actions; }
+
+    // Dry run of rounds on a virtual clock: DELAY advances simulated time instead of
+    // sleeping and input goes to timeline (recorded with simulated timestamps) or is dropped
+    struct SimulationReport
+    {
+        bool valid = false; // Parsed without errors and compiled to a non-empty program
+        int rounds = 0;
+        uint64_t actions = 0;
+        uint64_t events = 0; // Input events, only counted with a timeline
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds minRound{0};
+        std::chrono::nanoseconds maxRound{0};
+        double wallSeconds = 0; // Real time the simulation took
+    };
+    SimulationReport simulate(int rounds, std::shared_ptr<RecordingInputBackend> timeline = nullptr);
+
+    // Monotonic timing of every action and every completed round, on by default.
+    // Dry runs on the virtual clock are never timed.
+    void setTimingEnabled(bool enabled) { timingEnabled = enabled; }
+    void resetTimings();
+    // Table of the per-action, per-round and DELAY error histograms
+    void reportTimings(std::ostream &out) const;
+    // Same histograms as JSON in nanoseconds, false if path can not be written
+    bool writeTimingReport(const std::string &path, int rounds) const;
+
+    // Stop / pause requests checked before every action and inside every DELAY
+    void setCancellationToken(CancellationToken *cancellation) { token = cancellation; }
+
+    // Deadline scheduler used by DELAY, holds the measured jitter
+    DelayScheduler &getScheduler() { return scheduler; }
+
     int getCurrentLoop() const { return current_loop; }
     void setCurrentLoop(int x) { current_loop = x; }
 
@@ -71,12 +190,115 @@ public:
     void simulateEnterKey(const char &key);
     void simulateDelay(int delay);
     void stimulateLoopNumberInput();
+    void simulateTyping(int text);
+    void simulatePaste(int text, bool fromFile);
+    void simulateWait(int wait, bool countFiles);
+    void simulateScreenWait(int wait, bool regionChange);
+
+    // Submit the input queued since the last flush as one batch
+    void flushInput();
 
 private:
+    // True if execution must stop now; a pause blocks in here until resumed
+    bool interrupted() { return token && token->state() != CancellationToken::State::RUNNING && !handleInterrupt(); }
+    bool handleInterrupt();
+
+    void executeProgram(); // Compiled program loop of execute()
+    void executeStream();  // Streaming loop of execute()
+    LatencyHistogram::Named namedTimings() const;
+
+    // The start of an action ends the previous one, one timestamp per action feeds
+    // both the timing histograms and the trace
+    static constexpr size_t NO_TIMED_ACTION = SIZE_MAX;
+    struct ActionMark
+    {
+        std::chrono::steady_clock::time_point start;
+        size_t action = NO_TIMED_ACTION; // Opcode of the action in progress
+        uint32_t operand = 0;
+        uint64_t pauses = 0;
+        bool traced = false;
+    };
+    void markAction(size_t next, uint32_t operand);
+
+    // Record a parse problem at line:column and log it
+    void reportError(size_t lineNumber, size_t column, std::string message);
+
+    // Structure handling for REPEAT / SUB / CALL
+    int subroutineIndex(std::string_view name);
+    void appendLinked(Behavior behavior);                     // Add a behavior and match REPEAT / SUB with END
+    void finishStructure();                                   // Close open blocks, check CALL targets and recursion
+    void compileRange(size_t begin, size_t end, std::vector<std::pair<size_t, int>> &calls);
+    void executeRange(size_t begin, size_t end);              // Reference interpreter for a range of behaviors
+    void canonicalBehaviors(std::vector<Behavior> &out) const; // Main program first, then subroutines
+    void decompileTo(std::vector<Behavior> &out, std::vector<std::string> &names) const;
+    void bindTexts(); // Compile the TYPE texts into key events, the PASTE texts and WAIT_FILE patterns
+    TextTemplate::Context textContext(bool needsTime);
+    void restoreClipboardIfSettled();
+    bool beginWaitRound(); // Open the WAIT_FILE directories once, note the file counts of this round
+    void waitTimedOut(const WaitSpec &wait, const std::string &problem); // Apply the timeout policy
+    bool parseWaitEnd(LineTokenizer &tokens, std::string_view command, size_t lineNumber, WaitSpec &wait);
+
     std::string filename;
     std::string description;
     std::vector<Behavior> behaviors;
+    std::vector<ScriptError> errors;
+    std::vector<std::string> subNames;                   // Subroutine names by index
+    std::vector<int> subDefinitions;                     // Behavior index of each SUB, -1 if not defined
+    std::unordered_map<std::string, int> subLookup;      // Name to subroutine index, used while parsing
+    std::vector<size_t> openBlocks;                      // REPEAT / SUB blocks open while parsing
+    std::vector<std::string> texts;                      // TYPE texts by index, as written
+    std::vector<TextTemplate> typedTexts;                // Compiled form of texts, built by bindTexts()
+    std::vector<WaitSpec> waits;                         // WAIT_* parameters by index
+    Program program; // Compiled form of behaviors, rebuilt by compile()
+    std::shared_ptr<InputBackend> input;
+    InputBatch pending; // Input actions not yet submitted, flushed at delays and round end
+    DelayScheduler scheduler;
+    CancellationToken *token = nullptr;
+    const Config *config = nullptr;
+    std::chrono::system_clock::time_point roundStartClock; // Wall clock at the start of the round, for TYPE
+    std::string roundStartTime;                            // Formatted on the first use in a round
+    std::shared_ptr<ClipboardBackend> clipboard;
+    std::chrono::milliseconds pasteSettle{50};
+    std::chrono::steady_clock::time_point pasteSettled; // When the target has had time to read the last paste
+    std::string savedClipboard;                         // Contents before the first paste not yet restored
+    bool clipboardSaved = false;
+    bool savedHadText = false;
+    std::string pasteBuffer; // Reused for the expanded text
+
+    // Waiting for files: the reactor applies the directory changes and wakes the waiter
+    std::atomic<CancellationToken *> fileWaiter{nullptr};
+    CancellationToken waitWakeup; // Waiter when no cancellation token is set
+    std::unordered_map<std::string, std::unique_ptr<DirectoryIndex>> waitDirectories; // By path
+    std::vector<DirectoryIndex *> waitIndexes; // Directory of each wait
+    std::vector<size_t> waitBaseCounts;        // File count of each wait directory at the round start
+    bool waitsNotified = false;                // Indexes are watched by the reactor, no polling needed
+    std::string waitName;                      // Reused for the expanded pattern
+    bool endRound = false;                     // A timed out wait skips the rest of the round
+    std::shared_ptr<ScreenSource> screen;
+    std::chrono::milliseconds screenPollMin{1};
+    std::chrono::milliseconds screenPollMax{50};
+    Frame screenBefore; // Region when WAIT_REGION_CHANGE began
+    Frame screenNow;    // Reused for every capture
+    std::string abortReason;
+    bool cacheEnabled = true;
     int loops = 0;
     int current_loop = 0;
+    std::atomic<uint64_t> executed_actions{0};
+
+    // Histograms are ~10 KB each, kept off the stack of whoever owns the script
+    struct Timings
+    {
+        std::array<LatencyHistogram, static_cast<size_t>(OpCode::REPEAT)> actions; // By action opcode
+        LatencyHistogram rounds;
+    };
+    std::unique_ptr<Timings> timings = std::make_unique<Timings>();
+    bool timingEnabled = true;
+    uint64_t pauses = 0; // Pauses so far, timings spanning one are dropped
+    ActionMark mark;
+
+    std::unique_ptr<ScriptStream> stream;
+    bool streamError = false;
+    size_t lineErrors = 0;    // Errors found so far, counted even when quiet
+    bool quietErrors = false; // Repeated stream passes do not report the same errors again (stream parser only)
 };
 #endif // CLICKSCRIPT_H
\ No newline at end of file
@@ -2,67 +2,102 @@
 #define SYSTEM_H
 
 // C++ standard library headers
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdio> // For sprintf_s
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <string>
 #include <thread>
-
-// System-specific headers
-#include <windows.h>
-#include <shellapi.h>
-#include <shobjidl.h> // For ITaskbarList3
+#include <vector>
 
 // Project local headers
+#include "CancellationToken.h"
 #include "Config.h"
+#include "ConsistencyChecker.h"
+#include "DirectoryIndex.h"
 #include "MyLogger.h"
+#include "PixelKernels.h"
+#include "Platform.h"
+#include "ProgressReporter.h"
+#include "RoundVerifier.h"
+#include "ThreadManager.h"
+#include "Tracer.h"
 #include "clickscript.h"
 
 class Lights; // Forward declaration for friend class
-
-extern std::atomic<bool> g_isRunning;
-extern std::atomic<int> g_currentProgress;
-extern std::atomic<int> g_totalProgress;
-extern std::atomic<bool> g_emergencyStop; // Global emergency stop flag
-
-// Global variables for taskbar progress
-extern ITaskbarList3 *g_pTaskbarList;
-extern HWND g_consoleWindow;
+class ClickScript;
 
 class System
 {
 public:
-    void initialize();
+    void initialize(const std::string &configFile = "config.txt");
     void printMainMenu();
     void runMainLoop();               // Main loop
     int getUserChoice();              // Get user input
     void executeChoice(int choice);   // Execute corresponding task
     void countdown(int seconds = 10); // Countdown timer
 
+    // Options of one script run. Interactive runs prompt for what is left unset,
+    // headless runs never read stdin, clear the screen or wait for a key.
+    struct RunOptions
+    {
+        std::string script;
+        int loops = -1;           // -1 prompts in interactive runs
+        int startHour = -1;       // Local start time, -1 uses the countdown
+        int startMinute = 0;
+        int countdownSeconds = 5;
+        std::string preflight;    // Overrides Preflight_Simulation when set, ASK means DISABLE headless
+        bool interactive = true;
+    };
+
+    // Run one script, return true if every round completed
+    bool runScript(RunOptions options);
+    // Parse "HH:MM" or "HH MM"
+    static bool parseStartTime(const std::string &text, int &hour, int &minute);
+    // Replace the configuration with the one in path
+    bool loadConfig(const std::string &path);
+
     void startAutoclickScript(); // Task 1
     void measureMousePosition(); // Task 2 Measure mouse position
     void configInit();           // Task 3 Config initialization
     void temporaryTask();        // Task 99 Test only
 
+    // Compile every .clk under directory and refresh its cache, in parallel.
+    // threads <= 0 uses one thread per hardware core. Return false if any failed.
+    bool precompileScripts(const std::string &directory, int threads = 0);
+
     void printSplitLine();
 
     Config &getConfig() { return config; } // Accessor for config
 
     friend class Lights; // Allow Lights class to access private members of System
 
-    // Taskbar progress
-    bool initializeTaskbarProgress();
-    void updateTaskbarProgress(int completed, int total);
-    void setTaskbarProgressState(TBPFLAG state);
-    void cleanupTaskbarProgress();
-
-    // Emergency stop
-    void escapeKeyListener();
+    // Emergency stop, ESC / Pause are handled by the ThreadManager reactor
+    CancellationToken &getRunToken() { return runToken; } // Stop / pause requests of the current run
 
 private:
+    // Delete the newest files of larger until it has no more files than smaller.
+    // Deletions are logged against round, return true if any were needed.
+    bool reconcileFileCounts(DirectoryIndex &larger, DirectoryIndex &smaller, const char *largerName,
+                             const char *smallerName, int round);
+
+    // Script_Streaming: ENABLE, DISABLE or AUTO (files of Script_Stream_Threshold_MB and more)
+    bool useStreaming(const std::string &script);
+
+    // Dry run loops rounds on the virtual clock and print the predicted duration
+    void runPreflightSimulation(ClickScript &script, int loops);
+
+    // Consistency_Check / Consistency_Group_N, nullptr when disabled
+    std::unique_ptr<ConsistencyChecker> createConsistencyChecker(const std::string &path1, const std::string &path2);
+    // Check every group, report mismatches that appeared since the previous round
+    bool checkConsistency(ConsistencyChecker &checker, int round);
+
     Config config; // Configuration object
+    CancellationToken runToken;
 };
 
 #endif // SYSTEM_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "CancellationToken.h"
+
+namespace
+{
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   CancellationToken::clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+void CancellationToken::setState(State state)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentState.store(state, std::memory_order_relaxed);
+    }
+    changed.notify_all();
+}
+
+void CancellationToken::requestStop()
+{
+    if (stopRequested())
+        return;
+    stopRequestNs.store(nowNs());
+    setState(State::STOPPED);
+}
+
+void CancellationToken::pause()
+{
+    // Only a running engine can be paused, a stop always wins
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state() == State::RUNNING)
+        currentState.store(State::PAUSED, std::memory_order_relaxed);
+}
+
+void CancellationToken::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state() != State::PAUSED)
+            return;
+        currentState.store(State::RUNNING, std::memory_order_relaxed);
+    }
+    changed.notify_all();
+}
+
+void CancellationToken::reset()
+{
+    stopLatencyNs.store(-1);
+    setState(State::RUNNING);
+}
+
+bool CancellationToken::waitUntil(clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return !changed.wait_until(lock, deadline, [this]
+                               { return stopRequested(); });
+}
+
+bool CancellationToken::waitUntil(clock::time_point deadline, const std::function<bool()> &ready)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    bool met = false;
+    changed.wait_until(lock, deadline, [&]
+                       { return stopRequested() || (met = ready()); });
+    return met && !stopRequested();
+}
+
+void CancellationToken::wake()
+{
+    // Taking the lock orders the wake after a waiter that is between its check and its wait
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    changed.notify_all();
+}
+
+std::chrono::nanoseconds CancellationToken::waitWhilePaused()
+{
+    auto start = clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]
+                 { return !isPaused(); });
+    return clock::now() - start;
+}
+
+void CancellationToken::acknowledgeStop()
+{
+    if (!stopRequested() || hasStopLatency())
+        return;
+    int64_t expected = -1;
+    stopLatencyNs.compare_exchange_strong(expected, nowNs() - stopRequestNs.load());
+}
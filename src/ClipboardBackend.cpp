@@ -0,0 +1,119 @@
+#include "ClipboardBackend.h"
+
+#include "MyLogger.h"
+#include "Platform.h"
+
+#ifdef _WIN32
+namespace
+{
+    // Another program may hold the clipboard open for a moment
+    bool openClipboard()
+    {
+        for (int attempt = 0; attempt < 10; ++attempt)
+        {
+            if (OpenClipboard(nullptr))
+                return true;
+            platform::sleepMs(1);
+        }
+        MYLOG_WARNING("Clipboard is busy, gave up after 10 attempts");
+        return false;
+    }
+}
+
+bool Win32ClipboardBackend::getText(std::string &text)
+{
+    if (!openClipboard())
+        return false;
+    bool found = false;
+    HANDLE data = GetClipboardData(CF_UNICODETEXT);
+    if (data)
+    {
+        const wchar_t *wide = static_cast<const wchar_t *>(GlobalLock(data));
+        if (wide)
+        {
+            int bytes = WideCharToMultiByte(CP_UTF8, 0, wide, -1, nullptr, 0, nullptr, nullptr);
+            text.assign(bytes > 0 ? bytes - 1 : 0, '\0');
+            if (bytes > 1)
+                WideCharToMultiByte(CP_UTF8, 0, wide, -1, text.data(), bytes, nullptr, nullptr);
+            GlobalUnlock(data);
+            found = true;
+        }
+    }
+    CloseClipboard();
+    return found;
+}
+
+bool Win32ClipboardBackend::setText(const std::string &text)
+{
+    // One allocation and conversion, the clipboard takes ownership of the memory
+    int chars = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, (static_cast<size_t>(chars) + 1) * sizeof(wchar_t));
+    if (!memory)
+        return false;
+    wchar_t *wide = static_cast<wchar_t *>(GlobalLock(memory));
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), wide, chars);
+    wide[chars] = L'\0';
+    GlobalUnlock(memory);
+
+    if (!openClipboard())
+    {
+        GlobalFree(memory);
+        return false;
+    }
+    EmptyClipboard();
+    bool ok = SetClipboardData(CF_UNICODETEXT, memory) != nullptr;
+    CloseClipboard();
+    if (!ok)
+    {
+        GlobalFree(memory);
+        MYLOG_ERROR("SetClipboardData failed: {}", GetLastError());
+    }
+    return ok;
+}
+
+bool Win32ClipboardBackend::clear()
+{
+    if (!openClipboard())
+        return false;
+    bool ok = EmptyClipboard() != 0;
+    CloseClipboard();
+    return ok;
+}
+#endif
+
+bool MemoryClipboardBackend::getText(std::string &text)
+{
+    if (hasText)
+        text = contents;
+    return hasText;
+}
+
+bool MemoryClipboardBackend::setText(const std::string &text)
+{
+    contents = text;
+    hasText = true;
+    ++writeCount;
+    return true;
+}
+
+bool MemoryClipboardBackend::clear()
+{
+    contents.clear();
+    hasText = false;
+    return true;
+}
+
+std::shared_ptr<ClipboardBackend> createClipboardBackend(const std::string &name)
+{
+    if (name == "MEMORY")
+        return std::make_shared<MemoryClipboardBackend>();
+#ifdef _WIN32
+    if (!name.empty() && name != "WIN32")
+        MYLOG_WARNING("Unknown clipboard backend '{}', using WIN32.", name);
+    return std::make_shared<Win32ClipboardBackend>();
+#else
+    if (!name.empty())
+        MYLOG_WARNING("Clipboard backend '{}' is not available, using MEMORY.", name);
+    return std::make_shared<MemoryClipboardBackend>();
+#endif
+}
@@ -0,0 +1,241 @@
+#include "ConsistencyChecker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+
+#include "Hash.h"
+#include "Tracer.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr size_t READ_CHUNK_BYTES = 1 << 20; // Large sequential reads, files are never loaded whole
+}
+
+bool ConsistencyChecker::parseLevel(const std::string &name, Level &level)
+{
+    if (name == "NAMES")
+        level = Level::NAMES;
+    else if (name == "SIZES")
+        level = Level::SIZES;
+    else if (name == "HASH")
+        level = Level::HASHES;
+    else
+        return false;
+    return true;
+}
+
+ConsistencyChecker::ConsistencyChecker(Level level, int threads)
+    : level(level), pool(threads)
+{
+}
+
+void ConsistencyChecker::addGroup(const std::string &name, const std::string &directories)
+{
+    Group group;
+    group.name = name;
+    size_t begin = 0;
+    while (begin <= directories.size())
+    {
+        size_t end = directories.find(';', begin);
+        if (end == std::string::npos)
+            end = directories.size();
+        std::string directory = directories.substr(begin, end - begin);
+        directory.erase(0, directory.find_first_not_of(" \t"));
+        directory.erase(directory.find_last_not_of(" \t") + 1);
+        if (!directory.empty())
+            group.directories.push_back(directory);
+        begin = end + 1;
+    }
+    if (group.directories.size() < 2)
+        return; // Nothing to compare
+    groupList.push_back(std::move(group));
+    previous.emplace_back();
+}
+
+void ConsistencyChecker::listTree(const std::string &directory, std::vector<FileRecord> &files)
+{
+    fs::path root(directory);
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec))
+    {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError))
+            continue;
+        FileRecord record;
+        record.size = it->file_size(entryError);
+        record.mtime = it->last_write_time(entryError);
+        if (entryError)
+            continue; // Removed while listing
+        record.relative = it->path().lexically_relative(root).generic_string();
+        files.push_back(std::move(record));
+    }
+    std::sort(files.begin(), files.end(), [](const FileRecord &a, const FileRecord &b)
+              { return a.relative < b.relative; });
+}
+
+bool ConsistencyChecker::hashFile(const fs::path &path, const FileRecord &record, uint64_t &hash,
+                                  uint64_t &bytesRead)
+{
+    std::string key = path.string();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = hashCache.find(key);
+        if (it != hashCache.end() && it->second.size == record.size && it->second.mtime == record.mtime)
+        {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+
+    std::FILE *file = std::fopen(key.c_str(), "rb");
+    if (!file)
+        return false;
+    std::setvbuf(file, nullptr, _IONBF, 0); // Our chunks are already large, skip the stdio copy
+
+    thread_local std::vector<char> chunk(READ_CHUNK_BYTES);
+    uint64_t value = 0;
+    size_t length;
+    while ((length = std::fread(chunk.data(), 1, chunk.size(), file)) > 0)
+    {
+        value = hash64(chunk.data(), length, value);
+        bytesRead += length;
+    }
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    if (!ok)
+        return false;
+
+    hash = value;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    hashCache[key] = CachedHash{record.size, record.mtime, value};
+    return true;
+}
+
+ConsistencyChecker::Report ConsistencyChecker::check(size_t index)
+{
+    const Group &group = groupList[index];
+    const auto &directories = group.directories;
+    size_t count = directories.size();
+
+    // List every tree in parallel
+    std::vector<std::vector<FileRecord>> listings(count);
+    {
+        TraceSpan span("verify", "list trees", "directories", static_cast<int64_t>(count));
+        pool.parallelFor(count, [&](size_t d)
+                         { listTree(directories[d], listings[d]); });
+    }
+
+    // Diff each tree against the reference by sorted relative name
+    std::set<Mismatch> current;
+    std::vector<std::vector<size_t>> matchOf(count);    // Index of the matching reference file, per directory
+    const auto &reference = listings[0];
+    for (size_t d = 1; d < count; ++d)
+    {
+        const auto &other = listings[d];
+        matchOf[d].assign(other.size(), SIZE_MAX);
+        size_t i = 0, j = 0;
+        while (i < reference.size() || j < other.size())
+        {
+            int order = i == reference.size()   ? 1
+                        : j == other.size()     ? -1
+                                                : reference[i].relative.compare(other[j].relative);
+            if (order < 0)
+            {
+                current.insert({reference[i++].relative, "missing in " + directories[d]});
+            }
+            else if (order > 0)
+            {
+                current.insert({other[j++].relative, "missing in " + directories[0]});
+            }
+            else
+            {
+                if (level != Level::NAMES && reference[i].size != other[j].size)
+                {
+                    current.insert({reference[i].relative, "size " + std::to_string(reference[i].size) + " in " +
+                                                               directories[0] + ", " +
+                                                               std::to_string(other[j].size) + " in " +
+                                                               directories[d]});
+                }
+                else if (level == Level::HASHES)
+                {
+                    matchOf[d][j] = i;
+                }
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    Report report;
+    if (level == Level::HASHES)
+    {
+        // Hash every file that takes part in a comparison once, largest first for better balance
+        std::vector<char> referenceNeeded(reference.size(), 0);
+        std::vector<std::pair<size_t, size_t>> jobs; // (directory, file)
+        for (size_t d = 1; d < count; ++d)
+        {
+            for (size_t j = 0; j < matchOf[d].size(); ++j)
+            {
+                if (matchOf[d][j] == SIZE_MAX)
+                    continue;
+                jobs.emplace_back(d, j);
+                if (!referenceNeeded[matchOf[d][j]])
+                {
+                    referenceNeeded[matchOf[d][j]] = 1;
+                    jobs.emplace_back(0, matchOf[d][j]);
+                }
+            }
+        }
+        std::sort(jobs.begin(), jobs.end(), [&](const auto &a, const auto &b)
+                  { return listings[a.first][a.second].size > listings[b.first][b.second].size; });
+
+        std::vector<std::vector<uint64_t>> hashes(count);
+        std::vector<std::vector<char>> hashed(count);
+        for (size_t d = 0; d < count; ++d)
+        {
+            hashes[d].assign(listings[d].size(), 0);
+            hashed[d].assign(listings[d].size(), 0);
+        }
+
+        std::atomic<uint64_t> bytesHashed{0};
+        TraceSpan span("verify", "hash files", "files", static_cast<int64_t>(jobs.size()));
+        pool.parallelFor(jobs.size(), [&](size_t k)
+                         {
+                             auto [d, f] = jobs[k];
+                             uint64_t bytes = 0;
+                             fs::path path = fs::path(directories[d]) / fs::path(listings[d][f].relative);
+                             hashed[d][f] = hashFile(path, listings[d][f], hashes[d][f], bytes);
+                             bytesHashed.fetch_add(bytes, std::memory_order_relaxed); });
+        report.bytesHashed = bytesHashed.load();
+
+        for (size_t d = 1; d < count; ++d)
+        {
+            for (size_t j = 0; j < matchOf[d].size(); ++j)
+            {
+                size_t i = matchOf[d][j];
+                if (i == SIZE_MAX)
+                    continue;
+                if (!hashed[0][i] || !hashed[d][j])
+                    current.insert({reference[i].relative, "unreadable in " + directories[hashed[0][i] ? d : 0]});
+                else if (hashes[0][i] != hashes[d][j])
+                    current.insert({reference[i].relative, "content differs in " + directories[d]});
+            }
+        }
+    }
+
+    // Attribute only the changes since the previous check to this one
+    std::set<Mismatch> &before = previous[index];
+    std::set_difference(current.begin(), current.end(), before.begin(), before.end(),
+                        std::back_inserter(report.appeared));
+    for (const Mismatch &mismatch : before)
+        report.resolved += current.count(mismatch) == 0;
+    report.total = current.size();
+    before = std::move(current);
+    return report;
+}
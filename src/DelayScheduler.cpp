@@ -0,0 +1,150 @@
+#include "DelayScheduler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
+#include "MyLogger.h"
+#include "Platform.h"
+
+namespace
+{
+    // Until calibrated assume the worst common case (default Windows timer)
+    std::chrono::nanoseconds g_sleepGranularity = std::chrono::milliseconds(16);
+}
+
+void DelayScheduler::calibrate(int samples)
+{
+    using namespace std::chrono;
+
+    platform::beginHighResolutionTimer();
+    nanoseconds worst{0};
+    for (int i = 0; i < samples; ++i)
+    {
+        auto before = clock::now();
+        std::this_thread::sleep_for(milliseconds(1));
+        auto overshoot = duration_cast<nanoseconds>(clock::now() - before) - milliseconds(1);
+        worst = std::max(worst, overshoot);
+    }
+    platform::endHighResolutionTimer();
+
+    // Leave some headroom above the worst observed overshoot
+    g_sleepGranularity = std::max<nanoseconds>(worst + worst / 2, microseconds(200));
+    MYLOG_INFO("Calibrated sleep granularity: {} us", duration_cast<microseconds>(g_sleepGranularity).count());
+}
+
+std::chrono::nanoseconds DelayScheduler::sleepGranularity()
+{
+    return g_sleepGranularity;
+}
+
+void DelayScheduler::beginRound()
+{
+    deadline = virtualClock ? virtualNow : clock::now();
+    delayIndex = 0;
+}
+
+void DelayScheduler::setVirtualClock(bool enabled)
+{
+    virtualClock = enabled;
+    virtualNow = clock::time_point{};
+}
+
+bool DelayScheduler::waitFor(int delayMs, CancellationToken *token)
+{
+    using namespace std::chrono;
+
+    deadline += milliseconds(std::max(delayMs, 0));
+    if (virtualClock)
+    {
+        // Deadlines are absolute, so injection time never adds up and the sum of delays is the prediction
+        virtualNow = std::max(virtualNow, deadline);
+        return !(token && token->stopRequested());
+    }
+    const clock::time_point target = deadline - injectionLatency;
+
+    // Sleep for the coarse part, leaving one granularity step to spin on.
+    // The token wait returns as soon as a stop is requested.
+    auto now = clock::now();
+    if (target - now > g_sleepGranularity)
+    {
+        if (token)
+        {
+            if (!token->waitUntil(target - g_sleepGranularity))
+                return false;
+        }
+        else
+        {
+            std::this_thread::sleep_for(target - now - g_sleepGranularity);
+        }
+    }
+    while ((now = clock::now()) < target)
+    {
+        if (token && token->stopRequested())
+            return false;
+        std::this_thread::yield();
+    }
+
+    int64_t error = duration_cast<nanoseconds>(now - target).count();
+    errors.record(static_cast<uint64_t>(std::max<int64_t>(error, 0)));
+
+    // Record the jitter of this DELAY position, later positions only go to the histogram
+    if (delayIndex >= MAX_TRACKED_DELAYS)
+    {
+        ++delayIndex;
+        return true;
+    }
+    if (delayIndex >= stats.size())
+    {
+        stats.resize(delayIndex + 1);
+        stats[delayIndex].intendedMs = delayMs;
+    }
+    DelayStats &entry = stats[delayIndex++];
+    if (entry.count == 0)
+    {
+        entry.minErrorNs = entry.maxErrorNs = error;
+    }
+    entry.minErrorNs = std::min(entry.minErrorNs, error);
+    entry.maxErrorNs = std::max(entry.maxErrorNs, error);
+    entry.sumErrorNs += error;
+    entry.sumAbsErrorNs += error < 0 ? -error : error;
+    ++entry.count;
+    return true;
+}
+
+void DelayScheduler::recordInjection(std::chrono::nanoseconds latency)
+{
+    // Exponential moving average, 1/8 weight for the newest sample
+    injectionLatency += (latency - injectionLatency) / 8;
+}
+
+void DelayScheduler::report(std::ostream &out) const
+{
+    out << "--- DELAY jitter (error of wake-up against deadline) ---" << std::endl;
+    if (stats.empty())
+    {
+        out << "No delays executed." << std::endl;
+        return;
+    }
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        const DelayStats &entry = stats[i];
+        if (entry.count == 0)
+        {
+            continue;
+        }
+        out << "DELAY #" << (i + 1) << " (" << entry.intendedMs << " ms): "
+            << "mean " << entry.sumErrorNs / 1000.0 / entry.count << " us, "
+            << "mean abs " << entry.sumAbsErrorNs / 1000.0 / entry.count << " us, "
+            << "min " << entry.minErrorNs / 1000.0 << " us, "
+            << "max " << entry.maxErrorNs / 1000.0 << " us, "
+            << "samples " << entry.count << std::endl;
+    }
+    if (stats.size() == MAX_TRACKED_DELAYS)
+    {
+        out << "Later DELAY positions are only counted in the delay_error histogram." << std::endl;
+    }
+    out << "Injection latency estimate: "
+        << std::chrono::duration_cast<std::chrono::nanoseconds>(injectionLatency).count() / 1000.0 << " us" << std::endl;
+}
@@ -0,0 +1,429 @@
+#include "DirectoryIndex.h"
+
+#include <iterator>
+#include <string_view>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr size_t NOTIFY_BUFFER_BYTES = 64 * 1024;
+
+    // Glob match with * (any run) and ? (one character), backtracking to the last *
+    template <typename Char>
+    bool globMatch(std::basic_string_view<Char> pattern, std::basic_string_view<Char> name)
+    {
+        size_t p = 0, n = 0;
+        size_t star = std::basic_string_view<Char>::npos, resume = 0;
+        while (n < name.size())
+        {
+            if (p < pattern.size() && (pattern[p] == Char('?') || pattern[p] == name[n]))
+            {
+                ++p;
+                ++n;
+            }
+            else if (p < pattern.size() && pattern[p] == Char('*'))
+            {
+                star = p++;
+                resume = n;
+            }
+            else if (star != std::basic_string_view<Char>::npos)
+            {
+                p = star + 1;
+                n = ++resume;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == Char('*'))
+            ++p;
+        return p == pattern.size();
+    }
+}
+
+DirectoryIndex::DirectoryIndex(const std::string &directory)
+    : directory(directory), root(directory)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    // Watch before listing so no change between the two is lost
+    watching = openWatch();
+    if (!watching)
+        MYLOG_WARNING("Can not watch '{}', falling back to a full scan per query.", directory);
+    rebuild();
+}
+
+DirectoryIndex::~DirectoryIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closeWatch();
+    }
+    if (reactor)
+        reactor->sync(); // A notification callback may still be running
+}
+
+void DirectoryIndex::watch(ThreadManager &manager)
+{
+    // Held until the id is stored, a callback that fails the watch at once must find it
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!watching || reactorHandle)
+        return;
+    reactor = &manager;
+#ifdef _WIN32
+    reactorHandle = reactor->addHandle(overlapped.hEvent, [this]
+#else
+    reactorHandle = reactor->addHandle(notifyFd, [this]
+#endif
+                                       {
+                                           {
+                                               std::lock_guard<std::mutex> lock(mtx);
+                                               refresh();
+                                           }
+                                           if (changeCallback)
+                                               changeCallback(); });
+}
+
+size_t DirectoryIndex::count()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    refresh();
+    return files.size();
+}
+
+bool DirectoryIndex::newest(std::string &file)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    refresh();
+    if (byTime.empty())
+        return false;
+    file = (root / byTime.rbegin()->second).string();
+    return true;
+}
+
+bool DirectoryIndex::findMatching(const std::string &pattern, std::string *file)
+{
+    Name wanted = fs::path(std::u8string(pattern.begin(), pattern.end())).native();
+    bool wildcard = wanted.find_first_of(Name{'*', '?'}) != Name::npos;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    refresh();
+    const Name *found = nullptr;
+    if (!wildcard)
+    {
+        auto it = files.find(wanted);
+        found = it != files.end() ? &it->first : nullptr;
+    }
+    else
+    {
+        using View = std::basic_string_view<Name::value_type>;
+        for (const auto &entry : files)
+        {
+            if (globMatch(View(wanted), View(entry.first)))
+            {
+                found = &entry.first;
+                break;
+            }
+        }
+    }
+    if (found && file)
+        *file = (root / *found).string();
+    return found != nullptr;
+}
+
+bool DirectoryIndex::deleteNewest(std::string *deleted)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    refresh();
+    if (byTime.empty())
+        return false;
+
+    Name name = std::prev(byTime.end())->second;
+    fs::path file = root / name;
+    std::error_code ec;
+    if (!fs::remove(file, ec))
+    {
+        MYLOG_ERROR("Failed to delete {}: {}", file.string(), ec ? ec.message() : "file vanished");
+        rebuild(); // The index was wrong about this file, trust the disk again
+        return false;
+    }
+
+    // Update now, the notification for this removal finds nothing left to do
+    applyRemoval(name);
+    if (deleted)
+        *deleted = file.string();
+    return true;
+}
+
+void DirectoryIndex::rescan()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    rebuild();
+}
+
+void DirectoryIndex::applyChange(const Name &name)
+{
+    std::error_code ec;
+    fs::path file = root / name;
+    auto status = fs::status(file, ec);
+    if (ec || !fs::is_regular_file(status))
+    {
+        applyRemoval(name);
+        return;
+    }
+    auto mtime = fs::last_write_time(file, ec);
+    if (ec)
+    {
+        applyRemoval(name);
+        return;
+    }
+
+    auto it = files.find(name);
+    if (it != files.end())
+    {
+        if (it->second == mtime)
+            return;
+        byTime.erase({it->second, name});
+        it->second = mtime;
+    }
+    else
+    {
+        files.emplace(name, mtime);
+    }
+    byTime.emplace(mtime, name);
+}
+
+void DirectoryIndex::applyRemoval(const Name &name)
+{
+    auto it = files.find(name);
+    if (it == files.end())
+        return;
+    byTime.erase({it->second, name});
+    files.erase(it);
+}
+
+void DirectoryIndex::leaveReactor()
+{
+    // Before the handle is closed, the OS may hand its number to the next watch
+    if (reactor && reactorHandle)
+    {
+        reactor->removeHandle(reactorHandle);
+        reactorHandle = 0;
+    }
+}
+
+void DirectoryIndex::rebuild()
+{
+    files.clear();
+    byTime.clear();
+    ++rescanCount;
+
+    std::error_code ec;
+    for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::error_code entryError;
+        if (!it->is_regular_file(entryError))
+            continue;
+        auto mtime = it->last_write_time(entryError);
+        if (entryError)
+            continue;
+        Name name = it->path().filename().native();
+        files.emplace(name, mtime);
+        byTime.emplace(mtime, std::move(name));
+    }
+    if (ec)
+        MYLOG_WARNING("Scanning '{}' failed: {}", directory, ec.message());
+}
+
+#ifdef _WIN32
+
+bool DirectoryIndex::openWatch()
+{
+    directoryHandle = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directoryHandle == INVALID_HANDLE_VALUE)
+        return false;
+    overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    buffer.resize(NOTIFY_BUFFER_BYTES / sizeof(DWORD));
+    if (!overlapped.hEvent || !issueRead())
+    {
+        closeWatch();
+        return false;
+    }
+    return true;
+}
+
+bool DirectoryIndex::issueRead()
+{
+    ResetEvent(overlapped.hEvent);
+    return ReadDirectoryChangesW(directoryHandle, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof(DWORD)),
+                                 FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                 nullptr, &overlapped, nullptr) != 0;
+}
+
+void DirectoryIndex::closeWatch()
+{
+    leaveReactor();
+    if (directoryHandle != INVALID_HANDLE_VALUE)
+    {
+        CancelIoEx(directoryHandle, &overlapped);
+        DWORD bytes;
+        GetOverlappedResult(directoryHandle, &overlapped, &bytes, TRUE);
+        CloseHandle(directoryHandle);
+        directoryHandle = INVALID_HANDLE_VALUE;
+    }
+    if (overlapped.hEvent)
+    {
+        CloseHandle(overlapped.hEvent);
+        overlapped.hEvent = nullptr;
+    }
+    watching = false;
+}
+
+void DirectoryIndex::refresh()
+{
+    if (!watching)
+    {
+        rebuild();
+        return;
+    }
+
+    // Every completed read is one batch; the next read is issued right away
+    DWORD bytes = 0;
+    while (GetOverlappedResult(directoryHandle, &overlapped, &bytes, FALSE))
+    {
+        if (bytes == 0)
+        {
+            // The system buffer overflowed, the changes are unknown
+            MYLOG_DEBUG("Change notifications for '{}' overflowed, rescanning.", directory);
+            rebuild();
+        }
+        else
+        {
+            const char *cursor = reinterpret_cast<const char *>(buffer.data());
+            while (true)
+            {
+                auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(cursor);
+                Name name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                if (info->Action == FILE_ACTION_REMOVED || info->Action == FILE_ACTION_RENAMED_OLD_NAME)
+                    applyRemoval(name);
+                else
+                    applyChange(name);
+                if (info->NextEntryOffset == 0)
+                    break;
+                cursor += info->NextEntryOffset;
+            }
+        }
+        if (!issueRead())
+        {
+            closeWatch();
+            rebuild();
+            return;
+        }
+    }
+    if (GetLastError() != ERROR_IO_INCOMPLETE)
+    {
+        MYLOG_WARNING("Watching '{}' failed ({}), falling back to full scans.", directory, GetLastError());
+        closeWatch();
+        rebuild();
+    }
+}
+
+#else
+
+bool DirectoryIndex::openWatch()
+{
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0)
+        return false;
+    // IN_CLOSE_WRITE / IN_ATTRIB pick up the final mtime of files written in place
+    uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB |
+                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    if (inotify_add_watch(notifyFd, directory.c_str(), mask) < 0)
+    {
+        closeWatch();
+        return false;
+    }
+    buffer.resize(NOTIFY_BUFFER_BYTES);
+    return true;
+}
+
+void DirectoryIndex::closeWatch()
+{
+    leaveReactor();
+    if (notifyFd >= 0)
+    {
+        close(notifyFd);
+        notifyFd = -1;
+    }
+    watching = false;
+}
+
+void DirectoryIndex::refresh()
+{
+    if (!watching)
+    {
+        rebuild();
+        return;
+    }
+
+    while (true)
+    {
+        ssize_t length = read(notifyFd, buffer.data(), buffer.size());
+        if (length <= 0)
+        {
+            if (length < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                MYLOG_WARNING("Watching '{}' failed ({}), falling back to full scans.", directory,
+                              std::strerror(errno));
+                closeWatch();
+                rebuild();
+            }
+            return;
+        }
+
+        bool overflowed = false;
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflowed = true;
+            }
+            else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                // The directory itself is gone or was replaced, inotify can not follow it
+                MYLOG_WARNING("'{}' was moved or removed, falling back to full scans.", directory);
+                closeWatch();
+                rebuild();
+                return;
+            }
+            else if (event->len > 0 && !overflowed)
+            {
+                Name name(event->name);
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    applyRemoval(name);
+                else
+                    applyChange(name);
+            }
+        }
+        if (overflowed)
+        {
+            MYLOG_DEBUG("Change notifications for '{}' overflowed, rescanning.", directory);
+            rebuild();
+        }
+    }
+}
+
+#endif
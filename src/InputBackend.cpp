@@ -0,0 +1,215 @@
+#include "InputBackend.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "MyLogger.h"
+
+void InputBatch::moveCursor(int x, int y)
+{
+    InputEvent event;
+    event.type = InputEventType::MOUSE_MOVE;
+    event.x = x;
+    event.y = y;
+    events.push_back(event);
+}
+
+void InputBatch::mouseButton(MouseButton button, bool down, int x, int y)
+{
+    InputEvent event;
+    event.type = down ? InputEventType::MOUSE_DOWN : InputEventType::MOUSE_UP;
+    event.button = button;
+    event.x = x;
+    event.y = y;
+    events.push_back(event);
+}
+
+void InputBatch::key(uint16_t vk, bool down)
+{
+    InputEvent event;
+    event.type = down ? InputEventType::KEY_DOWN : InputEventType::KEY_UP;
+    event.key = vk;
+    events.push_back(event);
+}
+
+void InputBatch::click(MouseButton button, int x, int y)
+{
+    moveCursor(x, y);
+    mouseButton(button, true, x, y);
+    mouseButton(button, false, x, y);
+}
+
+void InputBatch::keyPress(uint16_t vk)
+{
+    key(vk, true);
+    key(vk, false);
+}
+
+size_t InputBatch::typeText(std::string_view text)
+{
+    size_t skipped = 0;
+    bool shiftDown = false;
+    events.reserve(events.size() + text.size() * 2 + 2);
+    for (char ch : text)
+    {
+        KeyStroke stroke = keyForChar(ch);
+        if (stroke.vk == 0)
+        {
+            ++skipped;
+            continue;
+        }
+        if (stroke.shift != shiftDown)
+        {
+            key(VirtualKey::SHIFT, stroke.shift);
+            shiftDown = stroke.shift;
+        }
+        keyPress(stroke.vk);
+    }
+    if (shiftDown)
+        key(VirtualKey::SHIFT, false);
+    return skipped;
+}
+
+#ifdef _WIN32
+void Win32InputBackend::submit(const InputEvent *events, size_t count)
+{
+    if (count == 0)
+        return;
+
+    // Absolute moves are expressed in 0..65535 over the whole virtual desktop
+    const int originX = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    const int originY = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    const int width = (std::max)(GetSystemMetrics(SM_CXVIRTUALSCREEN) - 1, 1);
+    const int height = (std::max)(GetSystemMetrics(SM_CYVIRTUALSCREEN) - 1, 1);
+
+    inputs.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const InputEvent &event = events[i];
+        INPUT &input = inputs[i];
+        ZeroMemory(&input, sizeof(INPUT));
+        switch (event.type)
+        {
+        case InputEventType::MOUSE_MOVE:
+            input.type = INPUT_MOUSE;
+            input.mi.dx = static_cast<LONG>((static_cast<int64_t>(event.x - originX) * 65535) / width);
+            input.mi.dy = static_cast<LONG>((static_cast<int64_t>(event.y - originY) * 65535) / height);
+            input.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+            break;
+        case InputEventType::MOUSE_DOWN:
+            input.type = INPUT_MOUSE;
+            input.mi.dwFlags = event.button == MouseButton::LEFT ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_RIGHTDOWN;
+            break;
+        case InputEventType::MOUSE_UP:
+            input.type = INPUT_MOUSE;
+            input.mi.dwFlags = event.button == MouseButton::LEFT ? MOUSEEVENTF_LEFTUP : MOUSEEVENTF_RIGHTUP;
+            break;
+        case InputEventType::KEY_DOWN:
+            input.type = INPUT_KEYBOARD;
+            input.ki.wVk = event.key;
+            break;
+        case InputEventType::KEY_UP:
+            input.type = INPUT_KEYBOARD;
+            input.ki.wVk = event.key;
+            input.ki.dwFlags = KEYEVENTF_KEYUP;
+            break;
+        }
+    }
+
+    UINT sent = SendInput(static_cast<UINT>(count), inputs.data(), sizeof(INPUT));
+    if (sent != count)
+    {
+        MYLOG_ERROR("SendInput injected {} of {} events.", sent, count);
+    }
+}
+#endif
+
+RecordingInputBackend::RecordingInputBackend() : start(std::chrono::steady_clock::now()) {}
+
+void RecordingInputBackend::submit(const InputEvent *events, size_t count)
+{
+    if (count == 0)
+        return;
+
+    // Every event of a submission shares its timestamp, as they are injected together
+    RecordedEvent record;
+    record.timestampNs = timeSource ? timeSource()
+                                    : std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now() - start)
+                                          .count();
+    record.submission = submissionCount++;
+    for (size_t i = 0; i < count; ++i)
+    {
+        record.event = events[i];
+        recorded.push_back(record);
+    }
+}
+
+void RecordingInputBackend::clear()
+{
+    recorded.clear();
+    start = std::chrono::steady_clock::now();
+    submissionCount = 0;
+    submissionMark = 0;
+}
+
+void RecordingInputBackend::write(std::ostream &out, bool withTimestamps) const
+{
+    for (const auto &record : recorded)
+    {
+        const InputEvent &event = record.event;
+        if (withTimestamps)
+        {
+            out << record.timestampNs << " " << record.submission << " ";
+        }
+        const char *button = event.button == MouseButton::LEFT ? "LEFT" : "RIGHT";
+        switch (event.type)
+        {
+        case InputEventType::MOUSE_MOVE:
+            out << "MOVE " << event.x << " " << event.y;
+            break;
+        case InputEventType::MOUSE_DOWN:
+            out << "DOWN " << button << " " << event.x << " " << event.y;
+            break;
+        case InputEventType::MOUSE_UP:
+            out << "UP " << button << " " << event.x << " " << event.y;
+            break;
+        case InputEventType::KEY_DOWN:
+            out << "KEY_DOWN " << event.key;
+            break;
+        case InputEventType::KEY_UP:
+            out << "KEY_UP " << event.key;
+            break;
+        }
+        out << '\n';
+    }
+}
+
+bool RecordingInputBackend::save(const std::string &filename, bool withTimestamps) const
+{
+    std::ofstream file(filename, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        MYLOG_ERROR("Failed to open input recording file: {}", filename);
+        return false;
+    }
+    write(file, withTimestamps);
+    return true;
+}
+
+std::shared_ptr<InputBackend> createInputBackend(const std::string &name)
+{
+    if (name == "NULL")
+        return std::make_shared<NullInputBackend>();
+    if (name == "RECORDING")
+        return std::make_shared<RecordingInputBackend>();
+#ifdef _WIN32
+    if (!name.empty() && name != "WIN32")
+        MYLOG_WARNING("Unknown input backend '{}', using WIN32.", name);
+    return std::make_shared<Win32InputBackend>();
+#else
+    if (!name.empty())
+        MYLOG_WARNING("Input backend '{}' is not available, using NULL.", name);
+    return std::make_shared<NullInputBackend>();
+#endif
+}
@@ -0,0 +1,114 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+    constexpr uint64_t SUB_COUNT = uint64_t{1} << LatencyHistogram::SUB_BITS;
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t ns)
+{
+    if (ns < SUB_COUNT)
+        return static_cast<size_t>(ns); // Exact below the first power of two that is split
+    int exponent = std::bit_width(ns) - 1;
+    if (exponent >= MAX_EXPONENT)
+        return BUCKETS - 1;
+    int shift = exponent - SUB_BITS;
+    uint64_t mantissa = (ns >> shift) - SUB_COUNT; // The SUB_BITS bits below the leading one
+    return static_cast<size_t>((static_cast<uint64_t>(shift + 1) << SUB_BITS) + mantissa);
+}
+
+uint64_t LatencyHistogram::bucketHighest(size_t bucket)
+{
+    if (bucket < SUB_COUNT)
+        return bucket;
+    int shift = static_cast<int>(bucket >> SUB_BITS) - 1;
+    uint64_t mantissa = bucket & (SUB_COUNT - 1);
+    return ((SUB_COUNT + mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    ++buckets[bucketOf(ns)];
+    ++total;
+    sum += ns;
+    minimum = std::min(minimum, ns);
+    maximum = std::max(maximum, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < BUCKETS; ++i)
+        buckets[i] += other.buckets[i];
+    total += other.total;
+    sum += other.sum;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+void LatencyHistogram::reset()
+{
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (total == 0)
+        return 0;
+    // Rank of the sample, 1-based, so p0 is the smallest and p100 the largest
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 100.0) / 100.0 * total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::clamp(bucketHighest(i), minimum, maximum);
+    }
+    return maximum;
+}
+
+void LatencyHistogram::printTable(std::ostream &out, const Named &histograms)
+{
+    auto us = [](uint64_t ns)
+    { return ns / 1000.0; };
+    // The name column fits the longest name, e.g. WAIT_REGION_CHANGE
+    size_t nameWidth = 14;
+    for (const auto &entry : histograms)
+        nameWidth = std::max(nameWidth, entry.first.size() + 1);
+    const int width = static_cast<int>(nameWidth);
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(width) << "" << std::right << std::setw(10) << "count" << std::setw(11) << "min us"
+        << std::setw(11) << "p50 us" << std::setw(11) << "p90 us" << std::setw(11) << "p99 us" << std::setw(11)
+        << "max us" << std::endl;
+    for (const auto &[name, histogram] : histograms)
+    {
+        if (histogram->count() == 0)
+            continue;
+        out << std::left << std::setw(width) << name << std::right << std::setw(10) << histogram->count()
+            << std::setw(11) << us(histogram->min()) << std::setw(11) << us(histogram->percentile(50))
+            << std::setw(11) << us(histogram->percentile(90)) << std::setw(11) << us(histogram->percentile(99))
+            << std::setw(11) << us(histogram->max()) << std::endl;
+    }
+}
+
+void LatencyHistogram::writeJson(std::ostream &out, const Named &histograms, int indent)
+{
+    std::string pad(indent, ' ');
+    out << "{";
+    for (size_t i = 0; i < histograms.size(); ++i)
+    {
+        const LatencyHistogram &h = *histograms[i].second;
+        out << (i ? "," : "") << "\n"
+            << pad << "  \"" << histograms[i].first << "\": {\"count\": " << h.count() << ", \"min\": " << h.min()
+            << ", \"p50\": " << h.percentile(50) << ", \"p90\": " << h.percentile(90)
+            << ", \"p99\": " << h.percentile(99) << ", \"max\": " << h.max() << ", \"mean\": " << std::fixed
+            << std::setprecision(1) << h.mean() << "}";
+    }
+    out << "\n"
+        << pad << "}";
+}
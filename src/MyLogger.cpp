@@ -1,5 +1,7 @@
 #include "MyLogger.h"
 
+#include "Tracer.h"
+
 // Singleton instance access
 MyLogger &MyLogger::getInstance()
 {
@@ -25,56 +27,235 @@ void MyLogger::setLogFile(const std::string &filePath)
 // Set the minimum log level to output
 void MyLogger::setLogLevel(LogLevel level)
 {
+    currentLogLevel.store(level, std::memory_order_relaxed);
+}
+
+// Start the background writer
+void MyLogger::enableAsync(size_t queueSize, OverflowPolicy policy)
+{
+    if (isAsync())
+    {
+        disableAsync();
+    }
+    queue = std::make_unique<MpscRingBuffer<Record>>(queueSize);
+    overflowPolicy = policy;
+    stopWriter.store(false);
+    writerThread = std::thread(&MyLogger::writerLoop, this);
+    asyncEnabled.store(true, std::memory_order_release);
+}
+
+// Drain the queue and stop the background writer
+void MyLogger::disableAsync()
+{
+    if (!isAsync())
+    {
+        return;
+    }
+    asyncEnabled.store(false);
+    // Producers that already chose the async path still push into the queue
+    while (activeProducers.load() > 0)
+    {
+        std::this_thread::yield();
+    }
+    stopWriter.store(true);
+    wakeWriter();
+    if (writerThread.joinable())
+    {
+        writerThread.join();
+    }
+    queue.reset();
+}
+
+// Block until every queued message has been written
+void MyLogger::flush()
+{
+    TraceSpan span("log", "flush");
+    if (isAsync())
+    {
+        uint64_t target = enqueued.load();
+        while (written.load() < target && writerThread.joinable())
+        {
+            wakeWriter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
     std::lock_guard<std::mutex> lock(logMutex);
-    currentLogLevel = level;
+    if (logFile.is_open())
+    {
+        logFile.flush();
+    }
 }
 
 // Log a message with a specific log level
-void MyLogger::log(LogLevel level, const std::string &message)
+void MyLogger::log(LogLevel level, std::string message)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (level < currentLogLevel)
+    if (level < currentLogLevel.load(std::memory_order_relaxed))
     {
         return;
     }
 
-    std::string logMessage = "[" + logLevelToString(level) + "] " + message;
+    Record record;
+    record.level = level;
+    record.time = std::time(nullptr);
+    record.message = std::move(message);
 
-    // Add timestamp
-    std::time_t now = std::time(nullptr);
-    char timeBuffer[20];
-    std::strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-    logMessage = std::string(timeBuffer) + " " + logMessage;
+    activeProducers.fetch_add(1);
+    if (isAsync())
+    {
+        // Producers never touch the file, the writer thread formats and writes
+        bool pushed = true;
+        while (!queue->tryPush(std::move(record)))
+        {
+            if (overflowPolicy != OverflowPolicy::BLOCK)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                pushed = false;
+                break;
+            }
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        if (pushed)
+        {
+            enqueued.fetch_add(1, std::memory_order_release);
+            if (writerIdle.load(std::memory_order_acquire))
+            {
+                wakeWriter();
+            }
+        }
+        activeProducers.fetch_sub(1);
+        return;
+    }
+    activeProducers.fetch_sub(1);
 
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::string buffer;
+    writeRecord(record, buffer);
     if (logFile.is_open())
     {
-        logFile << logMessage << std::endl;
+        logFile << buffer << std::flush;
     }
     else
     {
-        std::cerr << logMessage << std::endl;
+        std::cerr << buffer;
     }
 }
 
 // Convenience methods for specific log levels
-void MyLogger::info(const std::string &message)
+void MyLogger::info(std::string message)
+{
+    log(LogLevel::LOG_INFO, std::move(message));
+}
+
+void MyLogger::warning(std::string message)
+{
+    log(LogLevel::LOG_WARNING, std::move(message));
+}
+
+void MyLogger::error(std::string message)
+{
+    log(LogLevel::LOG_ERROR, std::move(message));
+}
+
+void MyLogger::debug(std::string message)
 {
-    log(LogLevel::LOG_INFO, message);
+    log(LogLevel::LOG_DEBUG, std::move(message));
 }
 
-void MyLogger::warning(const std::string &message)
+void MyLogger::wakeWriter()
 {
-    log(LogLevel::LOG_WARNING, message);
+    wakeCondition.notify_one();
 }
 
-void MyLogger::error(const std::string &message)
+// Background writer: drain the queue in batches, one file write per batch
+void MyLogger::writerLoop()
 {
-    log(LogLevel::LOG_ERROR, message);
+    Tracer::setThreadName("logger");
+    std::string buffer;
+    Record record;
+    uint64_t reportedDrops = 0;
+
+    for (;;)
+    {
+        size_t count = 0;
+        buffer.clear();
+        {
+            TraceSpan span("log", "write batch", "records");
+            std::lock_guard<std::mutex> lock(logMutex);
+            while (queue->tryPop(record))
+            {
+                writeRecord(record, buffer);
+                ++count;
+            }
+
+            uint64_t drops = dropped.load(std::memory_order_relaxed);
+            if (overflowPolicy == OverflowPolicy::DROP_COUNT && drops != reportedDrops)
+            {
+                Record report;
+                report.level = LogLevel::LOG_WARNING;
+                report.time = std::time(nullptr);
+                report.message = std::to_string(drops - reportedDrops) + " log messages dropped (queue full)";
+                writeRecord(report, buffer);
+                reportedDrops = drops;
+            }
+
+            span.setArg(static_cast<int64_t>(count));
+            if (buffer.empty())
+            {
+                span.cancel(); // Idle wake-up
+            }
+            else
+            {
+                if (logFile.is_open())
+                {
+                    logFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    logFile.flush();
+                }
+                else
+                {
+                    std::cerr << buffer;
+                }
+            }
+        }
+        written.fetch_add(count, std::memory_order_release);
+
+        if (count > 0)
+        {
+            continue;
+        }
+        if (stopWriter.load())
+        {
+            break; // Queue drained after the stop request
+        }
+
+        // Sleep until a producer wakes us, the timeout covers a missed notification
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        writerIdle.store(true, std::memory_order_release);
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(50),
+                               [this]
+                               { return stopWriter.load() || !queue->empty(); });
+        writerIdle.store(false, std::memory_order_release);
+    }
 }
 
-void MyLogger::debug(const std::string &message)
+// Append "<timestamp> [LEVEL] message\n" to buffer
+void MyLogger::writeRecord(const Record &record, std::string &buffer)
 {
-    log(LogLevel::LOG_DEBUG, message);
+    // Consecutive records mostly share the same second, format it once
+    static std::time_t cachedTime = -1;
+    static char timeBuffer[20];
+    if (record.time != cachedTime)
+    {
+        std::strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", std::localtime(&record.time));
+        cachedTime = record.time;
+    }
+
+    buffer += timeBuffer;
+    buffer += " [";
+    buffer += logLevelToString(record.level);
+    buffer += "] ";
+    buffer += record.message;
+    buffer += '\n';
 }
 
 // Private constructor for singleton
@@ -83,6 +264,8 @@ MyLogger::MyLogger() : currentLogLevel(LogLevel::LOG_INFO) {}
 // Destructor
 MyLogger::~MyLogger()
 {
+    // Everything queued is written before the file is closed
+    disableAsync();
     if (logFile.is_open())
     {
         log(LogLevel::LOG_INFO, "System closing, closing log file.");
@@ -106,4 +289,4 @@ std::string MyLogger::logLevelToString(LogLevel level)
     default:
         return "UNKNOWN";
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,179 @@
+#include "PixelKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#define PIXELS_X86 1
+// SSE2 is part of x86-64, 32-bit builds only have it when the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELS_SSE2 1
+#endif
+// The AVX2 kernel is compiled for AVX2 on its own and only called after the CPU check
+#if defined(_MSC_VER) && !defined(__clang__)
+#define PIXELS_AVX2_TARGET
+#else
+#define PIXELS_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+    using CountFunction = size_t (*)(const uint32_t *, const uint32_t *, size_t, uint8_t);
+
+    size_t countDifferentScalar(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance)
+    {
+        size_t different = 0;
+        for (size_t i = 0; i < count; ++i)
+            different += pixels::differs(a[i], b[i], tolerance);
+        return different;
+    }
+
+#ifdef PIXELS_SSE2
+    size_t countDifferentSse2(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance)
+    {
+        const __m128i limit = _mm_set1_epi8(static_cast<char>(tolerance));
+        const __m128i colour = _mm_set1_epi32(0x00FFFFFF); // Alpha is not compared
+        const __m128i zero = _mm_setzero_si128();
+        __m128i same = zero; // Per lane: minus the number of pixels within the tolerance
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            // |x - y| per channel with saturating subtractions, then what is left above the tolerance
+            __m128i delta = _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+            __m128i over = _mm_and_si128(_mm_subs_epu8(delta, limit), colour);
+            // All ones (-1) for a pixel with nothing left over
+            same = _mm_add_epi32(same, _mm_cmpeq_epi32(over, zero));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), same);
+        size_t matched = static_cast<size_t>(-(static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3]));
+        return i - matched + countDifferentScalar(a + i, b + i, count - i, tolerance);
+    }
+#endif
+
+#ifdef PIXELS_X86
+    PIXELS_AVX2_TARGET size_t countDifferentAvx2(const uint32_t *a, const uint32_t *b, size_t count,
+                                                 uint8_t tolerance)
+    {
+        const __m256i limit = _mm256_set1_epi8(static_cast<char>(tolerance));
+        const __m256i colour = _mm256_set1_epi32(0x00FFFFFF);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i same = zero;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i delta = _mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x));
+            __m256i over = _mm256_and_si256(_mm256_subs_epu8(delta, limit), colour);
+            same = _mm256_add_epi32(same, _mm256_cmpeq_epi32(over, zero));
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), same);
+        int64_t sum = 0;
+        for (int32_t lane : lanes)
+            sum += lane;
+        return i - static_cast<size_t>(-sum) + countDifferentScalar(a + i, b + i, count - i, tolerance);
+    }
+
+    bool cpuHasAvx2()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        // The OS must also save the YMM registers (OSXSAVE, XCR0 bits 1 and 2)
+        __cpuid(info, 1);
+        if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    CountFunction kernelFunction(pixels::Kernel kernel)
+    {
+        switch (kernel)
+        {
+#ifdef PIXELS_X86
+        case pixels::Kernel::AVX2:
+            return countDifferentAvx2;
+#endif
+#ifdef PIXELS_SSE2
+        case pixels::Kernel::SSE2:
+            return countDifferentSse2;
+#endif
+        default:
+            return countDifferentScalar;
+        }
+    }
+}
+
+namespace pixels
+{
+    Kernel best()
+    {
+        static const Kernel kernel = supported(Kernel::AVX2)   ? Kernel::AVX2
+                                     : supported(Kernel::SSE2) ? Kernel::SSE2
+                                                               : Kernel::SCALAR;
+        return kernel;
+    }
+
+    bool supported(Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Kernel::SCALAR:
+            return true;
+        case Kernel::SSE2:
+#ifdef PIXELS_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case Kernel::AVX2:
+#ifdef PIXELS_X86
+        {
+            static const bool avx2 = cpuHasAvx2();
+            return avx2;
+        }
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    const char *kernelName(Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Kernel::SSE2:
+            return "SSE2";
+        case Kernel::AVX2:
+            return "AVX2";
+        case Kernel::SCALAR:
+        default:
+            return "SCALAR";
+        }
+    }
+
+    size_t countDifferent(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance)
+    {
+        static const CountFunction function = kernelFunction(best());
+        return function(a, b, count, tolerance);
+    }
+
+    size_t countDifferent(const uint32_t *a, const uint32_t *b, size_t count, uint8_t tolerance, Kernel kernel)
+    {
+        return kernelFunction(kernel)(a, b, count, tolerance);
+    }
+}
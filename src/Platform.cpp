@@ -0,0 +1,113 @@
+#include "Platform.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <timeapi.h> // For timeBeginPeriod
+#else
+#include <unistd.h>
+#endif
+
+namespace platform
+{
+    void sleepMs(int milliseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+
+    void clearScreen()
+    {
+#ifdef _WIN32
+        // Console API instead of spawning cmd for "cls"
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (console == INVALID_HANDLE_VALUE || !GetConsoleScreenBufferInfo(console, &info))
+        {
+            return; // Redirected output, nothing to clear
+        }
+        DWORD cells = static_cast<DWORD>(info.dwSize.X) * info.dwSize.Y;
+        DWORD written = 0;
+        COORD home = {0, 0};
+        FillConsoleOutputCharacterA(console, ' ', cells, home, &written);
+        FillConsoleOutputAttribute(console, info.wAttributes, cells, home, &written);
+        SetConsoleCursorPosition(console, home);
+#else
+        // ANSI: clear screen and move the cursor home, not into redirected output
+        if (!isatty(STDOUT_FILENO))
+        {
+            return;
+        }
+        std::cout << "\033[2J\033[H" << std::flush;
+#endif
+    }
+
+    void setConsoleTitle(const std::string &title)
+    {
+#ifdef _WIN32
+        SetConsoleTitle(title.c_str());
+#else
+        // xterm compatible title sequence, only when attached to a terminal
+        if (isatty(STDOUT_FILENO))
+            std::cout << "\033]0;" << title << "\007" << std::flush;
+#endif
+    }
+
+    void warningBeep()
+    {
+#ifdef _WIN32
+        MessageBeep(MB_ICONWARNING);
+#else
+        std::cout << '\a' << std::flush;
+#endif
+    }
+
+    void beginHighResolutionTimer()
+    {
+#ifdef _WIN32
+        timeBeginPeriod(1);
+#endif
+    }
+
+    void endHighResolutionTimer()
+    {
+#ifdef _WIN32
+        timeEndPeriod(1);
+#endif
+    }
+
+    bool isEscapePressed()
+    {
+#ifdef _WIN32
+        return (GetAsyncKeyState(VK_ESCAPE) & 0x8000) != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool isPauseKeyPressed()
+    {
+#ifdef _WIN32
+        return (GetAsyncKeyState(VK_PAUSE) & 0x8000) != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool getCursorPosition(int &x, int &y)
+    {
+#ifdef _WIN32
+        POINT p;
+        if (!GetCursorPos(&p))
+            return false;
+        x = p.x;
+        y = p.y;
+        return true;
+#else
+        x = y = 0;
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,134 @@
+#include "Program.h"
+
+#include <limits>
+#include <utility>
+
+void Program::clear()
+{
+    code.clear();
+    pool.clear();
+    symbolTable.clear();
+    textTable.clear();
+    waitTable.clear();
+}
+
+size_t Program::emit(OpCode op)
+{
+    Instruction instruction;
+    instruction.op = op;
+    code.push_back(instruction);
+    return code.size() - 1;
+}
+
+size_t Program::emitPoint(OpCode op, int x, int y)
+{
+    constexpr int lo = std::numeric_limits<int16_t>::min();
+    constexpr int hi = std::numeric_limits<int16_t>::max();
+
+    Instruction instruction;
+    instruction.op = op;
+    if (x >= lo && x <= hi && y >= lo && y <= hi)
+    {
+        instruction.flags = OPERAND_INLINE;
+        instruction.operand = static_cast<uint32_t>(static_cast<uint16_t>(x)) |
+                              (static_cast<uint32_t>(static_cast<uint16_t>(y)) << 16);
+    }
+    else
+    {
+        instruction.flags = OPERAND_POOLED;
+        instruction.operand = static_cast<uint32_t>(pool.size());
+        pool.push_back(x);
+        pool.push_back(y);
+    }
+    code.push_back(instruction);
+    return code.size() - 1;
+}
+
+size_t Program::emitValue(OpCode op, uint32_t value, uint16_t aux)
+{
+    Instruction instruction;
+    instruction.op = op;
+    instruction.aux = aux;
+    instruction.operand = value;
+    code.push_back(instruction);
+    return code.size() - 1;
+}
+
+uint32_t Program::addText(const std::string &text)
+{
+    textTable.push_back(text);
+    return static_cast<uint32_t>(textTable.size() - 1);
+}
+
+uint32_t Program::addWait(const WaitSpec &wait)
+{
+    waitTable.push_back(wait);
+    return static_cast<uint32_t>(waitTable.size() - 1);
+}
+
+void Program::assign(std::vector<Instruction> instructions, std::vector<int32_t> operands, std::vector<Symbol> symbols,
+                     std::vector<std::string> texts, std::vector<WaitSpec> waits)
+{
+    code = std::move(instructions);
+    pool = std::move(operands);
+    symbolTable = std::move(symbols);
+    textTable = std::move(texts);
+    waitTable = std::move(waits);
+}
+
+bool Program::validate() const
+{
+    // The main program ends at the first HALT, subroutines must end with RET
+    size_t halt = 0;
+    while (halt < code.size() && code[halt].op != OpCode::HALT)
+        ++halt;
+    if (halt == code.size() || (halt + 1 < code.size() && code.back().op != OpCode::RET))
+        return false;
+
+    // Every REPEAT needs the END_REPEAT that jumps back to its body
+    std::vector<bool> closed(code.size() + 1, false);
+    for (size_t pc = 0; pc < code.size(); ++pc)
+    {
+        const Instruction &instruction = code[pc];
+        if (instruction.op == OpCode::END_REPEAT && instruction.operand <= code.size())
+            closed[instruction.operand] = true;
+    }
+
+    for (size_t pc = 0; pc < code.size(); ++pc)
+    {
+        const Instruction &instruction = code[pc];
+        if (instruction.op == OpCode::REPEAT && !closed[pc + 1])
+            return false;
+        if (instruction.op > OpCode::HALT)
+            return false;
+        if ((instruction.flags & OPERAND_POOLED) && static_cast<size_t>(instruction.operand) + 2 > pool.size())
+            return false;
+        if (instruction.op == OpCode::END_REPEAT &&
+            (instruction.operand == 0 || instruction.operand > pc || code[instruction.operand - 1].op != OpCode::REPEAT))
+            return false;
+        if (instruction.op == OpCode::CALL && (instruction.operand <= halt || instruction.operand >= code.size()))
+            return false;
+        if ((instruction.op == OpCode::TYPE_TEXT || instruction.op == OpCode::PASTE_TEXT) &&
+            instruction.operand >= textTable.size())
+            return false;
+        if (instruction.op >= OpCode::WAIT_FILE && instruction.op <= OpCode::WAIT_REGION_CHANGE)
+        {
+            if (instruction.operand >= waitTable.size())
+                return false;
+            const WaitSpec &wait = waitTable[instruction.operand];
+            const bool screen = instruction.op >= OpCode::WAIT_PIXEL;
+            if (wait.policy > WaitPolicy::STOP || screen != ((wait.flags & WAIT_SCREEN) != 0))
+                return false;
+            if (screen ? wait.width == 0 || wait.height == 0 : wait.directory >= textTable.size())
+                return false;
+            if (instruction.op == OpCode::WAIT_FILE && wait.pattern >= textTable.size())
+                return false;
+        }
+    }
+    for (const auto &symbol : symbolTable)
+    {
+        if (symbol.address <= halt || symbol.address >= code.size())
+            return false;
+    }
+    return true;
+}
\ No newline at end of file
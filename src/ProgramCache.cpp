@@ -0,0 +1,218 @@
+#include "ProgramCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Hash.h"
+#include "MyLogger.h"
+#include "ScriptParser.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr char MAGIC[4] = {'C', 'L', 'K', 'C'};
+    constexpr uint32_t ENDIAN_TAG = 0x01020304;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t endianTag;
+        uint32_t instructionSize; // sizeof(Instruction) when written
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint64_t sourceHash;
+        uint64_t instructionCount;
+        uint64_t poolCount;
+        uint64_t symbolBytes; // Symbol table: per entry uint32 address, uint32 length, name bytes
+        uint64_t textBytes;   // Text table: per entry uint32 length, text bytes
+        uint64_t waitCount;   // Wait table, WaitSpec records
+    };
+}
+
+namespace ProgramCache
+{
+    std::string cachePathFor(const std::string &scriptPath)
+    {
+        return scriptPath + "c";
+    }
+
+    bool stamp(const std::string &scriptPath, SourceStamp &stamp)
+    {
+        std::error_code ec;
+        stamp.size = fs::file_size(scriptPath, ec);
+        if (ec)
+            return false;
+        auto time = fs::last_write_time(scriptPath, ec);
+        if (ec)
+            return false;
+        stamp.mtime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    bool load(const std::string &scriptPath, Program &program)
+    {
+        std::string cachePath = cachePathFor(scriptPath);
+        SourceStamp current;
+        if (!fs::exists(cachePath) || !stamp(scriptPath, current))
+            return false;
+
+        // One read for the whole cache, no parsing
+        std::string data;
+        if (!readWholeFile(cachePath, data) || data.size() < sizeof(CacheHeader))
+            return false;
+
+        CacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+            header.endianTag != ENDIAN_TAG || header.instructionSize != sizeof(Instruction))
+        {
+            MYLOG_INFO("Ignoring cache {} written by another format version", cachePath);
+            return false;
+        }
+        if (header.sourceSize != current.size)
+            return false;
+        if (header.sourceMtime != current.mtime)
+        {
+            // Touched but maybe unchanged, fall back to comparing the content hash
+            std::string source;
+            if (!readWholeFile(scriptPath, source) || hash64(source.data(), source.size()) != header.sourceHash)
+                return false;
+        }
+
+        size_t codeBytes = header.instructionCount * sizeof(Instruction);
+        size_t poolBytes = header.poolCount * sizeof(int32_t);
+        size_t waitBytes = header.waitCount * sizeof(WaitSpec);
+        if (data.size() != sizeof(header) + codeBytes + poolBytes + header.symbolBytes + header.textBytes + waitBytes)
+        {
+            MYLOG_WARNING("Cache file {} is truncated", cachePath);
+            return false;
+        }
+
+        std::vector<Instruction> code(header.instructionCount);
+        std::vector<int32_t> pool(header.poolCount);
+        const char *cursor = data.data() + sizeof(header);
+        std::memcpy(code.data(), cursor, codeBytes);
+        cursor += codeBytes;
+        if (poolBytes > 0)
+            std::memcpy(pool.data(), cursor, poolBytes);
+        cursor += poolBytes;
+
+        std::vector<Program::Symbol> symbols;
+        const char *symbolsEnd = cursor + header.symbolBytes;
+        while (cursor + 2 * sizeof(uint32_t) <= symbolsEnd)
+        {
+            Program::Symbol symbol;
+            uint32_t length;
+            std::memcpy(&symbol.address, cursor, sizeof(uint32_t));
+            std::memcpy(&length, cursor + sizeof(uint32_t), sizeof(uint32_t));
+            cursor += 2 * sizeof(uint32_t);
+            if (length > static_cast<size_t>(symbolsEnd - cursor))
+                return false;
+            symbol.name.assign(cursor, length);
+            cursor += length;
+            symbols.push_back(std::move(symbol));
+        }
+        cursor = symbolsEnd;
+
+        std::vector<std::string> texts;
+        const char *textsEnd = cursor + header.textBytes;
+        while (cursor + sizeof(uint32_t) <= textsEnd)
+        {
+            uint32_t length;
+            std::memcpy(&length, cursor, sizeof(uint32_t));
+            cursor += sizeof(uint32_t);
+            if (length > static_cast<size_t>(textsEnd - cursor))
+                return false;
+            texts.emplace_back(cursor, length);
+            cursor += length;
+        }
+        cursor = textsEnd;
+
+        std::vector<WaitSpec> waits(header.waitCount);
+        if (waitBytes > 0)
+            std::memcpy(waits.data(), cursor, waitBytes);
+        program.assign(std::move(code), std::move(pool), std::move(symbols), std::move(texts), std::move(waits));
+        if (!program.validate())
+        {
+            MYLOG_WARNING("Cache file {} holds an invalid program", cachePath);
+            program.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool save(const std::string &scriptPath, const SourceStamp &sourceStamp, const std::string &source,
+              const Program &program)
+    {
+        CacheHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.endianTag = ENDIAN_TAG;
+        header.instructionSize = sizeof(Instruction);
+        header.sourceSize = sourceStamp.size;
+        header.sourceMtime = sourceStamp.mtime;
+        header.sourceHash = hash64(source.data(), source.size());
+        header.instructionCount = program.size();
+        header.poolCount = program.operandPool().size();
+
+        std::string symbolData;
+        for (const auto &symbol : program.symbols())
+        {
+            uint32_t length = static_cast<uint32_t>(symbol.name.size());
+            symbolData.append(reinterpret_cast<const char *>(&symbol.address), sizeof(uint32_t));
+            symbolData.append(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+            symbolData += symbol.name;
+        }
+        header.symbolBytes = symbolData.size();
+
+        std::string textData;
+        for (const auto &text : program.texts())
+        {
+            uint32_t length = static_cast<uint32_t>(text.size());
+            textData.append(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+            textData += text;
+        }
+        header.textBytes = textData.size();
+        header.waitCount = program.waits().size();
+
+        // Write to a temporary file first so readers never see a partial cache
+        std::string cachePath = cachePathFor(scriptPath);
+        std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                MYLOG_WARNING("Failed to write cache file {}", cachePath);
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(program.data()),
+                       static_cast<std::streamsize>(program.size() * sizeof(Instruction)));
+            file.write(reinterpret_cast<const char *>(program.operandPool().data()),
+                       static_cast<std::streamsize>(program.operandPool().size() * sizeof(int32_t)));
+            file.write(symbolData.data(), static_cast<std::streamsize>(symbolData.size()));
+            file.write(textData.data(), static_cast<std::streamsize>(textData.size()));
+            file.write(reinterpret_cast<const char *>(program.waits().data()),
+                       static_cast<std::streamsize>(program.waits().size() * sizeof(WaitSpec)));
+            if (!file)
+            {
+                MYLOG_WARNING("Failed to write cache file {}", cachePath);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(tempPath, cachePath, ec);
+        if (ec)
+        {
+            MYLOG_WARNING("Failed to replace cache file {}: {}", cachePath, ec.message());
+            fs::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,333 @@
+#include "ProgressReporter.h"
+
+#include <cstdio>
+#include <future>
+#include <iostream>
+
+namespace
+{
+    // HH:MM:SS, or --:--:-- when unknown
+    void appendDuration(std::string &out, double seconds)
+    {
+        char text[32];
+        if (seconds < 0)
+        {
+            out += "--:--:--";
+            return;
+        }
+        long long total = static_cast<long long>(seconds + 0.5);
+        std::snprintf(text, sizeof(text), "%02lld:%02lld:%02lld", total / 3600, total / 60 % 60, total % 60);
+        out += text;
+    }
+
+    double percent(const ProgressSample &sample)
+    {
+        return sample.totalRounds > 0 ? 100.0 * sample.round / sample.totalRounds : 0.0;
+    }
+}
+
+// ===== Sinks =====
+
+void TitleProgressSink::publish(const ProgressSample &sample)
+{
+    char text[96];
+    std::snprintf(text, sizeof(text), "ClickScript - Progress: %d/%d (%.1f%%) ETA ",
+                  sample.round, sample.totalRounds, percent(sample));
+    title.assign(text);
+    appendDuration(title, sample.etaSeconds);
+    title += " (Press ESC to stop)";
+    platform::setConsoleTitle(title);
+}
+
+void TerminalProgressSink::publish(const ProgressSample &sample)
+{
+    char text[160];
+    std::snprintf(text, sizeof(text),
+                  "Round %d/%d (%.1f%%) | %.2f rounds/s | %.0f actions/s | last round %.3f s | ETA ",
+                  sample.round, sample.totalRounds, percent(sample), sample.roundsPerSecond,
+                  sample.actionsPerSecond, sample.lastRoundSeconds);
+    line.assign(text);
+    appendDuration(line, sample.etaSeconds);
+    line += '\n';
+    std::cout << line << std::flush;
+}
+
+void TerminalProgressSink::finish(const ProgressSample &sample, bool success)
+{
+    char text[160];
+    std::snprintf(text, sizeof(text), "%s %d/%d rounds, %llu actions in %.3f s (%.2f rounds/s)\n",
+                  success ? "Finished" : "Stopped at", sample.round, sample.totalRounds,
+                  static_cast<unsigned long long>(sample.actions), sample.elapsedSeconds, sample.roundsPerSecond);
+    std::cout << text << std::flush;
+}
+
+FileProgressSink::FileProgressSink(const std::string &path)
+    : out(path, std::ios::app)
+{
+    if (out.is_open() && out.tellp() == 0)
+        out << "elapsed_s,round,total,actions,rounds_per_s,actions_per_s,eta_s,last_round_s\n";
+}
+
+void FileProgressSink::publish(const ProgressSample &sample)
+{
+    char text[192];
+    int length = std::snprintf(text, sizeof(text), "%.3f,%d,%d,%llu,%.3f,%.1f,%.1f,%.6f\n",
+                               sample.elapsedSeconds, sample.round, sample.totalRounds,
+                               static_cast<unsigned long long>(sample.actions), sample.roundsPerSecond,
+                               sample.actionsPerSecond, sample.etaSeconds, sample.lastRoundSeconds);
+    out.write(text, length);
+}
+
+void FileProgressSink::close()
+{
+    out.close();
+}
+
+TaskbarProgressSink::~TaskbarProgressSink()
+{
+    close();
+}
+
+bool TaskbarProgressSink::open()
+{
+    opened = true;
+#ifdef _WIN32
+    window = GetConsoleWindow();
+    if (!window)
+    {
+        MYLOG_WARNING("No console window, continuing without taskbar progress.");
+        return false;
+    }
+    // COM objects belong to the thread that created them, so all taskbar calls stay on the reactor thread
+    if (FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED)))
+    {
+        MYLOG_WARNING("Failed to initialize COM, continuing without taskbar progress.");
+        return false;
+    }
+    if (FAILED(CoCreateInstance(CLSID_TaskbarList, nullptr, CLSCTX_INPROC_SERVER, IID_ITaskbarList3,
+                                (void **)&taskbar)) ||
+        FAILED(taskbar->HrInit()))
+    {
+        MYLOG_WARNING("Failed to create the taskbar list, continuing without taskbar progress.");
+        if (taskbar)
+        {
+            taskbar->Release();
+            taskbar = nullptr;
+        }
+        CoUninitialize();
+        return false;
+    }
+    taskbar->SetProgressState(window, TBPF_NORMAL);
+    available = true;
+#endif
+    return available;
+}
+
+void TaskbarProgressSink::publish(const ProgressSample &sample)
+{
+    if (!opened)
+        open();
+#ifdef _WIN32
+    if (available && sample.totalRounds > 0)
+        taskbar->SetProgressValue(window, sample.round, sample.totalRounds);
+#else
+    (void)sample;
+#endif
+}
+
+void TaskbarProgressSink::finish(const ProgressSample &sample, bool success)
+{
+    publish(sample);
+#ifdef _WIN32
+    if (available)
+    {
+        // Green and full on success, red where it stopped otherwise
+        taskbar->SetProgressState(window, success ? TBPF_NORMAL : TBPF_ERROR);
+        if (success)
+            taskbar->SetProgressValue(window, sample.totalRounds, sample.totalRounds);
+    }
+#else
+    (void)success;
+#endif
+}
+
+void TaskbarProgressSink::close()
+{
+#ifdef _WIN32
+    if (available)
+    {
+        taskbar->SetProgressState(window, TBPF_NOPROGRESS);
+        taskbar->Release();
+        taskbar = nullptr;
+        CoUninitialize();
+    }
+#endif
+    available = false;
+}
+
+std::unique_ptr<ProgressSink> createProgressSink(const std::string &name, const std::string &file)
+{
+    if (name == "TASKBAR")
+        return std::make_unique<TaskbarProgressSink>();
+    if (name == "TITLE")
+        return std::make_unique<TitleProgressSink>();
+    if (name == "TERMINAL")
+        return std::make_unique<TerminalProgressSink>();
+    if (name == "FILE")
+    {
+        auto sink = std::make_unique<FileProgressSink>(file.empty() ? "progress.csv" : file);
+        if (!sink->isOpen())
+        {
+            MYLOG_WARNING("Can not open progress file '{}'.", file);
+            return nullptr;
+        }
+        return sink;
+    }
+    MYLOG_WARNING("Unknown progress sink '{}'.", name);
+    return nullptr;
+}
+
+// ===== Reporter =====
+
+void ProgressReporter::addSink(std::unique_ptr<ProgressSink> sink)
+{
+    if (sink)
+        sinks.push_back(std::move(sink));
+}
+
+void ProgressReporter::addSinks(const std::string &spec, const std::string &file)
+{
+    size_t begin = 0;
+    while (begin <= spec.size())
+    {
+        size_t end = spec.find(',', begin);
+        if (end == std::string::npos)
+            end = spec.size();
+        std::string name = spec.substr(begin, end - begin);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (!name.empty())
+            addSink(createProgressSink(name, file));
+        begin = end + 1;
+    }
+}
+
+bool ProgressReporter::showsFinalState() const
+{
+    for (const auto &sink : sinks)
+    {
+        if (sink->showsFinalState())
+            return true;
+    }
+    return false;
+}
+
+void ProgressReporter::begin(int rounds, const std::atomic<uint64_t> *actions, std::chrono::milliseconds interval)
+{
+    closed = false;
+    totalRounds = rounds;
+    actionCounter = actions;
+    roundsDone.store(0, std::memory_order_relaxed);
+    lastRoundNs.store(0, std::memory_order_relaxed);
+    start = roundEnd = previousTime = clock::now();
+    previousActions = actions ? actions->load(std::memory_order_relaxed) : 0;
+    publishedRound = -1;
+    publishedActions = 0;
+
+    if (sinks.empty() || !reactor.isStarted())
+        return;
+    reactor.post([this]
+                 { tick(); }); // Show 0/N right away
+    timerId = reactor.addTimer(interval, [this]
+                               { tick(); });
+}
+
+void ProgressReporter::roundFinished(int round)
+{
+    auto now = clock::now();
+    lastRoundNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now - roundEnd).count(),
+                      std::memory_order_relaxed);
+    roundEnd = now;
+    roundsDone.store(round, std::memory_order_relaxed);
+}
+
+ProgressSample ProgressReporter::sample()
+{
+    ProgressSample s;
+    auto now = clock::now();
+    s.round = roundsDone.load(std::memory_order_relaxed);
+    s.totalRounds = totalRounds;
+    s.actions = actionCounter ? actionCounter->load(std::memory_order_relaxed) : 0;
+    s.elapsedSeconds = std::chrono::duration<double>(now - start).count();
+    s.roundsPerSecond = s.elapsedSeconds > 0 ? s.round / s.elapsedSeconds : 0;
+
+    double interval = std::chrono::duration<double>(now - previousTime).count();
+    s.actionsPerSecond = interval > 0 ? (s.actions - previousActions) / interval : 0;
+    previousTime = now;
+    previousActions = s.actions;
+
+    s.etaSeconds = s.roundsPerSecond > 0 ? (totalRounds - s.round) / s.roundsPerSecond : -1;
+    s.lastRoundSeconds = lastRoundNs.load(std::memory_order_relaxed) / 1e9;
+    return s;
+}
+
+void ProgressReporter::tick()
+{
+    ProgressSample s = sample();
+    // Nothing happened since the last sample (e.g. inside a long DELAY)
+    if (s.round == publishedRound && s.actions == publishedActions)
+        return;
+    publishedRound = s.round;
+    publishedActions = s.actions;
+    for (const auto &sink : sinks)
+        sink->publish(s);
+}
+
+void ProgressReporter::runOnReactor(const std::function<void()> &work)
+{
+    if (!reactor.isStarted())
+    {
+        work();
+        return;
+    }
+    // Wait for it, this also orders it after any tick already running
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    reactor.post([&]
+                 { work(); done.set_value(); });
+    finished.wait();
+}
+
+void ProgressReporter::finish(bool success)
+{
+    if (closed)
+        return;
+    if (timerId)
+    {
+        reactor.cancelTimer(timerId);
+        timerId = 0;
+    }
+    runOnReactor([this, success]
+                 {
+                     ProgressSample s = sample();
+                     for (const auto &sink : sinks)
+                         sink->finish(s, success); });
+}
+
+void ProgressReporter::close()
+{
+    if (closed)
+        return;
+    closed = true;
+    if (timerId)
+    {
+        reactor.cancelTimer(timerId);
+        timerId = 0;
+    }
+    // Sinks are released on the thread that used them
+    runOnReactor([this]
+                 {
+                     for (const auto &sink : sinks)
+                         sink->close();
+                     sinks.clear(); });
+}
@@ -0,0 +1,148 @@
+#include "RoundVerifier.h"
+
+#include <algorithm>
+
+#include "MyLogger.h"
+#include "Tracer.h"
+
+RoundVerifier::Barrier RoundVerifier::parseBarrier(const std::string &name)
+{
+    if (name == "NEVER")
+        return Barrier::NEVER;
+    if (name == "DISCREPANCY")
+        return Barrier::ON_DISCREPANCY;
+    if (!name.empty() && name != "LAG")
+        MYLOG_WARNING("Unknown verification barrier '{}', using LAG.", name);
+    return Barrier::LAG;
+}
+
+const char *RoundVerifier::barrierName(Barrier barrier)
+{
+    switch (barrier)
+    {
+    case Barrier::NEVER:
+        return "NEVER";
+    case Barrier::LAG:
+        return "LAG";
+    case Barrier::ON_DISCREPANCY:
+        return "DISCREPANCY";
+    }
+    return "UNKNOWN";
+}
+
+RoundVerifier::RoundVerifier(Hook hook, size_t queueSize, Barrier barrier, int lag)
+    : hook(std::move(hook)), capacity(std::max<size_t>(1, queueSize)), barrier(barrier), lag(std::max(1, lag))
+{
+    worker = std::thread(&RoundVerifier::workerLoop, this);
+}
+
+RoundVerifier::~RoundVerifier()
+{
+    finish();
+}
+
+void RoundVerifier::beforeRound(int round)
+{
+    auto start = std::chrono::steady_clock::now();
+    TraceSpan span("verify", "barrier wait", "round", round);
+    std::unique_lock<std::mutex> lock(mtx);
+    switch (barrier)
+    {
+    case Barrier::NEVER:
+        return;
+    case Barrier::LAG:
+        // Rounds are verified in order, so this covers every round up to round - lag
+        verified.wait(lock, [&]
+                      { return lastVerified >= round - lag || stopping; });
+        break;
+    case Barrier::ON_DISCREPANCY:
+        if (!discrepancyPending)
+            return;
+        verified.wait(lock, [&]
+                      { return (pending.empty() && !busy) || stopping; });
+        discrepancyPending = false;
+        break;
+    }
+    waited += std::chrono::steady_clock::now() - start;
+}
+
+void RoundVerifier::submit(int round)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        // Back pressure: never let verification fall more than capacity rounds behind
+        verified.wait(lock, [&]
+                      { return pending.size() < capacity || stopping; });
+        if (stopping)
+            return;
+        pending.push_back(round);
+    }
+    waited += std::chrono::steady_clock::now() - start;
+    queued.notify_one();
+}
+
+void RoundVerifier::finish()
+{
+    if (!worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    queued.notify_one();
+    worker.join();
+    verified.notify_all();
+}
+
+int RoundVerifier::verifiedRounds() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return lastVerified;
+}
+
+uint64_t RoundVerifier::discrepancies() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return discrepancyCount;
+}
+
+void RoundVerifier::workerLoop()
+{
+    Tracer::setThreadName("verifier");
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        queued.wait(lock, [&]
+                    { return !pending.empty() || stopping; });
+        // Drain what is queued even when stopping, every finished round gets verified
+        if (pending.empty())
+            break;
+
+        int round = pending.front();
+        pending.pop_front();
+        busy = true;
+        lock.unlock();
+
+        bool discrepancy = false;
+        try
+        {
+            TraceSpan span("verify", "verify round", "round", round);
+            discrepancy = hook(round);
+        }
+        catch (const std::exception &e)
+        {
+            MYLOG_ERROR("Verification of round {} failed: {}", round, e.what());
+        }
+
+        lock.lock();
+        busy = false;
+        lastVerified = round;
+        if (discrepancy)
+        {
+            ++discrepancyCount;
+            discrepancyPending = true;
+        }
+        verified.notify_all();
+    }
+}
@@ -0,0 +1,224 @@
+#include "ScreenSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+#include "MyLogger.h"
+#include "ScriptParser.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Copy a rectangle of screen into frame, false unless it lies fully inside
+    bool crop(const Frame &screen, int x, int y, int width, int height, Frame &frame)
+    {
+        if (width <= 0 || height <= 0 || x < 0 || y < 0 || width > screen.width - x || height > screen.height - y)
+            return false;
+        frame.width = width;
+        frame.height = height;
+        frame.pixels.resize(static_cast<size_t>(width) * height);
+        for (int row = 0; row < height; ++row)
+        {
+            std::memcpy(frame.pixels.data() + static_cast<size_t>(row) * width,
+                        screen.pixels.data() + static_cast<size_t>(y + row) * screen.width + x,
+                        static_cast<size_t>(width) * sizeof(uint32_t));
+        }
+        return true;
+    }
+}
+
+#ifdef _WIN32
+GdiScreenSource::~GdiScreenSource()
+{
+    releaseBitmap();
+    if (memoryDc)
+        DeleteDC(memoryDc);
+    if (screenDc)
+        ReleaseDC(nullptr, screenDc);
+}
+
+void GdiScreenSource::releaseBitmap()
+{
+    if (!bitmap)
+        return;
+    SelectObject(memoryDc, previous);
+    DeleteObject(bitmap);
+    bitmap = nullptr;
+    bits = nullptr;
+    bitmapWidth = 0;
+    bitmapHeight = 0;
+}
+
+bool GdiScreenSource::capture(int x, int y, int width, int height, Frame &frame)
+{
+    // BitBlt returns black for the parts outside the desktop, refuse them instead
+    int left = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    int top = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    if (width <= 0 || height <= 0 || x < left || y < top || width > GetSystemMetrics(SM_CXVIRTUALSCREEN) + left - x ||
+        height > GetSystemMetrics(SM_CYVIRTUALSCREEN) + top - y)
+        return false;
+
+    if (!screenDc)
+    {
+        screenDc = GetDC(nullptr);
+        memoryDc = screenDc ? CreateCompatibleDC(screenDc) : nullptr;
+        if (!memoryDc)
+        {
+            MYLOG_ERROR("Can not open the screen for capture: {}", GetLastError());
+            return false;
+        }
+    }
+    if (width != bitmapWidth || height != bitmapHeight)
+    {
+        releaseBitmap();
+        BITMAPINFO info{};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = width;
+        info.bmiHeader.biHeight = -height; // Top-down rows, as Frame holds them
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        bitmap = CreateDIBSection(screenDc, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+        if (!bitmap)
+        {
+            MYLOG_ERROR("CreateDIBSection failed: {}", GetLastError());
+            return false;
+        }
+        previous = SelectObject(memoryDc, bitmap);
+        bitmapWidth = width;
+        bitmapHeight = height;
+    }
+
+    if (!BitBlt(memoryDc, 0, 0, width, height, screenDc, x, y, SRCCOPY))
+    {
+        MYLOG_ERROR("BitBlt failed: {}", GetLastError());
+        return false;
+    }
+    GdiFlush(); // The DIB section is only complete once GDI is done with it
+    frame.width = width;
+    frame.height = height;
+    frame.pixels.resize(static_cast<size_t>(width) * height);
+    std::memcpy(frame.pixels.data(), bits, frame.pixels.size() * sizeof(uint32_t));
+    return true;
+}
+#endif
+
+MemoryScreenSource::MemoryScreenSource(int width, int height, uint32_t color)
+{
+    screen.width = std::max(0, width);
+    screen.height = std::max(0, height);
+    screen.pixels.assign(static_cast<size_t>(screen.width) * screen.height, color);
+}
+
+bool MemoryScreenSource::capture(int x, int y, int width, int height, Frame &frame)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return crop(screen, x, y, width, height, frame);
+}
+
+void MemoryScreenSource::fill(int x, int y, int width, int height, uint32_t color)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int left = std::max(0, x);
+    int top = std::max(0, y);
+    int right = std::min(screen.width, x + width);
+    int bottom = std::min(screen.height, y + height);
+    for (int row = top; row < bottom; ++row)
+    {
+        uint32_t *line = screen.pixels.data() + static_cast<size_t>(row) * screen.width;
+        std::fill(line + left, line + std::max(left, right), color);
+    }
+}
+
+bool PpmScreenSource::capture(int x, int y, int width, int height, Frame &frame)
+{
+    // A rewrite changes the modification time or the size, checking costs two stats
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    uintmax_t size = ec ? 0 : fs::file_size(path, ec);
+    if (!ec && (time != loadedTime || size != loadedSize))
+    {
+        // Remembered even if decoding fails, a half written file is read again once it changes
+        loadedTime = time;
+        loadedSize = size;
+        std::string data;
+        Frame next;
+        if (readWholeFile(path, data) && decode(data, next))
+        {
+            screen = std::move(next);
+            loaded = true;
+        }
+    }
+    return loaded && crop(screen, x, y, width, height, frame);
+}
+
+bool PpmScreenSource::decode(const std::string &data, Frame &frame)
+{
+    // Header fields are separated by whitespace and # comments
+    size_t pos = 2;
+    auto field = [&](long &value)
+    {
+        while (pos < data.size() && (data[pos] == '#' || std::isspace(static_cast<unsigned char>(data[pos]))))
+        {
+            if (data[pos] == '#')
+                pos = std::min(data.find('\n', pos), data.size());
+            else
+                ++pos;
+        }
+        auto result = std::from_chars(data.data() + pos, data.data() + data.size(), value);
+        pos = static_cast<size_t>(result.ptr - data.data());
+        return result.ec == std::errc();
+    };
+
+    long width = 0, height = 0, maxval = 0;
+    if (data.compare(0, 2, "P6") != 0 || !field(width) || !field(height) || !field(maxval) || width <= 0 ||
+        height <= 0 || maxval != 255 || pos >= data.size())
+    {
+        MYLOG_WARNING("Screen file is not a binary PPM (P6) with 8-bit samples");
+        return false;
+    }
+    ++pos; // One whitespace byte ends the header
+    size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if ((data.size() - pos) / 3 < count)
+    {
+        MYLOG_WARNING("Screen file is truncated: {}x{} needs {} bytes of pixels", width, height, count * 3);
+        return false;
+    }
+
+    frame.width = static_cast<int>(width);
+    frame.height = static_cast<int>(height);
+    frame.pixels.resize(count);
+    const unsigned char *rgb = reinterpret_cast<const unsigned char *>(data.data() + pos);
+    for (size_t i = 0; i < count; ++i, rgb += 3)
+    {
+        frame.pixels[i] = 0xFF000000u | (static_cast<uint32_t>(rgb[0]) << 16) | (static_cast<uint32_t>(rgb[1]) << 8) |
+                          rgb[2];
+    }
+    return true;
+}
+
+std::shared_ptr<ScreenSource> createScreenSource(const std::string &name, const std::string &file)
+{
+    if (name == "MEMORY")
+        return std::make_shared<MemoryScreenSource>();
+    if (name == "PPM")
+    {
+        if (file.empty())
+            MYLOG_WARNING("Screen source PPM needs Screen_File, every capture will fail.");
+        return std::make_shared<PpmScreenSource>(file);
+    }
+#ifdef _WIN32
+    if (!name.empty() && name != "GDI")
+        MYLOG_WARNING("Unknown screen source '{}', using GDI.", name);
+    return std::make_shared<GdiScreenSource>();
+#else
+    if (!name.empty())
+        MYLOG_WARNING("Screen source '{}' is not available, using {}.", name, file.empty() ? "MEMORY" : "PPM");
+    if (!file.empty())
+        return std::make_shared<PpmScreenSource>(file);
+    return std::make_shared<MemoryScreenSource>();
+#endif
+}
@@ -0,0 +1,161 @@
+#include "ScriptParser.h"
+
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+
+Keyword lookupKeyword(std::string_view word)
+{
+    // The length narrows the candidates down to at most four comparisons
+    switch (word.size())
+    {
+    case 3:
+        if (word == "END")
+            return Keyword::END;
+        if (word == "SUB")
+            return Keyword::SUB;
+        return Keyword::UNKNOWN;
+    case 4:
+        if (word == "LEFT")
+            return Keyword::LEFT;
+        if (word == "CALL")
+            return Keyword::CALL;
+        if (word == "TYPE")
+            return Keyword::TYPE;
+        return Keyword::UNKNOWN;
+    case 5:
+        if (word == "RIGHT")
+            return Keyword::RIGHT;
+        if (word == "DELAY")
+            return Keyword::DELAY;
+        if (word == "ENTER")
+            return Keyword::ENTER;
+        if (word == "PASTE")
+            return Keyword::PASTE;
+        return Keyword::UNKNOWN;
+    case 6:
+        return word == "REPEAT" ? Keyword::REPEAT : Keyword::UNKNOWN;
+    case 9:
+        return word == "WAIT_FILE" ? Keyword::WAIT_FILE : Keyword::UNKNOWN;
+    case 10:
+        return word == "WAIT_PIXEL" ? Keyword::WAIT_PIXEL : Keyword::UNKNOWN;
+    case 15:
+        if (word == "LOOP_NUMBER_KEY")
+            return Keyword::LOOP_NUMBER_KEY;
+        if (word == "WAIT_FILE_COUNT")
+            return Keyword::WAIT_FILE_COUNT;
+        return Keyword::UNKNOWN;
+    case 18:
+        return word == "WAIT_REGION_CHANGE" ? Keyword::WAIT_REGION_CHANGE : Keyword::UNKNOWN;
+    default:
+        return Keyword::UNKNOWN;
+    }
+}
+
+std::string ScriptError::toString(const std::string &filename) const
+{
+    return filename + ":" + std::to_string(line) + ":" + std::to_string(column) + ": " + message;
+}
+
+void LineTokenizer::skipSpace()
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r'))
+        ++pos;
+}
+
+bool LineTokenizer::next(std::string_view &token)
+{
+    skipSpace();
+    tokenStart = pos;
+    if (pos >= text.size())
+        return false;
+    while (pos < text.size() && text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\r')
+        ++pos;
+    token = text.substr(tokenStart, pos - tokenStart);
+    return true;
+}
+
+bool LineTokenizer::nextInt(int &value)
+{
+    std::string_view token;
+    if (!next(token))
+        return false;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+bool LineTokenizer::nextQuoted(std::string &value)
+{
+    skipSpace();
+    tokenStart = pos;
+    if (pos >= text.size() || text[pos] != '"')
+        return false;
+    value.clear();
+    for (size_t i = pos + 1; i < text.size(); ++i)
+    {
+        char ch = text[i];
+        if (ch == '"')
+        {
+            pos = i + 1;
+            return true;
+        }
+        if (ch != '\\')
+        {
+            value += ch;
+            continue;
+        }
+        if (++i == text.size())
+            break;
+        switch (text[i])
+        {
+        case '"':
+        case '\\':
+            value += text[i];
+            break;
+        case 'n':
+            value += '\n';
+            break;
+        case 't':
+            value += '\t';
+            break;
+        default:
+            tokenStart = i - 1; // Point at the bad escape
+            return false;
+        }
+    }
+    return false;
+}
+
+bool LineTokenizer::atEnd()
+{
+    skipSpace();
+    tokenStart = pos;
+    return pos >= text.size();
+}
+
+std::string_view trimLine(std::string_view line)
+{
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos)
+        return {};
+    size_t end = line.find_last_not_of(" \t\r");
+    return line.substr(begin, end - begin + 1);
+}
+
+bool readWholeFile(const std::string &filename, std::string &content)
+{
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+
+    // file_size instead of ftell, which is 32-bit on Windows
+    std::error_code ec;
+    auto size = std::filesystem::file_size(filename, ec);
+    content.resize(ec ? 0 : static_cast<size_t>(size));
+    if (!content.empty())
+    {
+        content.resize(std::fread(content.data(), 1, content.size(), file));
+    }
+    std::fclose(file);
+    return true;
+}
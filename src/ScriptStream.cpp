@@ -0,0 +1,338 @@
+#include "ScriptStream.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "MyLogger.h"
+#include "Program.h"
+#include "Tracer.h"
+
+namespace
+{
+    constexpr size_t READ_BUFFER_BYTES = 1 << 20; // Large sequential reads, lines are copied out one at a time
+
+    // Line reader over one fixed buffer that knows the file offset of every line,
+    // so a REPEAT can go back to its body. Going back into the buffered range
+    // costs nothing, further back reads the file again.
+    class LineReader
+    {
+    public:
+        LineReader() : buffer(READ_BUFFER_BYTES) {}
+
+        bool open(const std::string &path, std::streamoff offset)
+        {
+            in.open(path, std::ios::binary);
+            return in.is_open() && seek(offset);
+        }
+
+        // Offset of the line the next call to next() returns
+        std::streamoff offset() const { return bufferStart + static_cast<std::streamoff>(pos); }
+
+        bool seek(std::streamoff target)
+        {
+            if (target >= bufferStart && target <= bufferStart + static_cast<std::streamoff>(end))
+            {
+                pos = static_cast<size_t>(target - bufferStart);
+                return true;
+            }
+            in.clear();
+            bufferStart = target;
+            pos = end = 0;
+            return static_cast<bool>(in.seekg(target));
+        }
+
+        // Next line without its newline, false at the end of the file
+        bool next(std::string &line)
+        {
+            line.clear();
+            while (true)
+            {
+                if (pos == end && !fill())
+                    return !line.empty();
+                const char *start = buffer.data() + pos;
+                const void *newline = std::memchr(start, '\n', end - pos);
+                if (newline)
+                {
+                    size_t length = static_cast<size_t>(static_cast<const char *>(newline) - start);
+                    line.append(start, length);
+                    pos += length + 1;
+                    return true;
+                }
+                line.append(start, end - pos);
+                pos = end;
+            }
+        }
+
+        bool bad() const { return in.bad(); }
+
+    private:
+        bool fill()
+        {
+            bufferStart += static_cast<std::streamoff>(end);
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            end = static_cast<size_t>(in.gcount());
+            pos = 0;
+            return end > 0;
+        }
+
+        std::ifstream in;
+        std::vector<char> buffer;
+        std::streamoff bufferStart = 0; // File offset of buffer[0]
+        size_t pos = 0;
+        size_t end = 0;
+    };
+}
+
+ScriptStream::ScriptStream(std::string path, size_t queueSize, LineParser parse)
+    : filePath(std::move(path)), parse(std::move(parse)), queue(std::max<size_t>(queueSize / BATCH_ACTIONS, 2))
+{
+}
+
+ScriptStream::~ScriptStream()
+{
+    stop();
+}
+
+bool ScriptStream::open()
+{
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open())
+    {
+        MYLOG_ERROR("Failed to open ClickScript file: {}", filePath);
+        return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (trimLine(line) == "#start")
+        {
+            startOffset = in.tellg();
+            startLine = lineNumber;
+            MYLOG_INFO("Streaming {} from line {}", filePath, startLine + 1);
+            return true;
+        }
+    }
+    MYLOG_ERROR("No #start marker in {}", filePath);
+    return false;
+}
+
+ScriptStream::Next ScriptStream::next(Behavior &behavior)
+{
+    if (!parser.joinable())
+    {
+        if (startOffset < 0)
+            return Next::FAILED;
+        stopping.store(false, std::memory_order_relaxed);
+        pending.count = 0;
+        current.count = 0;
+        currentIndex = 0;
+        parser = std::thread(&ScriptStream::parserLoop, this);
+    }
+
+    if (currentIndex == current.count)
+    {
+        while (!queue.tryPop(current))
+            queue.waitForData();
+        currentIndex = 0;
+        if (current.kind != Next::ACTION)
+        {
+            failure = std::move(current.errors);
+            current.errors.clear();
+            current.count = 0;
+            Next kind = current.kind;
+            current.kind = Next::ACTION;
+            return kind;
+        }
+    }
+    behavior = current.batch[currentIndex++];
+    return Next::ACTION;
+}
+
+void ScriptStream::stop()
+{
+    if (!parser.joinable())
+        return;
+    stopping.store(true, std::memory_order_release);
+    // Make room, a parser blocked on a full queue wakes up and sees the stop
+    Entry discarded;
+    queue.tryPop(discarded);
+    parser.join();
+    while (queue.tryPop(discarded))
+    {
+    }
+    current.count = 0;
+    currentIndex = 0;
+}
+
+bool ScriptStream::push(Entry &&entry)
+{
+    while (!queue.tryPush(std::move(entry)))
+    {
+        if (stopping.load(std::memory_order_acquire))
+            return false;
+        queue.waitForSpace();
+    }
+    return !stopping.load(std::memory_order_acquire);
+}
+
+bool ScriptStream::pushAction(const Behavior &behavior)
+{
+    pending.batch[pending.count++] = behavior;
+    return pending.count < BATCH_ACTIONS || flushBatch();
+}
+
+bool ScriptStream::flushBatch()
+{
+    if (pending.count == 0)
+        return true;
+    pending.kind = Next::ACTION;
+    bool ok = push(std::move(pending));
+    pending.count = 0;
+    return ok;
+}
+
+void ScriptStream::parserLoop()
+{
+    Tracer::setThreadName("script parser");
+    // Passes until stopped, each ends with its own marker. Parse errors are the
+    // same every pass, so only the first one reports them.
+    bool first = true;
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        bool ok;
+        std::vector<ScriptError> errors;
+        {
+            TraceSpan span("parse", "parse pass", "pass", static_cast<int64_t>(passes.load() + 1));
+            ok = parsePass(first, errors);
+        }
+        first = false;
+        if (!flushBatch())
+            return;
+        if (!ok)
+        {
+            // The errors travel with the marker, the consumer never reads parser state
+            Entry failed;
+            failed.kind = Next::FAILED;
+            failed.errors = std::move(errors);
+            push(std::move(failed));
+            return;
+        }
+        passes.fetch_add(1, std::memory_order_relaxed);
+        Entry end;
+        end.kind = Next::END_OF_PASS;
+        if (!push(std::move(end)))
+            return;
+    }
+}
+
+bool ScriptStream::parsePass(bool reportErrors, std::vector<ScriptError> &errors)
+{
+    LineReader in;
+    if (!in.open(filePath, startOffset))
+    {
+        MYLOG_ERROR("Failed to reopen {} for streaming", filePath);
+        return false;
+    }
+
+    // Open REPEAT blocks: repetitions left and where the body starts. A skipped
+    // block (REPEAT 0, or inside one) is read once for its structure only.
+    struct Block
+    {
+        int remaining;
+        bool skipped;
+        size_t line;
+        std::streamoff body;
+    };
+    Block blocks[MAX_NESTING];
+    size_t depth = 0;
+    size_t skipping = 0; // Skipped blocks among the open ones
+    auto fail = [&](size_t lineNumber, const std::string &message)
+    {
+        if (reportErrors)
+        {
+            ScriptError error;
+            error.line = lineNumber;
+            error.column = 1;
+            error.message = message;
+            MYLOG_WARNING("{}", error.toString(filePath));
+            errors.push_back(std::move(error));
+        }
+        return false;
+    };
+
+    std::string line;
+    size_t lineNumber = startLine;
+    while (in.next(line))
+    {
+        ++lineNumber;
+        std::string_view trimmed = trimLine(line);
+        if (trimmed.empty())
+            continue;
+        if (trimmed == "#end")
+            break;
+        if (trimmed == "#start")
+            continue;
+
+        Behavior behavior;
+        if (!parse(line, lineNumber, reportErrors, behavior, errors))
+            return false;
+        behavior.line = static_cast<int>(lineNumber);
+
+        switch (behavior.action)
+        {
+        case NONE:
+            break; // Dropped like in a normal load
+        case REPEAT_BEGIN:
+        {
+            if (depth == MAX_NESTING)
+                return fail(lineNumber, "REPEAT nesting deeper than " + std::to_string(MAX_NESTING) + " levels");
+            bool skipped = skipping > 0 || behavior.count <= 0;
+            blocks[depth++] = {behavior.count, skipped, lineNumber, in.offset()};
+            skipping += skipped;
+            break;
+        }
+        case BLOCK_END:
+        {
+            if (depth == 0)
+                return fail(lineNumber, "END without REPEAT");
+            Block &block = blocks[depth - 1];
+            if (!block.skipped && --block.remaining > 0)
+            {
+                // Read the body again, its lines keep their numbers
+                if (!in.seek(block.body))
+                    return fail(lineNumber, "Read error while streaming");
+                lineNumber = block.line;
+                break;
+            }
+            skipping -= block.skipped;
+            --depth;
+            break;
+        }
+        case SUB_BEGIN:
+        case CALL_SUB:
+            return fail(lineNumber, "SUB / CALL can not be used when streaming a script");
+        case TYPE_TEXT:
+        case PASTE_TEXT:
+            return fail(lineNumber, "TYPE / PASTE can not be used when streaming a script");
+        case WAIT_FILE:
+        case WAIT_FILE_COUNT:
+        case WAIT_PIXEL:
+        case WAIT_REGION_CHANGE:
+            return fail(lineNumber, "WAIT_* commands can not be used when streaming a script");
+        default:
+            if (skipping == 0 && !pushAction(behavior))
+                return false;
+            break;
+        }
+        if (stopping.load(std::memory_order_relaxed))
+            return false;
+    }
+    if (in.bad())
+        return fail(lineNumber, "Read error while streaming");
+    if (depth > 0)
+        return fail(blocks[depth - 1].line, "REPEAT without END");
+    return !stopping.load(std::memory_order_acquire);
+}
@@ -0,0 +1,159 @@
+#include "TextTemplate.h"
+
+#include <charconv>
+#include <ctime>
+
+#include "MyLogger.h"
+
+bool TextTemplate::compile(std::string_view source, const ConfigLookup &config, std::string &message, size_t &offset,
+                           Output mode)
+{
+    pieces.clear();
+    keys.clear();
+    text.clear();
+    needsRoundStartTime = false;
+    const bool typed = mode == Output::KEYS;
+
+    // Adjacent literal text and config values share one run of key events or text
+    std::string literal;
+    auto flushLiteral = [&]
+    {
+        if (literal.empty())
+            return;
+        Piece piece;
+        if (typed)
+        {
+            piece.begin = static_cast<uint32_t>(keys.size());
+            keys.typeText(literal);
+            piece.count = static_cast<uint32_t>(keys.size()) - piece.begin;
+        }
+        else
+        {
+            piece.begin = static_cast<uint32_t>(text.size());
+            piece.count = static_cast<uint32_t>(literal.size());
+            text += literal;
+        }
+        pieces.push_back(piece);
+        literal.clear();
+    };
+    auto fail = [&](size_t at, std::string problem)
+    {
+        offset = at;
+        message = std::move(problem);
+        return false;
+    };
+
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        char ch = source[i];
+        if ((ch == '{' || ch == '}') && i + 1 < source.size() && source[i + 1] == ch)
+        {
+            literal += ch;
+            ++i;
+            continue;
+        }
+        if (ch == '}')
+            return fail(i, "Unmatched }, write }} for a brace");
+        if (ch != '{')
+        {
+            if (typed && keyForChar(ch).vk == 0)
+                return fail(i, "Character " + std::to_string(static_cast<unsigned char>(ch)) +
+                                   " has no key");
+            literal += ch;
+            continue;
+        }
+
+        size_t close = source.find('}', i + 1);
+        if (close == std::string_view::npos)
+            return fail(i, "Unclosed {, write {{ for a brace");
+        std::string_view name = source.substr(i + 1, close - i - 1);
+        if (name == "loop" || name == "round_start_time")
+        {
+            flushLiteral();
+            Piece piece;
+            piece.kind = name == "loop" ? PieceKind::LOOP : PieceKind::ROUND_START_TIME;
+            pieces.push_back(piece);
+            needsRoundStartTime = needsRoundStartTime || piece.kind == PieceKind::ROUND_START_TIME;
+        }
+        else if (name.substr(0, 7) == "config:" && name.size() > 7)
+        {
+            std::string key(name.substr(7));
+            std::string value;
+            if (config && !config(key, value))
+            {
+                MYLOG_WARNING("Placeholder config:{} is not set, left empty", key);
+            }
+            for (char c : value)
+            {
+                if (!typed || keyForChar(c).vk != 0)
+                    literal += c;
+                else
+                    MYLOG_WARNING("Character {} of config value {} has no key, skipped",
+                                  static_cast<int>(static_cast<unsigned char>(c)), key);
+            }
+        }
+        else
+        {
+            return fail(i, "Unknown placeholder: " + std::string(name));
+        }
+        i = close;
+    }
+    flushLiteral();
+    return true;
+}
+
+void TextTemplate::appendTo(InputBatch &batch, const Context &context) const
+{
+    for (const Piece &piece : pieces)
+    {
+        switch (piece.kind)
+        {
+        case PieceKind::LITERAL:
+            batch.append(keys.data() + piece.begin, piece.count);
+            break;
+        case PieceKind::LOOP:
+        {
+            char digits[16];
+            auto result = std::to_chars(digits, digits + sizeof(digits), context.loop);
+            batch.typeText(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+            break;
+        }
+        case PieceKind::ROUND_START_TIME:
+            batch.typeText(context.roundStartTime);
+            break;
+        }
+    }
+}
+
+void TextTemplate::expand(std::string &out, const Context &context) const
+{
+    for (const Piece &piece : pieces)
+    {
+        switch (piece.kind)
+        {
+        case PieceKind::LITERAL:
+            out.append(text, piece.begin, piece.count);
+            break;
+        case PieceKind::LOOP:
+            out += std::to_string(context.loop);
+            break;
+        case PieceKind::ROUND_START_TIME:
+            out += context.roundStartTime;
+            break;
+        }
+    }
+}
+
+std::string TextTemplate::formatClock(std::chrono::system_clock::time_point time)
+{
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    struct tm local_tm;
+#ifdef _WIN32
+    localtime_s(&local_tm, &seconds);
+#else
+    localtime_r(&seconds, &local_tm);
+#endif
+    char text[16];
+    std::strftime(text, sizeof(text), "%H:%M:%S", &local_tm);
+    return text;
+}
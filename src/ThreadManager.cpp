@@ -1,5 +1,31 @@
 #include "ThreadManager.h"
 
+#include <algorithm>
+#include <climits>
+#include <future>
+
+#include "Tracer.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+#ifndef MOD_NOREPEAT
+#define MOD_NOREPEAT 0x4000
+#endif
+    constexpr int HOTKEY_ID_BASE = 0x4353; // Arbitrary, identifies our WM_HOTKEY messages
+#endif
+    constexpr uint64_t WAKE_ID = 0;    // epoll tag of the wake eventfd
+    constexpr int HOTKEY_POLL_MS = 10; // Polling fallback interval
+}
+
 ThreadManager &ThreadManager::getInstance()
 {
     static ThreadManager instance;
@@ -8,110 +34,500 @@ ThreadManager &ThreadManager::getInstance()
 
 ThreadManager::~ThreadManager()
 {
-    stopEmergencyListener();
+    stop();
 }
 
-void ThreadManager::setEmergencyStop(bool stop)
+const char *ThreadManager::runStateName(RunState state)
 {
-    emergencyStop.store(stop);
-    if (stop)
+    switch (state)
     {
-        MyLogger::getInstance().info("Emergency stop activated!");
-        std::cout << "\n*** EMERGENCY STOP ACTIVATED ***" << std::endl;
+    case RunState::IDLE:
+        return "IDLE";
+    case RunState::COUNTDOWN:
+        return "COUNTDOWN";
+    case RunState::RUNNING:
+        return "RUNNING";
+    case RunState::PAUSED:
+        return "PAUSED";
+    case RunState::STOPPING:
+        return "STOPPING";
+    case RunState::STOPPED:
+        return "STOPPED";
+    case RunState::FINISHED:
+        return "FINISHED";
     }
+    return "UNKNOWN";
 }
 
-bool ThreadManager::isEmergencyStop() const
+bool ThreadManager::start()
+{
+    if (reactorThread.joinable())
+        return true;
+
+#ifdef _WIN32
+    wakeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!wakeEvent)
+    {
+        MYLOG_ERROR("Reactor: CreateEvent failed ({})", GetLastError());
+        return false;
+    }
+#else
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0)
+    {
+        MYLOG_ERROR("Reactor: epoll / eventfd setup failed ({})", std::strerror(errno));
+        if (epollFd >= 0)
+            close(epollFd);
+        if (wakeFd >= 0)
+            close(wakeFd);
+        epollFd = wakeFd = -1;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    // Handles registered before start()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const Watch &watch : watches)
+        {
+            event.data.u64 = static_cast<uint64_t>(watch.id);
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, watch.handle, &event);
+        }
+    }
+#endif
+
+    quit.store(false);
+    reactorThread = std::thread(&ThreadManager::reactorLoop, this);
+    MyLogger::getInstance().info("Reactor thread started");
+    return true;
+}
+
+void ThreadManager::stop()
+{
+    if (!reactorThread.joinable())
+        return;
+
+    quit.store(true);
+    wake();
+    reactorThread.join();
+
+#ifdef _WIN32
+    CloseHandle(wakeEvent);
+    wakeEvent = nullptr;
+#else
+    close(epollFd);
+    close(wakeFd);
+    epollFd = wakeFd = -1;
+#endif
+    MyLogger::getInstance().info("Reactor thread stopped");
+}
+
+void ThreadManager::wake()
+{
+#ifdef _WIN32
+    if (wakeEvent)
+        SetEvent(wakeEvent);
+#else
+    if (wakeFd >= 0)
+    {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(wakeFd, &one, sizeof(one));
+    }
+#endif
+}
+
+void ThreadManager::beginRun(CancellationToken *token, int total)
 {
-    return emergencyStop.load();
+    runToken.store(token);
+    setRunState(RunState::COUNTDOWN);
+    hotkeysWanted.store(true);
+    setProgress(0, total);
 }
 
-void ThreadManager::setRunning(bool running)
+void ThreadManager::endRun(RunState finalState)
 {
-    isRunningState.store(running);
+    runToken.store(nullptr);
+    hotkeysWanted.store(false);
+    setRunState(finalState);
+    wake();
+}
+
+void ThreadManager::setRunState(RunState state)
+{
+    RunState previous = runState.exchange(state);
+    if (previous != state)
+        MYLOG_DEBUG("Run state {} -> {}", runStateName(previous), runStateName(state));
+}
+
+ThreadManager::RunStatus ThreadManager::status() const
+{
+    return RunStatus{runState.load(), currentProgress.load(), totalProgress.load()};
 }
 
 bool ThreadManager::isRunning() const
 {
-    return isRunningState.load();
+    RunState state = runState.load();
+    return state == RunState::RUNNING || state == RunState::PAUSED;
+}
+
+bool ThreadManager::isEmergencyStop() const
+{
+    RunState state = runState.load();
+    return state == RunState::STOPPING || state == RunState::STOPPED;
 }
 
 void ThreadManager::setProgress(int current, int total)
 {
-    currentProgress.store(current);
-    totalProgress.store(total);
+    currentProgress.store(current, std::memory_order_relaxed);
+    totalProgress.store(total, std::memory_order_relaxed);
 }
 
-int ThreadManager::getCurrentProgress() const
+void ThreadManager::onHotkey(Hotkey key)
 {
-    return currentProgress.load();
+    CancellationToken *token = runToken.load();
+    if (!token)
+        return;
+
+    switch (key)
+    {
+    case Hotkey::ESCAPE:
+        if (token->stopRequested())
+            return;
+        // Wake the engine first, it stops before its next action or inside the current delay
+        token->requestStop();
+        setRunState(RunState::STOPPING);
+
+        std::cout << "\n=== EMERGENCY STOP ACTIVATED ===\n"
+                  << std::endl;
+        std::cout << "ESC key detected! Stopping all operations..." << std::endl;
+        MYLOG_INFO("Emergency stop activated by ESC key.");
+        platform::warningBeep();
+        break;
+
+    case Hotkey::PAUSE:
+        if (token->isPaused())
+        {
+            token->resume();
+            setRunState(RunState::RUNNING);
+            std::cout << "=== RESUMED ===" << std::endl;
+        }
+        else if (runState.load() == RunState::RUNNING)
+        {
+            token->pause();
+            if (token->isPaused())
+            {
+                setRunState(RunState::PAUSED);
+                std::cout << "=== PAUSED (press Pause to resume, ESC to stop) ===" << std::endl;
+            }
+        }
+        break;
+    }
 }
 
-int ThreadManager::getTotalProgress() const
+int ThreadManager::addTimer(std::chrono::milliseconds interval, Callback callback, bool repeat)
 {
-    return totalProgress.load();
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        id = nextId++;
+        timers.push_back(Timer{id, clock::now() + interval, interval, std::move(callback), repeat});
+    }
+    wake(); // The new deadline may be earlier than the one being waited for
+    return id;
 }
 
-void ThreadManager::startEmergencyListener()
+void ThreadManager::cancelTimer(int id)
 {
-    if (!emergencyThread.joinable())
+    std::lock_guard<std::mutex> lock(mtx);
+    timers.erase(std::remove_if(timers.begin(), timers.end(), [id](const Timer &t)
+                                { return t.id == id; }),
+                 timers.end());
+}
+
+int ThreadManager::addHandle(NativeHandle handle, Callback callback)
+{
+    int id;
     {
-        shouldStopListener.store(false);
-        emergencyThread = std::thread(&ThreadManager::emergencyListenerThread, this);
-        MyLogger::getInstance().info("Emergency listener thread started");
+        std::lock_guard<std::mutex> lock(mtx);
+        id = nextId++;
+        watches.push_back(Watch{id, handle, std::move(callback)});
+#ifndef _WIN32
+        if (epollFd >= 0)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = static_cast<uint64_t>(id);
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, handle, &event);
+        }
+#endif
     }
+    wake(); // The Windows wait set is rebuilt on every iteration
+    return id;
 }
 
-void ThreadManager::stopEmergencyListener()
+void ThreadManager::removeHandle(int id)
 {
-    shouldStopListener.store(true);
-    if (emergencyThread.joinable())
     {
-        emergencyThread.join();
-        MyLogger::getInstance().info("Emergency listener thread stopped");
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = std::find_if(watches.begin(), watches.end(), [id](const Watch &w)
+                               { return w.id == id; });
+        if (it == watches.end())
+            return;
+#ifndef _WIN32
+        if (epollFd >= 0)
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, it->handle, nullptr);
+#endif
+        watches.erase(it);
     }
+    wake();
 }
 
-void ThreadManager::reset()
+void ThreadManager::post(Callback callback)
 {
-    emergencyStop.store(false);
-    isRunningState.store(false);
-    currentProgress.store(0);
-    totalProgress.store(0);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        posted.push_back(std::move(callback));
+    }
+    wake();
 }
 
-void ThreadManager::emergencyListenerThread()
+void ThreadManager::sync()
 {
-    MyLogger::getInstance().debug("Emergency listener thread running");
+    if (!reactorThread.joinable() || std::this_thread::get_id() == reactorThread.get_id())
+        return;
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    post([&done]
+         { done.set_value(); });
+    finished.wait();
+}
 
-    while (!shouldStopListener.load())
+int ThreadManager::nextTimeoutMs()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!posted.empty())
+        return 0;
+    if (timers.empty())
+        return -1; // Nothing scheduled, sleep until woken
+
+    auto earliest = timers.front().deadline;
+    for (const Timer &timer : timers)
+        earliest = std::min(earliest, timer.deadline);
+
+    auto remaining = earliest - clock::now();
+    if (remaining <= clock::duration::zero())
+        return 0;
+    // Round up so a timer never fires early
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    return static_cast<int>(std::min<long long>(ms, INT_MAX));
+}
+
+void ThreadManager::runDueTimers()
+{
+    std::vector<Callback> due;
     {
-        // Check ESC key state
-        if (GetAsyncKeyState(VK_ESCAPE) & 0x8000)
+        std::lock_guard<std::mutex> lock(mtx);
+        auto now = clock::now();
+        for (Timer &timer : timers)
         {
-            if (isRunning())
+            if (timer.deadline > now)
+                continue;
+            due.push_back(timer.callback);
+            if (!timer.repeat)
             {
-                setEmergencyStop(true);
+                timer.deadline = clock::time_point::max(); // Fired, removed below
+                continue;
+            }
+            // Stay on the original cadence unless a whole interval was missed
+            timer.deadline += timer.interval;
+            if (timer.deadline <= now)
+                timer.deadline = now + timer.interval;
+        }
+        timers.erase(std::remove_if(timers.begin(), timers.end(), [](const Timer &t)
+                                    { return t.deadline == clock::time_point::max(); }),
+                     timers.end());
+    }
+    for (Callback &callback : due)
+        callback();
+}
+
+void ThreadManager::runPosted()
+{
+    std::vector<Callback> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.swap(posted);
+    }
+    for (Callback &callback : pending)
+        callback();
+}
+
+void ThreadManager::dispatchHandle(int id)
+{
+    Callback callback;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const Watch &watch : watches)
+        {
+            if (watch.id == id)
+            {
+                callback = watch.callback;
                 break;
             }
         }
+    }
+    if (callback)
+        callback();
+}
+
+void ThreadManager::updateHotkeys()
+{
+    bool wanted = hotkeysWanted.load();
+    if (wanted == hotkeysArmed)
+        return;
+    hotkeysArmed = wanted;
+
+    if (wanted)
+    {
+#ifdef _WIN32
+        // Hotkeys are delivered as WM_HOTKEY to this thread, no polling needed
+        bool escape = RegisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::ESCAPE), MOD_NOREPEAT, VK_ESCAPE) != 0;
+        bool pause = RegisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::PAUSE), MOD_NOREPEAT, VK_PAUSE) != 0;
+        if (escape && pause)
+            return;
+
+        // Another program owns one of the keys, fall back to polling the key state
+        MYLOG_WARNING("Reactor: RegisterHotKey failed ({}), polling ESC / Pause every {} ms",
+                      GetLastError(), HOTKEY_POLL_MS);
+        UnregisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::ESCAPE));
+        UnregisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::PAUSE));
+        pauseKeyDown = platform::isPauseKeyPressed();
+        hotkeyPollTimer = addTimer(std::chrono::milliseconds(HOTKEY_POLL_MS), [this]
+                                   { pollHotkeys(); });
+#else
+        MYLOG_DEBUG("Reactor: no global hotkey source on this platform, ESC / Pause are unavailable");
+#endif
+    }
+    else
+    {
+#ifdef _WIN32
+        UnregisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::ESCAPE));
+        UnregisterHotKey(nullptr, HOTKEY_ID_BASE + int(Hotkey::PAUSE));
+#endif
+        if (hotkeyPollTimer)
+        {
+            cancelTimer(hotkeyPollTimer);
+            hotkeyPollTimer = 0;
+        }
+    }
+}
+
+void ThreadManager::pollHotkeys()
+{
+    if (platform::isEscapePressed())
+        onHotkey(Hotkey::ESCAPE);
+
+    // Pause toggles on its press edge
+    bool down = platform::isPauseKeyPressed();
+    if (down && !pauseKeyDown)
+        onHotkey(Hotkey::PAUSE);
+    pauseKeyDown = down;
+}
+
+void ThreadManager::reactorLoop()
+{
+    Tracer::setThreadName("reactor");
+    MyLogger::getInstance().debug("Reactor thread running");
+
+#ifdef _WIN32
+    MSG msg;
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE); // Create the message queue for WM_HOTKEY
+    std::vector<HANDLE> waitHandles;
+    std::vector<int> waitIds;
+#else
+    epoll_event events[16];
+#endif
+
+    while (!quit.load())
+    {
+        updateHotkeys();
+        int timeoutMs = nextTimeoutMs();
+
+#ifdef _WIN32
+        waitHandles.assign(1, wakeEvent);
+        waitIds.assign(1, 0);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const Watch &watch : watches)
+            {
+                if (waitHandles.size() >= MAXIMUM_WAIT_OBJECTS - 1)
+                    break;
+                waitHandles.push_back(watch.handle);
+                waitIds.push_back(watch.id);
+            }
+        }
 
-        // Display progress (if running)
-        if (isRunning())
+        DWORD count = static_cast<DWORD>(waitHandles.size());
+        DWORD result = MsgWaitForMultipleObjects(count, waitHandles.data(), FALSE,
+                                                 timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs),
+                                                 QS_ALLINPUT);
+        if (result == WAIT_FAILED)
         {
-            int current = getCurrentProgress();
-            int total = getTotalProgress();
-            if (total > 0)
+            MYLOG_ERROR("Reactor: MsgWaitForMultipleObjects failed ({})", GetLastError());
+            break;
+        }
+        if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + count)
+        {
+            dispatchHandle(waitIds[result - WAIT_OBJECT_0]);
+        }
+        else if (result == WAIT_OBJECT_0 + count)
+        {
+            while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
             {
-                // Update console title to show progress
-                std::string title = "ISC - Progress: " + std::to_string(current) + "/" + std::to_string(total) + " (Press ESC to stop)";
-                SetConsoleTitle(title.c_str());
+                if (msg.message == WM_HOTKEY)
+                    onHotkey(static_cast<Hotkey>(int(msg.wParam) - HOTKEY_ID_BASE));
             }
         }
+#else
+        int ready = epoll_wait(epollFd, events, 16, timeoutMs);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            MYLOG_ERROR("Reactor: epoll_wait failed ({})", std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.u64 == WAKE_ID)
+            {
+                uint64_t count;
+                [[maybe_unused]] ssize_t drained = read(wakeFd, &count, sizeof(count));
+            }
+            else
+            {
+                dispatchHandle(static_cast<int>(events[i].data.u64));
+            }
+        }
+#endif
 
-        // 50ms check interval
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (quit.load())
+            break;
+        runPosted();
+        runDueTimers();
     }
 
-    MyLogger::getInstance().debug("Emergency listener thread exiting");
-}
\ No newline at end of file
+    // Work posted before stop() still runs, so shutdown is deterministic
+    runPosted();
+
+    // Never leave the keys registered once the reactor is gone
+    hotkeysWanted.store(false);
+    updateHotkeys();
+
+    MyLogger::getInstance().debug("Reactor thread exiting");
+}
@@ -0,0 +1,76 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "Tracer.h"
+
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+bool ThreadPool::runOne(std::unique_lock<std::mutex> &lock, Job &job)
+{
+    if (job.next >= job.count)
+        return false;
+    size_t index = job.next++;
+    if (job.next == job.count)
+        jobs.erase(std::find(jobs.begin(), jobs.end(), &job)); // Nothing left to hand out
+
+    lock.unlock();
+    (*job.body)(index);
+    lock.lock();
+
+    if (++job.finished == job.count)
+        jobDone.notify_all();
+    return true;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &body)
+{
+    if (count == 0)
+        return;
+
+    Job job;
+    job.body = &body;
+    job.count = count;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    jobs.push_back(&job);
+    wakeWorkers.notify_all();
+
+    // Work on our own job instead of only waiting for it
+    while (runOne(lock, job))
+    {
+    }
+    jobDone.wait(lock, [&]
+                 { return job.finished == job.count; });
+}
+
+void ThreadPool::workerLoop()
+{
+    Tracer::setThreadName("pool worker");
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        wakeWorkers.wait(lock, [&]
+                         { return stopping || !jobs.empty(); });
+        if (stopping)
+            return;
+        runOne(lock, *jobs.front());
+    }
+}
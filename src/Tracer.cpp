@@ -0,0 +1,199 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "MyLogger.h"
+
+std::atomic<bool> Tracer::active{false};
+
+// Ties a thread to its buffer and retires the buffer when the thread exits
+struct TracerRegistration
+{
+    Tracer::ThreadBuffer *buffer = nullptr;
+    const char *name = nullptr; // Set before the buffer exists
+
+    ~TracerRegistration()
+    {
+        if (buffer)
+            buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+namespace
+{
+    thread_local TracerRegistration t_registration;
+}
+
+Tracer &Tracer::getInstance()
+{
+    // Never destroyed: threads joined during static destruction (the async logger's
+    // writer by ~MyLogger) still retire their buffers when they exit
+    static Tracer *instance = new Tracer;
+    return *instance;
+}
+
+Tracer::ThreadBuffer::~ThreadBuffer()
+{
+    for (auto &chunk : chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+Tracer::ThreadBuffer &Tracer::threadBuffer()
+{
+    if (t_registration.buffer)
+        return *t_registration.buffer;
+
+    // First event or name of this thread, the only time the lock is taken
+    std::lock_guard<std::mutex> lock(mtx);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = nextTid++;
+    buffer->threadName = t_registration.name ? t_registration.name : "thread " + std::to_string(buffer->tid);
+    t_registration.buffer = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return *t_registration.buffer;
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    t_registration.name = name;
+    if (t_registration.buffer)
+    {
+        Tracer &tracer = getInstance();
+        std::lock_guard<std::mutex> lock(tracer.mtx);
+        t_registration.buffer->threadName = name;
+    }
+}
+
+void Tracer::start()
+{
+    active.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        // Buffers of exited threads are not needed any more, live ones are reused
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                     [](const std::unique_ptr<ThreadBuffer> &buffer)
+                                     { return buffer->retired.load(std::memory_order_acquire); }),
+                      buffers.end());
+        // Live buffers are not reset here, a span that began before the flag cleared may
+        // still be appending to one. Each thread resets its own on its first event of the
+        // new generation, until then its old events are not counted.
+        epochNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count(),
+                      std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    active.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    active.store(false, std::memory_order_release);
+}
+
+void Tracer::complete(const char *category, const char *name, clock::time_point begin, clock::time_point end,
+                      const char *argName, int64_t arg)
+{
+    const uint64_t current = generation.load(std::memory_order_acquire);
+    const int64_t beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count();
+    if (beginNs < epochNs.load(std::memory_order_relaxed))
+        return; // Began before start(), part of the previous trace
+
+    ThreadBuffer &buffer = threadBuffer();
+    if (buffer.generation.load(std::memory_order_relaxed) != current)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+        buffer.generation.store(current, std::memory_order_release);
+    }
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    size_t chunkIndex = index / ThreadBuffer::CHUNK_EVENTS;
+    if (chunkIndex >= ThreadBuffer::MAX_CHUNKS)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Event *chunk = buffer.chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new Event[ThreadBuffer::CHUNK_EVENTS];
+        buffer.chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    chunk[index % ThreadBuffer::CHUNK_EVENTS] = {
+        category, name, argName, arg, beginNs,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::isCurrent(const ThreadBuffer &buffer) const
+{
+    return buffer.generation.load(std::memory_order_acquire) == generation.load(std::memory_order_relaxed);
+}
+
+uint64_t Tracer::eventCount() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    uint64_t total = 0;
+    for (const auto &buffer : buffers)
+    {
+        if (isCurrent(*buffer))
+            total += buffer->count.load(std::memory_order_acquire);
+    }
+    return total;
+}
+
+uint64_t Tracer::droppedEvents() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    uint64_t total = 0;
+    for (const auto &buffer : buffers)
+    {
+        if (isCurrent(*buffer))
+            total += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+bool Tracer::write(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        MYLOG_ERROR("Failed to write trace {}", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const int64_t startNs = epochNs.load(std::memory_order_relaxed);
+    char line[512];
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"ClickScript\"}}";
+    for (const auto &buffer : buffers)
+    {
+        size_t count = isCurrent(*buffer) ? buffer->count.load(std::memory_order_acquire) : 0;
+        if (count == 0)
+            continue;
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+            << ", \"args\": {\"name\": \"" << buffer->threadName << "\"}}";
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Event &event = buffer->chunks[i / ThreadBuffer::CHUNK_EVENTS].load(
+                std::memory_order_acquire)[i % ThreadBuffer::CHUNK_EVENTS];
+            // Microsecond timestamps with nanosecond decimals
+            int64_t ts = std::max<int64_t>(event.beginNs - startNs, 0);
+            int length = std::snprintf(line, sizeof(line),
+                                       ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                                       "\"tid\": %u, \"ts\": %lld.%03lld, \"dur\": %lld.%03lld",
+                                       event.name, event.category, buffer->tid, static_cast<long long>(ts / 1000),
+                                       static_cast<long long>(ts % 1000),
+                                       static_cast<long long>(event.durationNs / 1000),
+                                       static_cast<long long>(event.durationNs % 1000));
+            out.write(line, length);
+            if (event.argName)
+                out << ", \"args\": {\"" << event.argName << "\": " << event.arg << "}";
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -1,11 +1,678 @@
 #include "clickscript.h"
 
+#include <charconv>
+#include <cstdio>
+#include <iomanip>
+#include <thread>
+
+#include "PixelKernels.h"
+#include "ScriptStream.h"
+
 namespace fs = std::filesystem;
 
+namespace
+{
+    // Histogram and trace names of the action opcodes
+    constexpr const char *ACTION_NAMES[] = {"LEFT", "RIGHT", "ENTER", "DELAY", "LOOP_NUMBER", "TYPE", "PASTE",
+                                            "WAIT_FILE", "WAIT_FILE_COUNT", "WAIT_PIXEL", "WAIT_REGION_CHANGE"};
+    static_assert(std::size(ACTION_NAMES) == static_cast<size_t>(OpCode::REPEAT), "one name per action opcode");
+
+    // Script words of WaitPolicy
+    constexpr const char *WAIT_POLICY_NAMES[] = {"CONTINUE", "SKIP", "STOP"};
+
+    // Re-check interval of waits on a directory without change notifications
+    constexpr std::chrono::milliseconds WAIT_POLL_INTERVAL{100};
+
+    int64_t elapsedNs(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+    }
+}
+
 void ClickScript::execute()
 {
+    const bool timed = timingEnabled && !scheduler.isVirtualClock();
+    const bool traced = Tracer::enabled() && !scheduler.isVirtualClock();
+    const uint64_t pausesBefore = pauses;
+    auto start = std::chrono::steady_clock::now();
+    roundStartClock = std::chrono::system_clock::now();
+    roundStartTime.clear();
+    endRound = false;
+
+    if (!stream && !waits.empty() && !scheduler.isVirtualClock() && !beginWaitRound())
+        return;
+
+    // Streamed scripts are parsed while running, without a compiled program use the reference interpreter
+    if (stream)
+        executeStream();
+    else if (program.size() == 0)
+        executeReference();
+    else
+        executeProgram();
+    restoreClipboardIfSettled();
+
+    // Stopped or failed rounds are cut short and paused ones stretched, all would skew the distribution
+    if (timed && pauses == pausesBefore && !streamError && !endRound && abortReason.empty() &&
+        !(token && token->stopRequested()))
+        timings->rounds.record(static_cast<uint64_t>(elapsedNs(start)));
+    if (traced)
+        Tracer::getInstance().complete("round", "round", start, std::chrono::steady_clock::now(), "round",
+                                       current_loop + 1);
+}
+
+void ClickScript::executeProgram()
+{
+    const Instruction *base = program.data();
+    const Instruction *ip = base;
+    int x, y;
+
+    // Loop counters of the open REPEATs and return addresses of the open CALLs
+    uint32_t counters[MAX_NESTING];
+    const Instruction *returns[MAX_NESTING];
+    size_t counterDepth = 0;
+    size_t callDepth = 0;
+
+    // Control flow between two actions is charged to the action before it
+    const bool traced = Tracer::enabled() && !scheduler.isVirtualClock();
+    const bool timed = (timingEnabled || traced) && !scheduler.isVirtualClock();
+    mark = ActionMark();
+    mark.traced = traced;
+
+    scheduler.beginRound();
+    for (;; ++ip)
+    {
+        if (interrupted())
+        {
+            return;
+        }
+        const OpCode op = ip->op;
+        const bool isAction = op < OpCode::REPEAT;
+        // Single writer, so a relaxed load + store instead of a locked add
+        executed_actions.store(executed_actions.load(std::memory_order_relaxed) + isAction,
+                               std::memory_order_relaxed);
+        if (timed && isAction)
+            markAction(static_cast<size_t>(op), ip->operand);
+        switch (op)
+        {
+        case OpCode::LEFT_CLICK:
+            program.decodePoint(*ip, x, y);
+            simulateLeftClick({x, y});
+            break;
+        case OpCode::RIGHT_CLICK:
+            program.decodePoint(*ip, x, y);
+            simulateRightClick({x, y});
+            break;
+        case OpCode::ENTER_KEY:
+            simulateEnterKey('\n');
+            break;
+        case OpCode::DELAY:
+            simulateDelay(static_cast<int>(ip->operand));
+            break;
+        case OpCode::LOOP_NUMBER_KEY:
+            stimulateLoopNumberInput();
+            break;
+        case OpCode::TYPE_TEXT:
+            simulateTyping(static_cast<int>(ip->operand));
+            break;
+        case OpCode::PASTE_TEXT:
+            simulatePaste(static_cast<int>(ip->operand), ip->aux == PASTE_FROM_FILE);
+            break;
+        case OpCode::WAIT_FILE:
+        case OpCode::WAIT_FILE_COUNT:
+        case OpCode::WAIT_PIXEL:
+        case OpCode::WAIT_REGION_CHANGE:
+            if (op >= OpCode::WAIT_PIXEL)
+                simulateScreenWait(static_cast<int>(ip->operand), op == OpCode::WAIT_REGION_CHANGE);
+            else
+                simulateWait(static_cast<int>(ip->operand), op == OpCode::WAIT_FILE_COUNT);
+            if (endRound || !abortReason.empty())
+            {
+                if (timed)
+                    markAction(NO_TIMED_ACTION, 0);
+                return;
+            }
+            break;
+        case OpCode::REPEAT:
+            if (ip->operand == 0)
+            {
+                // Skip the body: find the END_REPEAT that jumps back to it
+                uint32_t body = static_cast<uint32_t>(ip - base) + 1;
+                while (!(ip->op == OpCode::END_REPEAT && ip->operand == body))
+                    ++ip;
+            }
+            else if (counterDepth == MAX_NESTING)
+            {
+                MYLOG_ERROR("REPEAT nesting deeper than {} levels, round aborted", MAX_NESTING);
+                flushInput();
+                return;
+            }
+            else
+            {
+                counters[counterDepth++] = ip->operand;
+            }
+            break;
+        case OpCode::END_REPEAT:
+            if (--counters[counterDepth - 1] > 0)
+                ip = base + ip->operand - 1; // Back to the first body instruction
+            else
+                --counterDepth;
+            break;
+        case OpCode::CALL:
+            if (callDepth == MAX_NESTING)
+            {
+                MYLOG_ERROR("CALL nesting deeper than {} levels, round aborted", MAX_NESTING);
+                flushInput();
+                return;
+            }
+            returns[callDepth++] = ip;
+            ip = base + ip->operand - 1;
+            break;
+        case OpCode::RET:
+            ip = returns[--callDepth];
+            break;
+        case OpCode::HALT:
+        default:
+            flushInput();
+            if (timed)
+                markAction(NO_TIMED_ACTION, 0); // Ends the last action of the round
+            return;
+        }
+    }
+}
+
+void ClickScript::markAction(size_t next, uint32_t operand)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (mark.action != NO_TIMED_ACTION && mark.pauses == pauses)
+    {
+        if (timingEnabled)
+        {
+            timings->actions[mark.action].record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark.start).count()));
+        }
+        if (mark.traced)
+        {
+            bool isDelay = mark.action == static_cast<size_t>(OpCode::DELAY);
+            Tracer::getInstance().complete(isDelay ? "delay" : "action", ACTION_NAMES[mark.action], mark.start, now,
+                                           isDelay ? "ms" : nullptr, mark.operand);
+        }
+    }
+    mark.start = now;
+    mark.action = next;
+    mark.operand = operand;
+    mark.pauses = pauses;
+}
+
+void ClickScript::executeStream()
+{
+    const bool traced = Tracer::enabled() && !scheduler.isVirtualClock();
+    const bool timed = (timingEnabled || traced) && !scheduler.isVirtualClock();
+    mark = ActionMark();
+    mark.traced = traced;
+
+    scheduler.beginRound();
+    Behavior behavior;
+    for (;;)
+    {
+        if (interrupted())
+        {
+            // Drop the rest of this pass, the next round starts from #start again
+            stream->stop();
+            return;
+        }
+        ScriptStream::Next next = stream->next(behavior);
+        if (next != ScriptStream::Next::ACTION)
+        {
+            streamError = next == ScriptStream::Next::FAILED;
+            if (streamError)
+                errors.insert(errors.end(), stream->errors().begin(), stream->errors().end());
+            flushInput();
+            if (timed)
+                markAction(NO_TIMED_ACTION, 0); // Ends the last action of the round
+            return;
+        }
+        executed_actions.store(executed_actions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // Action values match the action opcodes
+        if (timed)
+            markAction(static_cast<size_t>(behavior.action), static_cast<uint32_t>(behavior.delay));
+        switch (behavior.action)
+        {
+        case LEFT_CLICK:
+            simulateLeftClick(behavior.point);
+            break;
+        case RIGHT_CLICK:
+            simulateRightClick(behavior.point);
+            break;
+        case ENTER_KEY:
+            simulateEnterKey(behavior.key);
+            break;
+        case DELAY:
+            simulateDelay(behavior.delay);
+            break;
+        case LOOP_NUMBER_KEY:
+            stimulateLoopNumberInput();
+            break;
+        default:
+            break; // The stream only carries actions
+        }
+    }
+}
+
+bool ClickScript::openStream(const std::string &filename, size_t queueSize)
+{
+    MYLOG_INFO("Opening ClickScript for streaming: {}", filename);
+
+    this->filename = filename;
+    behaviors.clear();
+    errors.clear();
+    subNames.clear();
+    subDefinitions.clear();
+    subLookup.clear();
+    openBlocks.clear();
+    texts.clear();
+    typedTexts.clear();
+    waits.clear();
+    program.clear();
+    scheduler.resetStats();
+    resetTimings();
+    streamError = false;
+
+    // The parser thread parses with its own tables, nothing of this script is shared with it
+    auto parser = std::make_shared<ClickScript>();
+    parser->filename = filename;
+    parser->config = config;
+    stream = std::make_unique<ScriptStream>(
+        filename, queueSize,
+        [parser](std::string_view line, size_t lineNumber, bool report, Behavior &behavior,
+                 std::vector<ScriptError> &lineErrors)
+        {
+            size_t before = parser->lineErrors;
+            parser->quietErrors = !report;
+            behavior = parser->parseCommandLine(line, lineNumber);
+            parser->quietErrors = false;
+            // Streaming rejects the commands that add texts or waits, only the errors are kept
+            parser->texts.clear();
+            parser->waits.clear();
+            lineErrors.insert(lineErrors.end(), std::make_move_iterator(parser->errors.begin()),
+                              std::make_move_iterator(parser->errors.end()));
+            parser->errors.clear();
+            return parser->lineErrors == before;
+        });
+    if (!stream->open())
+    {
+        stream.reset();
+        return false;
+    }
+    return true;
+}
+
+void ClickScript::compile()
+{
+    program.clear();
+    for (const auto &text : texts)
+    {
+        program.addText(text); // Same indices as behavior.text
+    }
+    for (const auto &wait : waits)
+    {
+        program.addWait(wait); // Same indices as behavior.wait
+    }
+
+    // Main program, CALL targets are patched once the subroutines are laid out
+    std::vector<std::pair<size_t, int>> calls;
+    compileRange(0, behaviors.size(), calls);
+    program.emit(OpCode::HALT);
+
+    // Subroutine bodies follow the main program, each ends with RET
+    std::vector<uint32_t> entries(subNames.size(), 0);
+    for (size_t sub = 0; sub < subNames.size(); ++sub)
+    {
+        int definition = subDefinitions[sub];
+        if (definition < 0)
+        {
+            continue;
+        }
+        entries[sub] = static_cast<uint32_t>(program.size());
+        program.addSymbol(entries[sub], subNames[sub]);
+        compileRange(definition + 1, behaviors[definition].end, calls);
+        program.emit(OpCode::RET);
+    }
+    for (const auto &call : calls)
+    {
+        program.patchOperand(call.first, entries[call.second]);
+    }
+
+    MYLOG_INFO("Compiled {} behaviors into {} instructions ({} bytes)", behaviors.size(), program.size(),
+               program.byteSize());
+}
+
+void ClickScript::compileRange(size_t begin, size_t end, std::vector<std::pair<size_t, int>> &calls)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const Behavior &behavior = behaviors[i];
+        switch (behavior.action)
+        {
+        case LEFT_CLICK:
+            program.emitPoint(OpCode::LEFT_CLICK, behavior.point.x, behavior.point.y);
+            break;
+        case RIGHT_CLICK:
+            program.emitPoint(OpCode::RIGHT_CLICK, behavior.point.x, behavior.point.y);
+            break;
+        case ENTER_KEY:
+            program.emit(OpCode::ENTER_KEY);
+            break;
+        case DELAY:
+            program.emitValue(OpCode::DELAY, static_cast<uint32_t>(behavior.delay > 0 ? behavior.delay : 0));
+            break;
+        case LOOP_NUMBER_KEY:
+            program.emit(OpCode::LOOP_NUMBER_KEY);
+            break;
+        case TYPE_TEXT:
+            program.emitValue(OpCode::TYPE_TEXT, static_cast<uint32_t>(behavior.text));
+            break;
+        case PASTE_TEXT:
+            program.emitValue(OpCode::PASTE_TEXT, static_cast<uint32_t>(behavior.text),
+                              behavior.from_file ? PASTE_FROM_FILE : 0);
+            break;
+        case WAIT_FILE:
+        case WAIT_FILE_COUNT:
+        case WAIT_PIXEL:
+        case WAIT_REGION_CHANGE:
+            // Action values match the action opcodes
+            program.emitValue(static_cast<OpCode>(behavior.action), static_cast<uint32_t>(behavior.wait));
+            break;
+        case REPEAT_BEGIN:
+        {
+            // The body is emitted once, END_REPEAT jumps back while the counter lasts
+            size_t repeat = program.emitValue(OpCode::REPEAT, static_cast<uint32_t>(behavior.count));
+            compileRange(i + 1, behavior.end, calls);
+            program.emitValue(OpCode::END_REPEAT, static_cast<uint32_t>(repeat + 1));
+            i = behavior.end;
+            break;
+        }
+        case SUB_BEGIN:
+            i = behavior.end; // Compiled after the main program
+            break;
+        case CALL_SUB:
+            calls.emplace_back(program.emitValue(OpCode::CALL, 0), behavior.sub);
+            break;
+        case BLOCK_END:
+        case NONE:
+        default:
+            break;
+        }
+    }
+}
+
+void ClickScript::decompile()
+{
+    std::vector<Behavior> decoded;
+    subNames.clear();
+    subDefinitions.clear();
+    subLookup.clear();
+    decompileTo(decoded, subNames);
+    texts = program.texts();
+    waits = program.waits();
+
+    behaviors.clear();
+    behaviors.reserve(decoded.size());
+    subDefinitions.assign(subNames.size(), -1);
+    for (size_t sub = 0; sub < subNames.size(); ++sub)
+    {
+        subLookup[subNames[sub]] = static_cast<int>(sub);
+    }
+    for (const auto &behavior : decoded)
+    {
+        appendLinked(behavior);
+    }
+    openBlocks.clear();
+}
+
+void ClickScript::decompileTo(std::vector<Behavior> &out, std::vector<std::string> &names) const
+{
+    const auto &symbols = program.symbols();
+    names.clear();
+    for (const auto &symbol : symbols)
+    {
+        names.push_back(symbol.name);
+    }
+
+    bool inSubroutine = false;
+    for (size_t pc = 0; pc < program.size(); ++pc)
+    {
+        const Instruction &instruction = program[pc];
+
+        // Subroutine entries are marked by the symbol table
+        for (size_t k = 0; k < symbols.size(); ++k)
+        {
+            if (symbols[k].address == pc)
+            {
+                Behavior begin;
+                begin.action = SUB_BEGIN;
+                begin.sub = static_cast<int>(k);
+                out.push_back(begin);
+                inSubroutine = true;
+            }
+        }
+
+        Behavior behavior;
+        switch (instruction.op)
+        {
+        case OpCode::LEFT_CLICK:
+        case OpCode::RIGHT_CLICK:
+            behavior.action = instruction.op == OpCode::LEFT_CLICK ? LEFT_CLICK : RIGHT_CLICK;
+            program.decodePoint(instruction, behavior.point.x, behavior.point.y);
+            break;
+        case OpCode::ENTER_KEY:
+            behavior.action = ENTER_KEY;
+            behavior.key = '\n';
+            break;
+        case OpCode::DELAY:
+            behavior.action = DELAY;
+            behavior.delay = static_cast<int>(instruction.operand);
+            break;
+        case OpCode::LOOP_NUMBER_KEY:
+            behavior.action = LOOP_NUMBER_KEY;
+            behavior.loop_number_input = true;
+            break;
+        case OpCode::TYPE_TEXT:
+        case OpCode::PASTE_TEXT:
+            behavior.action = instruction.op == OpCode::TYPE_TEXT ? TYPE_TEXT : PASTE_TEXT;
+            behavior.text = static_cast<int>(instruction.operand);
+            behavior.from_file = instruction.aux == PASTE_FROM_FILE;
+            break;
+        case OpCode::WAIT_FILE:
+        case OpCode::WAIT_FILE_COUNT:
+        case OpCode::WAIT_PIXEL:
+        case OpCode::WAIT_REGION_CHANGE:
+            behavior.action = static_cast<Action>(instruction.op);
+            behavior.wait = static_cast<int>(instruction.operand);
+            break;
+        case OpCode::REPEAT:
+            behavior.action = REPEAT_BEGIN;
+            behavior.count = static_cast<int>(instruction.operand);
+            break;
+        case OpCode::END_REPEAT:
+            behavior.action = BLOCK_END;
+            break;
+        case OpCode::CALL:
+            behavior.action = CALL_SUB;
+            for (size_t k = 0; k < symbols.size(); ++k)
+            {
+                if (symbols[k].address == instruction.operand)
+                    behavior.sub = static_cast<int>(k);
+            }
+            break;
+        case OpCode::RET:
+            if (!inSubroutine)
+                continue;
+            behavior.action = BLOCK_END;
+            inSubroutine = false;
+            break;
+        case OpCode::HALT:
+        default:
+            continue;
+        }
+        out.push_back(behavior);
+    }
+}
+
+void ClickScript::canonicalBehaviors(std::vector<Behavior> &out) const
+{
+    // Same order as compile(): main program without SUB blocks, then every defined subroutine
+    for (size_t i = 0; i < behaviors.size(); ++i)
+    {
+        if (behaviors[i].action == SUB_BEGIN)
+        {
+            i = behaviors[i].end;
+        }
+        else if (behaviors[i].action != NONE)
+        {
+            out.push_back(behaviors[i]);
+        }
+    }
+    for (size_t sub = 0; sub < subNames.size(); ++sub)
+    {
+        int definition = subDefinitions[sub];
+        if (definition < 0)
+        {
+            continue;
+        }
+        for (int i = definition; i <= behaviors[definition].end; ++i)
+        {
+            if (behaviors[i].action != NONE)
+            {
+                out.push_back(behaviors[i]);
+            }
+        }
+    }
+}
+
+void ClickScript::bindTexts()
+{
+    TextTemplate::ConfigLookup lookup;
+    if (config)
+    {
+        lookup = [this](const std::string &key, std::string &value)
+        {
+            value = config->get(key);
+            return !value.empty();
+        };
+    }
+    // Every TYPE / PASTE / WAIT_FILE has its own text, which tells how to compile it
+    typedTexts.assign(texts.size(), TextTemplate());
     for (const auto &behavior : behaviors)
     {
+        int text = behavior.text;
+        if (behavior.action == WAIT_FILE)
+            text = static_cast<int>(waits[behavior.wait].pattern);
+        else if ((behavior.action != TYPE_TEXT && behavior.action != PASTE_TEXT) || behavior.from_file)
+            continue;
+        std::string message;
+        size_t offset = 0;
+        auto output = behavior.action == TYPE_TEXT ? TextTemplate::Output::KEYS : TextTemplate::Output::TEXT;
+        if (!typedTexts[text].compile(texts[text], lookup, message, offset, output))
+        {
+            MYLOG_ERROR("Text of line {} can not be used: {}", behavior.line, message);
+        }
+    }
+}
+
+bool ClickScript::verifyProgram()
+{
+    // Decompile the program and compare it with the behaviors list in compile order
+    std::vector<Behavior> expected, decoded;
+    std::vector<std::string> decodedNames;
+    canonicalBehaviors(expected);
+    decompileTo(decoded, decodedNames);
+
+    if (!program.validate())
+    {
+        MYLOG_ERROR("Compiled program is malformed.");
+        return false;
+    }
+    if (expected.size() != decoded.size())
+    {
+        MYLOG_ERROR("Compiled program has {} entries, the behaviors list {}.", decoded.size(), expected.size());
+        return false;
+    }
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        const Behavior &behavior = expected[i];
+        const Behavior &other = decoded[i];
+        bool match = behavior.action == other.action;
+        switch (behavior.action)
+        {
+        case LEFT_CLICK:
+        case RIGHT_CLICK:
+            match = match && behavior.point.x == other.point.x && behavior.point.y == other.point.y;
+            break;
+        case DELAY:
+            match = match && (behavior.delay > 0 ? behavior.delay : 0) == other.delay;
+            break;
+        case TYPE_TEXT:
+        case PASTE_TEXT:
+            match = match && behavior.from_file == other.from_file && texts[behavior.text] == program.texts()[other.text];
+            break;
+        case WAIT_FILE:
+        case WAIT_FILE_COUNT:
+        case WAIT_PIXEL:
+        case WAIT_REGION_CHANGE:
+        {
+            const WaitSpec &wait = waits[behavior.wait];
+            const WaitSpec &compiled = program.waits()[other.wait];
+            match = match && wait.timeoutMs == compiled.timeoutMs && wait.policy == compiled.policy &&
+                    wait.flags == compiled.flags && wait.tolerance == compiled.tolerance &&
+                    wait.count == compiled.count && wait.x == compiled.x && wait.y == compiled.y &&
+                    wait.width == compiled.width && wait.height == compiled.height && wait.color == compiled.color;
+            if (behavior.action == WAIT_FILE || behavior.action == WAIT_FILE_COUNT)
+                match = match && texts[wait.directory] == program.texts()[compiled.directory];
+            if (behavior.action == WAIT_FILE)
+                match = match && texts[wait.pattern] == program.texts()[compiled.pattern];
+            break;
+        }
+        case REPEAT_BEGIN:
+            match = match && behavior.count == other.count;
+            break;
+        case SUB_BEGIN:
+        case CALL_SUB:
+            match = match && other.sub >= 0 && subNames[behavior.sub] == decodedNames[other.sub];
+            break;
+        default:
+            break;
+        }
+
+        if (!match)
+        {
+            MYLOG_ERROR("Compiled program differs from the script at line {}", behavior.line);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ClickScript::executeReference()
+{
+    scheduler.beginRound();
+    executeRange(0, behaviors.size());
+    flushInput();
+}
+
+void ClickScript::executeRange(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (interrupted() || endRound || !abortReason.empty())
+        {
+            return;
+        }
+        const Behavior &behavior = behaviors[i];
+        if (behavior.action < REPEAT_BEGIN)
+        {
+            executed_actions.store(executed_actions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
         switch (behavior.action)
         {
         case LEFT_CLICK:
@@ -28,113 +695,629 @@ void ClickScript::execute()
             // Simulate loop number keyboard input
             stimulateLoopNumberInput();
             break;
+        case TYPE_TEXT:
+            // Type the text, placeholders filled in for this round
+            simulateTyping(behavior.text);
+            break;
+        case PASTE_TEXT:
+            // Paste the text or file through the clipboard
+            simulatePaste(behavior.text, behavior.from_file);
+            break;
+        case WAIT_FILE:
+        case WAIT_FILE_COUNT:
+            // Block until the file or file count shows up in the directory
+            simulateWait(behavior.wait, behavior.action == WAIT_FILE_COUNT);
+            break;
+        case WAIT_PIXEL:
+        case WAIT_REGION_CHANGE:
+            // Block until the pixel has the colour or the region changes
+            simulateScreenWait(behavior.wait, behavior.action == WAIT_REGION_CHANGE);
+            break;
+        case REPEAT_BEGIN:
+            // Run the body count times
+            for (int n = 0; n < behavior.count && !(token && token->stopRequested()); ++n)
+            {
+                executeRange(i + 1, behavior.end);
+            }
+            i = behavior.end;
+            break;
+        case SUB_BEGIN:
+            // Definitions only run through CALL
+            i = behavior.end;
+            break;
+        case CALL_SUB:
+        {
+            int definition = subDefinitions[behavior.sub];
+            if (definition >= 0)
+            {
+                executeRange(definition + 1, behaviors[definition].end);
+            }
+            break;
+        }
+        case BLOCK_END:
         case NONE:
+            // Structure markers and dropped commands do nothing
+            break;
         default:
-            // Do nothing
-            MyLogger::getInstance().warning("Unknown action in ClickScript.");
+            MYLOG_WARNING("Unknown action in ClickScript.");
+            break;
+        }
+    }
+}
+
+void ClickScript::stimulateLoopNumberInput()
+{
+    if (current_loop <= 0)
+    {
+        MYLOG_ERROR("Invalid loop count for LOOP_NUMBER_KEY input.");
+        return;
+    }
+
+    // Digits map to keys through the constant table, no layout query per character
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), current_loop);
+    pending.typeText(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void ClickScript::simulateTyping(int text)
+{
+    MYLOG_DEBUG("Simulating typing of text {}", text);
+    const TextTemplate &typed = typedTexts[text];
+    // Queued with the rest of the round's input, the whole text goes out in one submission
+    typed.appendTo(pending, textContext(typed.usesRoundStartTime()));
+}
+
+void ClickScript::simulatePaste(int text, bool fromFile)
+{
+    MYLOG_DEBUG("Simulating paste of text {}", text);
+    pasteBuffer.clear();
+    if (fromFile)
+    {
+        // Read every time, so another program can prepare the next payload between rounds
+        if (!readWholeFile(texts[text], pasteBuffer))
+        {
+            MYLOG_ERROR("PASTE file {} can not be read, nothing pasted", texts[text]);
+            return;
+        }
+    }
+    else
+    {
+        const TextTemplate &source = typedTexts[text];
+        source.expand(pasteBuffer, textContext(source.usesRoundStartTime()));
+    }
+
+    // The previous paste may still be waiting to be read by the target
+    if (clipboardSaved && !scheduler.isVirtualClock())
+    {
+        auto excluded = scheduler.excludeWait();
+        if (token && !token->waitUntil(pasteSettled))
+            return; // Stopped while waiting
+        if (!token)
+            std::this_thread::sleep_until(pasteSettled);
+    }
+    if (!clipboardSaved)
+    {
+        savedHadText = clipboard->getText(savedClipboard);
+        clipboardSaved = true;
+    }
+    if (!clipboard->setText(pasteBuffer))
+    {
+        MYLOG_ERROR("Failed to put {} bytes on the clipboard, nothing pasted", pasteBuffer.size());
+        return;
+    }
+
+    // Ctrl+V goes out right away in one submission, the clipboard now holds its text
+    pending.key(VirtualKey::CONTROL, true);
+    pending.keyPress('V');
+    pending.key(VirtualKey::CONTROL, false);
+    flushInput();
+    pasteSettled = DelayScheduler::clock::now() + pasteSettle;
+}
+
+void ClickScript::restoreClipboardIfSettled()
+{
+    if (clipboardSaved && (scheduler.isVirtualClock() || DelayScheduler::clock::now() >= pasteSettled))
+    {
+        restoreClipboard();
+    }
+}
+
+void ClickScript::restoreClipboard()
+{
+    if (!clipboardSaved)
+    {
+        return;
+    }
+    if (!scheduler.isVirtualClock())
+    {
+        std::this_thread::sleep_until(pasteSettled);
+    }
+    bool ok = savedHadText ? clipboard->setText(savedClipboard) : clipboard->clear();
+    if (!ok)
+    {
+        MYLOG_WARNING("Failed to restore the clipboard after PASTE");
+    }
+    clipboardSaved = false;
+    savedClipboard.clear();
+}
+
+bool ClickScript::beginWaitRound()
+{
+    if (waitIndexes.empty())
+    {
+        // Directories are opened on the first round, when the reactor already runs
+        ThreadManager &reactor = ThreadManager::getInstance();
+        waitsNotified = reactor.isStarted();
+        for (const WaitSpec &wait : waits)
+        {
+            if (wait.flags & WAIT_SCREEN)
+            {
+                waitIndexes.push_back(nullptr);
+                continue;
+            }
+            const std::string &name = texts[wait.directory];
+            std::string path = name;
+            if (!(wait.flags & WAIT_LITERAL_DIRECTORY))
+            {
+                path = config ? config->get(name) : "";
+                if (path.empty())
+                {
+                    abortReason = "WAIT_FILE directory " + name + " is not set in the configuration";
+                    waitIndexes.clear();
+                    return false;
+                }
+            }
+            std::error_code ec;
+            if (!fs::is_directory(path, ec))
+            {
+                abortReason = "WAIT_FILE directory " + path + " does not exist";
+                waitIndexes.clear();
+                return false;
+            }
+
+            auto &index = waitDirectories[path];
+            if (!index)
+            {
+                index = std::make_unique<DirectoryIndex>(path);
+                index->onChange([this]
+                                {
+                                    if (CancellationToken *waiter = fileWaiter.load())
+                                        waiter->wake(); });
+                if (waitsNotified)
+                    index->watch(reactor);
+            }
+            waitIndexes.push_back(index.get());
+        }
+        waitBaseCounts.assign(waits.size(), 0);
+    }
+    for (size_t i = 0; i < waits.size(); ++i)
+    {
+        if (waits[i].flags & WAIT_RELATIVE_COUNT)
+            waitBaseCounts[i] = waitIndexes[i]->count();
+    }
+    return true;
+}
+
+void ClickScript::simulateWait(int wait, bool countFiles)
+{
+    if (scheduler.isVirtualClock())
+    {
+        return; // Dry runs do not look at the file system, every wait is met at once
+    }
+    const WaitSpec &spec = waits[wait];
+    DirectoryIndex &index = *waitIndexes[wait];
+
+    size_t target = spec.count;
+    if (countFiles)
+    {
+        if (spec.flags & WAIT_RELATIVE_COUNT)
+            target += waitBaseCounts[wait];
+        MYLOG_DEBUG("Waiting for {} files in {}", target, index.path());
+    }
+    else
+    {
+        const TextTemplate &pattern = typedTexts[spec.pattern];
+        waitName.clear();
+        pattern.expand(waitName, textContext(pattern.usesRoundStartTime()));
+        MYLOG_DEBUG("Waiting for {} in {}", waitName, index.path());
+    }
+
+    // The input before the wait usually is what makes the file appear
+    flushInput();
+
+    // Checked again on every change notification, or every poll interval without them
+    auto ready = [&]
+    { return countFiles ? index.count() >= target : index.findMatching(waitName); };
+    CancellationToken &waiter = token ? *token : waitWakeup;
+    const bool notified = waitsNotified && index.isWatching();
+    bool found = false;
+    {
+        auto excluded = scheduler.excludeWait();
+        const auto deadline = excluded.started() + std::chrono::milliseconds(spec.timeoutMs);
+        fileWaiter.store(&waiter);
+        for (;;)
+        {
+            auto until = notified ? deadline : std::min(deadline, DelayScheduler::clock::now() + WAIT_POLL_INTERVAL);
+            found = waiter.waitUntil(until, ready);
+            if (found || until >= deadline || waiter.stopRequested())
+                break;
+        }
+        fileWaiter.store(nullptr);
+    }
+    if (found || waiter.stopRequested())
+    {
+        return;
+    }
+
+    std::string what = countFiles ? std::to_string(target) + " files" : waitName;
+    waitTimedOut(spec, "No " + what + " in " + index.path() + " after " + std::to_string(spec.timeoutMs) + " ms");
+}
+
+void ClickScript::simulateScreenWait(int wait, bool regionChange)
+{
+    if (scheduler.isVirtualClock())
+    {
+        return; // Dry runs have no screen, every wait is met at once
+    }
+    const WaitSpec &spec = waits[wait];
+    const int width = static_cast<int>(spec.width);
+    const int height = static_cast<int>(spec.height);
+    auto unreadable = [&]
+    {
+        abortReason = "Screen region " + std::to_string(width) + "x" + std::to_string(height) + " at (" +
+                      std::to_string(spec.x) + ", " + std::to_string(spec.y) + ") can not be read from " +
+                      screen->name();
+        MYLOG_ERROR("{}, run stopped", abortReason);
+    };
+
+    // The input before the wait usually is what changes the screen
+    flushInput();
+    auto excluded = scheduler.excludeWait();
+    const auto deadline = excluded.started() + std::chrono::milliseconds(spec.timeoutMs);
+    if (regionChange && !screen->capture(spec.x, spec.y, width, height, screenBefore))
+    {
+        unreadable();
+        return;
+    }
+
+    // Poll fast right after the input, back off while nothing happens
+    DelayScheduler::clock::duration interval = screenPollMin;
+    for (;;)
+    {
+        auto captureStart = DelayScheduler::clock::now();
+        if (!screen->capture(spec.x, spec.y, width, height, screenNow))
+        {
+            unreadable();
+            return;
+        }
+        auto now = DelayScheduler::clock::now();
+        bool met = regionChange ? pixels::countDifferent(screenBefore.pixels.data(), screenNow.pixels.data(),
+                                                         screenNow.pixels.size(), spec.tolerance) > 0
+                                : !pixels::differs(screenNow.pixels[0], spec.color, spec.tolerance);
+        if (met)
+            return;
+        if (now >= deadline)
             break;
+        interval = std::clamp<DelayScheduler::clock::duration>(std::max(interval * 2, (now - captureStart) * 4),
+                                                               screenPollMin, screenPollMax);
+        auto until = std::min(deadline, now + interval);
+        if (token ? !token->waitUntil(until) : (std::this_thread::sleep_until(until), false))
+        {
+            return; // Stopped while waiting
         }
     }
+
+    auto hex = [](uint32_t rgb)
+    {
+        char text[8];
+        std::snprintf(text, sizeof(text), "%06X", static_cast<unsigned>(rgb & 0xFFFFFF));
+        return std::string(text);
+    };
+    std::string where = " at (" + std::to_string(spec.x) + ", " + std::to_string(spec.y) + ") after " +
+                        std::to_string(spec.timeoutMs) + " ms";
+    if (regionChange)
+        waitTimedOut(spec, "No change of the " + std::to_string(width) + "x" + std::to_string(height) + " region" +
+                               where);
+    else
+        waitTimedOut(spec, "No colour " + hex(spec.color) + where + ", last seen " + hex(screenNow.pixels[0]));
 }
 
-void ClickScript::stimulateLoopNumberInput()
+void ClickScript::waitTimedOut(const WaitSpec &wait, const std::string &problem)
 {
-    if (current_loop <= 0)
+    switch (wait.policy)
     {
-        MyLogger::getInstance().error("Invalid loop count for LOOP_NUMBER_KEY input.");
-        return;
+    case WaitPolicy::CONTINUE:
+        MYLOG_WARNING("{}, continuing", problem);
+        break;
+    case WaitPolicy::SKIP:
+        MYLOG_WARNING("{}, skipping the rest of round {}", problem, current_loop + 1);
+        endRound = true;
+        break;
+    case WaitPolicy::STOP:
+    default:
+        abortReason = problem + " in round " + std::to_string(current_loop + 1);
+        MYLOG_ERROR("{}, run stopped", abortReason);
+        break;
     }
+}
 
-    std::string loopStr = std::to_string(current_loop);
-    for (char ch : loopStr)
+TextTemplate::Context ClickScript::textContext(bool needsTime)
+{
+    if (needsTime && roundStartTime.empty())
     {
-        SHORT vk = VkKeyScan(ch);
-        if (vk == -1)
-        {
-            MyLogger::getInstance().error("Failed to map character to virtual key: " + std::string(1, ch));
-            continue;
-        }
-
-        // Simulate key press
-        keybd_event(static_cast<BYTE>(vk), 0, 0, 0);               // Key down
-        keybd_event(static_cast<BYTE>(vk), 0, KEYEVENTF_KEYUP, 0); // Key up
-        // Sleep(50);                                                 // Short delay between key presses
+        roundStartTime = TextTemplate::formatClock(roundStartClock);
     }
+    return {current_loop + 1, roundStartTime};
 }
 
 void ClickScript::simulateLeftClick(const Point &point)
 {
     // Implementation for simulating a left click at the specified point
-    MyLogger::getInstance().debug("Simulating left click at (" + std::to_string(point.x) + ", " + std::to_string(point.y) + ")");
-    SetCursorPos(point.x, point.y); // Move cursor to the point
-    mouse_event(MOUSEEVENTF_LEFTDOWN, point.x, point.y, 0, 0);
-    mouse_event(MOUSEEVENTF_LEFTUP, point.x, point.y, 0, 0);
+    MYLOG_DEBUG("Simulating left click at ({}, {})", point.x, point.y);
+    pending.click(MouseButton::LEFT, point.x, point.y); // Move, press and release in one batch
 }
 
 void ClickScript::simulateRightClick(const Point &point)
 {
     // Implementation for simulating a right click at the specified point
-    MyLogger::getInstance().debug("Simulating right click at (" + std::to_string(point.x) + ", " + std::to_string(point.y) + ")");
-    SetCursorPos(point.x, point.y); // Move cursor to the point
-    mouse_event(MOUSEEVENTF_RIGHTDOWN, point.x, point.y, 0, 0);
-    mouse_event(MOUSEEVENTF_RIGHTUP, point.x, point.y, 0, 0);
+    MYLOG_DEBUG("Simulating right click at ({}, {})", point.x, point.y);
+    pending.click(MouseButton::RIGHT, point.x, point.y); // Move, press and release in one batch
 }
 
 void ClickScript::simulateEnterKey(const char &key)
 {
     // Implementation for simulating pressing the enter key
-    MyLogger::getInstance().debug("Simulating enter key press");
+    MYLOG_DEBUG("Simulating enter key press");
     if (key == '\n' || key == '\r')
     {
         // Simulate pressing the enter key
-        keybd_event(VK_RETURN, 0, 0, 0);               // Key down
-        keybd_event(VK_RETURN, 0, KEYEVENTF_KEYUP, 0); // Key up
+        pending.keyPress(VirtualKey::RETURN);
     }
     else
     {
-        MyLogger::getInstance().error("Invalid key for enter simulation: " + std::string(1, key));
+        MYLOG_ERROR("Invalid key for enter simulation: {}", key);
     }
 }
 
 void ClickScript::simulateDelay(int delay)
 {
-    // TODO : time transformation
-    Sleep(300); // Convert milliseconds to seconds for sleep
+    // Input queued before the delay must reach the target before waiting
+    flushInput();
+
+    // Wait against the round deadline, not relative to now; a stop ends the wait
+    scheduler.waitFor(delay, token);
+    restoreClipboardIfSettled();
+}
+
+bool ClickScript::handleInterrupt()
+{
+    if (token->isPaused())
+    {
+        // Input before the pause point is delivered, the rest of the round moves by the pause
+        flushInput();
+        ++pauses;
+        MYLOG_INFO("Execution paused");
+        TraceSpan span("control", "pause");
+        auto excluded = scheduler.excludeWait();
+        token->waitWhilePaused();
+        MYLOG_INFO("Execution resumed");
+    }
+    if (token->stopRequested())
+    {
+        // Queued input after the stop request is never injected
+        pending.clear();
+        token->acknowledgeStop();
+        return false;
+    }
+    return true;
+}
+
+void ClickScript::flushInput()
+{
+    if (pending.empty())
+    {
+        return;
+    }
+    if (scheduler.isVirtualClock())
+    {
+        input->submitBatch(pending); // Simulated time does not pass while injecting
+        pending.clear();
+        return;
+    }
+    auto start = DelayScheduler::clock::now();
+    input->submitBatch(pending);
+    scheduler.recordInjection(DelayScheduler::clock::now() - start);
+    pending.clear();
+}
+
+ClickScript::SimulationReport ClickScript::simulate(int rounds, std::shared_ptr<RecordingInputBackend> timeline)
+{
+    SimulationReport report;
+    report.valid = errors.empty() && !program.empty();
+
+    // Swap in the dry-run backend and the virtual clock, restored below
+    std::shared_ptr<InputBackend> realInput = input;
+    std::shared_ptr<ClipboardBackend> realClipboard = clipboard;
+    restoreClipboard();
+    clipboard = std::make_shared<MemoryClipboardBackend>(); // PASTE must not touch the real clipboard
+    CancellationToken *realToken = token;
+    int realLoop = current_loop;
+    uint64_t realActions = getExecutedActions();
+    if (timeline)
+    {
+        timeline->clear();
+        timeline->setClock([this]
+                           { return static_cast<int64_t>(scheduler.virtualElapsed().count()); });
+        input = timeline;
+    }
+    else
+    {
+        input = std::make_shared<NullInputBackend>();
+    }
+    token = nullptr;
+    scheduler.setVirtualClock(true);
+    resetExecutedActions();
+
+    // Per-action debug lines would cost far more than simulating the action
+    MyLogger &logger = MyLogger::getInstance();
+    MyLogger::LogLevel realLevel = logger.getLogLevel();
+    if (realLevel < MyLogger::LogLevel::LOG_INFO)
+        logger.setLogLevel(MyLogger::LogLevel::LOG_INFO);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        current_loop = i;
+        auto roundStart = scheduler.virtualElapsed();
+        execute();
+        auto roundTime = scheduler.virtualElapsed() - roundStart;
+        if (i == 0 || roundTime < report.minRound)
+            report.minRound = roundTime;
+        report.maxRound = std::max(report.maxRound, roundTime);
+    }
+    report.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    report.rounds = rounds;
+    report.total = scheduler.virtualElapsed();
+    report.actions = getExecutedActions();
+    report.events = timeline ? timeline->events().size() : 0;
+
+    logger.setLogLevel(realLevel);
+    restoreClipboard(); // Into the stand-in, still on the virtual clock
+    clipboard = realClipboard;
+    scheduler.setVirtualClock(false);
+    if (timeline)
+        timeline->setClock(nullptr);
+    input = realInput;
+    token = realToken;
+    current_loop = realLoop;
+    executed_actions.store(realActions, std::memory_order_relaxed);
+    return report;
+}
+
+void ClickScript::resetTimings()
+{
+    for (auto &histogram : timings->actions)
+        histogram.reset();
+    timings->rounds.reset();
+}
+
+LatencyHistogram::Named ClickScript::namedTimings() const
+{
+    LatencyHistogram::Named named;
+    for (size_t i = 0; i < timings->actions.size(); ++i)
+        named.emplace_back(ACTION_NAMES[i], &timings->actions[i]);
+    named.emplace_back("round", &timings->rounds);
+    named.emplace_back("delay_error", &scheduler.errorHistogram());
+    return named;
+}
+
+void ClickScript::reportTimings(std::ostream &out) const
+{
+    out << "--- Timing (monotonic, per action kind and per completed round) ---" << std::endl;
+    if (timings->rounds.count() == 0 && timings->actions[0].count() == 0 && scheduler.errorHistogram().count() == 0)
+    {
+        out << "No timed rounds." << std::endl;
+        return;
+    }
+    LatencyHistogram::printTable(out, namedTimings());
+}
+
+bool ClickScript::writeTimingReport(const std::string &path, int rounds) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        MYLOG_ERROR("Failed to write timing report {}", path);
+        return false;
+    }
+    // Only the script path can hold characters JSON needs escaped
+    std::string script;
+    for (char c : filename)
+    {
+        if (c == '"' || c == '\\')
+            script += '\\';
+        script += c;
+    }
+    out << "{\n  \"script\": \"" << script << "\",\n  \"requested_rounds\": " << rounds
+        << ",\n  \"unit\": \"ns\",\n  \"histograms\": ";
+    LatencyHistogram::writeJson(out, namedTimings());
+    out << "\n}\n";
+    return static_cast<bool>(out);
 }
 
 void ClickScript::addBehavior(const Behavior &behavior)
 {
     behaviors.push_back(behavior);
-    MyLogger::getInstance().debug("Behavior added: " + std::to_string(behavior.action));
+    MYLOG_DEBUG("Behavior added: {}", behavior.action);
 }
 
 ClickScript::ClickScript()
+    : input(createInputBackend()), clipboard(createClipboardBackend()), screen(createScreenSource())
+{
+    MYLOG_INFO("ClickScript initialized.");
+}
+
+ClickScript::~ClickScript()
 {
-    MyLogger::getInstance().info("ClickScript initialized.");
+    restoreClipboard();
 }
 
 void ClickScript::load_ClickScript_fromfile(const std::string &filename)
 {
-    MyLogger::getInstance().info("Loading ClickScript from file: " + filename);
-    std::ifstream file(filename);
+    MYLOG_INFO("Loading ClickScript from file: {}", filename);
 
-    if (!file.is_open())
+    this->filename = filename;
+    stream.reset();
+
+    // Clear existing behaviors
+    behaviors.clear();
+    errors.clear();
+    subNames.clear();
+    subDefinitions.clear();
+    subLookup.clear();
+    openBlocks.clear();
+    texts.clear();
+    waits.clear();
+    waitIndexes.clear();
+    waitDirectories.clear();
+    abortReason.clear();
+    scheduler.resetStats();
+    resetTimings();
+
+    // A fresh compiled cache skips reading and parsing the script
+    if (cacheEnabled && ProgramCache::load(filename, program))
     {
-        MyLogger::getInstance().error("Failed to open ClickScript file: " + filename);
+        decompile();
+        bindTexts();
+        MYLOG_INFO("Loaded {} instructions from cache {}", program.size(), ProgramCache::cachePathFor(filename));
         return;
     }
 
-    std::string line;
-    bool inCommandBlock = false;
+    // Read the file in one go, lines are then views into this buffer. The cache is
+    // stamped with the file as it was before the read, never newer than the content.
+    ProgramCache::SourceStamp sourceStamp;
+    bool stamped = cacheEnabled && ProgramCache::stamp(filename, sourceStamp);
+    std::string content;
+    if (!readWholeFile(filename, content))
+    {
+        MYLOG_ERROR("Failed to open ClickScript file: {}", filename);
+        program.clear();
+        return;
+    }
 
-    // Clear existing behaviors
-    behaviors.clear();
+    bool inCommandBlock = false;
 
-    while (std::getline(file, line))
+    std::string_view text(content);
+    size_t lineNumber = 0;
+    while (!text.empty())
     {
+        size_t newline = text.find('\n');
+        std::string_view rawLine = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        ++lineNumber;
+
         // Remove leading and trailing whitespace
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
+        std::string_view line = trimLine(rawLine);
 
         // Skip empty lines
         if (line.empty())
@@ -144,55 +1327,74 @@ void ClickScript::load_ClickScript_fromfile(const std::string &filename)
         if (line == "#start")
         {
             inCommandBlock = true;
-            MyLogger::getInstance().debug("Found start marker");
+            MYLOG_DEBUG("Found start marker");
             continue;
         }
         else if (line == "#end")
         {
             inCommandBlock = false;
-            MyLogger::getInstance().debug("Found end marker");
+            MYLOG_DEBUG("Found end marker");
             break;
         }
 
-        // Only process data inside the command block
+        // Only process data inside the command block, columns count from the raw line
         if (inCommandBlock)
         {
-            Behavior behavior = parseCommandLine(line);
+            Behavior behavior = parseCommandLine(rawLine, lineNumber);
             if (behavior.action != NONE)
             {
-                addBehavior(behavior);
-                MyLogger::getInstance().debug("Parsed command: " + line);
-            }
-            else
-            {
-                MyLogger::getInstance().warning("Invalid or ignored command: " + line);
+                behavior.line = static_cast<int>(lineNumber);
+                appendLinked(behavior);
             }
         }
     }
 
-    file.close();
-    MyLogger::getInstance().info("Loaded " + std::to_string(behaviors.size()) + " behaviors");
+    finishStructure();
+    MYLOG_INFO("Loaded {} behaviors ({} errors)", behaviors.size(), errors.size());
+
+    compile();
+    bindTexts();
+    if (!verifyProgram())
+    {
+        MYLOG_WARNING("Compiled program failed verification, falling back to reference interpreter.");
+        program.clear();
+    }
+    // A cache hit reports no errors, so only scripts that parsed cleanly are cached
+    else if (stamped && errors.empty() && ProgramCache::save(filename, sourceStamp, content, program))
+    {
+        MYLOG_DEBUG("Wrote compiled cache {}", ProgramCache::cachePathFor(filename));
+    }
 }
 
 void ClickScript::save_ClickScript_tofile(const std::string &filename)
 {
     // TODO: Implementation for saving ClickScript to a file
-    MyLogger::getInstance().info("Saving ClickScript to file: " + filename);
+    MYLOG_INFO("Saving ClickScript to file: {}", filename);
 }
 
 void ClickScript::print_ClickScript()
 {
     if (behaviors.empty())
     {
-        MyLogger::getInstance().warning("No behaviors to print in ClickScript.");
+        MYLOG_WARNING("No behaviors to print in ClickScript.");
         return;
     }
-    system("cls");
+    platform::clearScreen();
     std::cout << "--- ClickScript Checklist ---" << std::endl;
     std::cout << "Loops: " << loops << std::endl;
     std::cout << "-----------------------------" << std::endl;
+    // Blocks are printed as written, their bodies indented
+    size_t depth = 0;
     for (const auto &behavior : behaviors)
     {
+        if (behavior.action == BLOCK_END && depth > 0)
+        {
+            --depth;
+        }
+        if (behavior.action != NONE)
+        {
+            std::cout << std::string(depth * 4, ' ');
+        }
         switch (behavior.action)
         {
         case LEFT_CLICK:
@@ -210,13 +1412,60 @@ void ClickScript::print_ClickScript()
         case LOOP_NUMBER_KEY:
             std::cout << "stimulate LOOP_NUMBER_KEY input" << std::endl;
             break;
+        case TYPE_TEXT:
+            std::cout << "TYPE: " << texts[behavior.text] << std::endl;
+            break;
+        case PASTE_TEXT:
+            std::cout << (behavior.from_file ? "PASTE FILE: " : "PASTE: ") << texts[behavior.text] << std::endl;
+            break;
+        case WAIT_FILE:
+        case WAIT_FILE_COUNT:
+        {
+            const WaitSpec &wait = waits[behavior.wait];
+            if (behavior.action == WAIT_FILE)
+                std::cout << "WAIT_FILE: " << texts[wait.pattern];
+            else
+                std::cout << "WAIT_FILE_COUNT: " << (wait.flags & WAIT_RELATIVE_COUNT ? "+" : "") << wait.count;
+            std::cout << " in " << texts[wait.directory] << ", " << wait.timeoutMs << " ms, else "
+                      << WAIT_POLICY_NAMES[static_cast<size_t>(wait.policy)] << std::endl;
+            break;
+        }
+        case WAIT_PIXEL:
+        case WAIT_REGION_CHANGE:
+        {
+            const WaitSpec &wait = waits[behavior.wait];
+            std::cout << (behavior.action == WAIT_PIXEL ? "WAIT_PIXEL: " : "WAIT_REGION_CHANGE: ") << wait.x << " "
+                      << wait.y;
+            if (behavior.action == WAIT_PIXEL)
+                std::cout << " #" << std::hex << std::uppercase << std::setw(6) << std::setfill('0') << wait.color
+                          << std::dec << std::nouppercase << std::setfill(' ');
+            else
+                std::cout << " " << wait.width << "x" << wait.height;
+            std::cout << " within " << static_cast<int>(wait.tolerance) << ", " << wait.timeoutMs << " ms, else "
+                      << WAIT_POLICY_NAMES[static_cast<size_t>(wait.policy)] << std::endl;
+            break;
+        }
+        case REPEAT_BEGIN:
+            std::cout << "REPEAT " << behavior.count << " times:" << std::endl;
+            ++depth;
+            break;
+        case SUB_BEGIN:
+            std::cout << "SUB " << subNames[behavior.sub] << ":" << std::endl;
+            ++depth;
+            break;
+        case BLOCK_END:
+            std::cout << "END" << std::endl;
+            break;
+        case CALL_SUB:
+            std::cout << "CALL " << subNames[behavior.sub] << std::endl;
+            break;
         default:
             break;
         }
     }
 }
 
-Behavior ClickScript::parseCommandLine(const std::string &line)
+Behavior ClickScript::parseCommandLine(std::string_view line, size_t lineNumber)
 {
     Behavior behavior;
     behavior.action = NONE;
@@ -224,87 +1473,459 @@ Behavior ClickScript::parseCommandLine(const std::string &line)
     behavior.key = '\0';
     behavior.delay = 0;
 
-    std::istringstream iss(line);
-    std::string command;
+    LineTokenizer tokens(line);
+    std::string_view command;
 
     // Read the first word as the command
-    if (!(iss >> command))
+    if (!tokens.next(command))
     {
-        MyLogger::getInstance().error("Failed to parse command line: " + line);
+        reportError(lineNumber, tokens.column(), "Empty command line");
         return behavior; // Empty or invalid line
     }
+    size_t commandColumn = tokens.column();
+    Keyword keyword = lookupKeyword(command);
 
-    if (command == "LEFT")
+    switch (keyword)
+    {
+    case Keyword::LEFT:
+    case Keyword::RIGHT:
     {
         int x, y;
-        if (iss >> x >> y)
+        if (tokens.nextInt(x) && tokens.nextInt(y))
         {
-            behavior.action = LEFT_CLICK;
+            behavior.action = keyword == Keyword::LEFT ? LEFT_CLICK : RIGHT_CLICK;
             behavior.point.x = x;
             behavior.point.y = y;
-            MyLogger::getInstance().debug("Parsed LEFT click at (" + std::to_string(x) + ", " + std::to_string(y) + ")");
         }
         else
         {
-            MyLogger::getInstance().error("LEFT command requires two coordinates");
+            reportError(lineNumber, tokens.column(), std::string(command) + " command requires two coordinates");
         }
+        break;
     }
-    else if (command == "RIGHT")
+    case Keyword::DELAY:
     {
-        int x, y;
-        if (iss >> x >> y)
+        int delayMs;
+        if (tokens.nextInt(delayMs))
         {
-            behavior.action = RIGHT_CLICK;
-            behavior.point.x = x;
-            behavior.point.y = y;
-            MyLogger::getInstance().debug("Parsed RIGHT click at (" + std::to_string(x) + ", " + std::to_string(y) + ")");
+            behavior.action = DELAY;
+            behavior.delay = delayMs;
         }
         else
         {
-            MyLogger::getInstance().error("RIGHT command requires two coordinates");
+            reportError(lineNumber, tokens.column(), "DELAY command requires a duration");
         }
+        break;
     }
-    else if (command == "DELAY")
+    case Keyword::ENTER:
+        behavior.action = ENTER_KEY;
+        behavior.key = '\n'; // or '\r'
+        break;
+    case Keyword::LOOP_NUMBER_KEY:
+        behavior.action = LOOP_NUMBER_KEY;
+        behavior.loop_number_input = true;
+        break;
+    case Keyword::TYPE:
+    case Keyword::PASTE:
     {
-        int delayMs;
-        if (iss >> delayMs)
+        // PASTE FILE "path" pastes the file content as it is
+        LineTokenizer probe = tokens;
+        std::string_view word;
+        bool fromFile = keyword == Keyword::PASTE && probe.next(word) && word == "FILE";
+        if (fromFile)
         {
-            behavior.action = DELAY;
-            behavior.delay = delayMs;
-            MyLogger::getInstance().debug("Parsed DELAY of " + std::to_string(delayMs) + "ms");
+            tokens = probe;
+        }
+        std::string text;
+        if (!tokens.nextQuoted(text))
+        {
+            reportError(lineNumber, tokens.column(),
+                        std::string(command) + " command requires a double-quoted text (escapes \\\" \\\\ \\n \\t)");
+            break;
+        }
+        // Checked now, config values are filled in by bindTexts()
+        TextTemplate check;
+        std::string message;
+        size_t offset = 0;
+        auto output = keyword == Keyword::TYPE ? TextTemplate::Output::KEYS : TextTemplate::Output::TEXT;
+        if (!fromFile && !check.compile(text, nullptr, message, offset, output))
+        {
+            reportError(lineNumber, tokens.column(),
+                        std::string(command) + " text: " + message + " (character " + std::to_string(offset + 1) + ")");
+            break;
+        }
+        behavior.action = keyword == Keyword::TYPE ? TYPE_TEXT : PASTE_TEXT;
+        behavior.text = static_cast<int>(texts.size());
+        behavior.from_file = fromFile;
+        texts.push_back(std::move(text));
+        break;
+    }
+    case Keyword::WAIT_FILE:
+    case Keyword::WAIT_FILE_COUNT:
+    {
+        // The directory is a configuration key such as PATH_1, or a quoted path
+        WaitSpec wait;
+        std::string directory;
+        std::string_view word;
+        LineTokenizer probe = tokens;
+        if (probe.next(word) && word.front() == '"')
+        {
+            if (!tokens.nextQuoted(directory))
+            {
+                reportError(lineNumber, tokens.column(), std::string(command) + " directory: unterminated path");
+                break;
+            }
+            wait.flags |= WAIT_LITERAL_DIRECTORY;
+        }
+        else if (tokens.next(word))
+        {
+            directory = word;
+        }
+        else
+        {
+            reportError(lineNumber, tokens.column(),
+                        std::string(command) + " command requires a directory (configuration key or quoted path)");
+            break;
+        }
+
+        std::string pattern;
+        if (keyword == Keyword::WAIT_FILE)
+        {
+            if (!tokens.nextQuoted(pattern))
+            {
+                reportError(lineNumber, tokens.column(), "WAIT_FILE command requires a double-quoted file name pattern");
+                break;
+            }
+            TextTemplate check;
+            std::string message;
+            size_t offset = 0;
+            if (!check.compile(pattern, nullptr, message, offset, TextTemplate::Output::TEXT))
+            {
+                reportError(lineNumber, tokens.column(),
+                            "WAIT_FILE pattern: " + message + " (character " + std::to_string(offset + 1) + ")");
+                break;
+            }
         }
         else
         {
-            MyLogger::getInstance().error("DELAY command requires a duration");
+            // +N counts from the number of files at the start of the round
+            bool parsed = tokens.next(word);
+            if (parsed && word.front() == '+')
+            {
+                wait.flags |= WAIT_RELATIVE_COUNT;
+                word.remove_prefix(1);
+            }
+            auto result = std::from_chars(word.data(), word.data() + word.size(), wait.count);
+            if (!parsed || word.empty() || result.ec != std::errc() || result.ptr != word.data() + word.size())
+            {
+                reportError(lineNumber, tokens.column(),
+                            "WAIT_FILE_COUNT command requires a file count, +N counts from the start of the round");
+                break;
+            }
+        }
+
+        if (!parseWaitEnd(tokens, command, lineNumber, wait))
+            break;
+
+        behavior.action = keyword == Keyword::WAIT_FILE ? WAIT_FILE : WAIT_FILE_COUNT;
+        behavior.wait = static_cast<int>(waits.size());
+        wait.directory = static_cast<uint32_t>(texts.size());
+        texts.push_back(std::move(directory));
+        if (keyword == Keyword::WAIT_FILE)
+        {
+            wait.pattern = static_cast<uint32_t>(texts.size());
+            texts.push_back(std::move(pattern));
         }
+        waits.push_back(wait);
+        break;
     }
-    else if (command == "ENTER")
+    case Keyword::WAIT_PIXEL:
+    case Keyword::WAIT_REGION_CHANGE:
     {
-        behavior.action = ENTER_KEY;
-        behavior.key = '\n'; // or '\r'
-        MyLogger::getInstance().debug("Parsed ENTER key press");
+        WaitSpec wait;
+        wait.flags = WAIT_SCREEN;
+        int x, y;
+        if (!tokens.nextInt(x) || !tokens.nextInt(y))
+        {
+            reportError(lineNumber, tokens.column(), std::string(command) + " command requires two coordinates");
+            break;
+        }
+        wait.x = x;
+        wait.y = y;
+
+        if (keyword == Keyword::WAIT_PIXEL)
+        {
+            // Colour as RRGGBB hex, a leading # is allowed
+            std::string_view color;
+            bool parsed = tokens.next(color);
+            if (parsed && color.front() == '#')
+                color.remove_prefix(1);
+            auto result = std::from_chars(color.data(), color.data() + color.size(), wait.color, 16);
+            if (!parsed || color.size() != 6 || result.ec != std::errc() || result.ptr != color.data() + color.size())
+            {
+                reportError(lineNumber, tokens.column(), "WAIT_PIXEL command requires a colour as RRGGBB");
+                break;
+            }
+        }
+        else
+        {
+            int width, height;
+            if (!tokens.nextInt(width) || !tokens.nextInt(height) || width <= 0 || height <= 0)
+            {
+                reportError(lineNumber, tokens.column(), "WAIT_REGION_CHANGE command requires a positive width and height");
+                break;
+            }
+            wait.width = static_cast<uint32_t>(width);
+            wait.height = static_cast<uint32_t>(height);
+        }
+
+        int tolerance;
+        if (!tokens.nextInt(tolerance) || tolerance < 0 || tolerance > 255)
+        {
+            reportError(lineNumber, tokens.column(),
+                        std::string(command) + " command requires a colour tolerance from 0 to 255");
+            break;
+        }
+        wait.tolerance = static_cast<uint8_t>(tolerance);
+        if (!parseWaitEnd(tokens, command, lineNumber, wait))
+            break;
+
+        behavior.action = keyword == Keyword::WAIT_PIXEL ? WAIT_PIXEL : WAIT_REGION_CHANGE;
+        behavior.wait = static_cast<int>(waits.size());
+        waits.push_back(wait);
+        break;
     }
-    else if (command == "LOOP_NUMBER_KEY")
+    case Keyword::REPEAT:
     {
-        behavior.action = LOOP_NUMBER_KEY;
-        behavior.loop_number_input = true;
-        MyLogger::getInstance().debug("Parsed LOOP number input");
+        int count;
+        if (tokens.nextInt(count) && count >= 0)
+        {
+            behavior.action = REPEAT_BEGIN;
+            behavior.count = count;
+        }
+        else
+        {
+            reportError(lineNumber, tokens.column(), "REPEAT command requires a non-negative count");
+        }
+        break;
     }
-    else
+    case Keyword::SUB:
+    case Keyword::CALL:
     {
+        std::string_view name;
+        if (tokens.next(name))
+        {
+            behavior.action = keyword == Keyword::SUB ? SUB_BEGIN : CALL_SUB;
+            behavior.sub = subroutineIndex(name);
+        }
+        else
+        {
+            reportError(lineNumber, tokens.column(), std::string(command) + " command requires a subroutine name");
+        }
+        break;
+    }
+    case Keyword::END:
+        behavior.action = BLOCK_END;
+        break;
+    case Keyword::UNKNOWN:
+    default:
         // Unknown command, enhance error robustness
-        MyLogger::getInstance().warning("Unknown command: " + command + " - line ignored");
-        behavior.action = NONE;
+        reportError(lineNumber, commandColumn, "Unknown command: " + std::string(command) + " - line ignored");
+        return behavior;
     }
 
+    if (behavior.action != NONE && !tokens.atEnd())
+    {
+        reportError(lineNumber, tokens.column(), "Unexpected text after " + std::string(command) + " ignored");
+    }
     return behavior;
 }
 
+bool ClickScript::parseWaitEnd(LineTokenizer &tokens, std::string_view command, size_t lineNumber, WaitSpec &wait)
+{
+    int timeoutMs;
+    if (!tokens.nextInt(timeoutMs) || timeoutMs < 0)
+    {
+        reportError(lineNumber, tokens.column(), std::string(command) + " command requires a timeout in ms");
+        return false;
+    }
+    wait.timeoutMs = static_cast<uint32_t>(timeoutMs);
+
+    // What to do on a timeout, STOP unless given
+    LineTokenizer probe = tokens;
+    std::string_view word;
+    if (probe.next(word))
+    {
+        size_t policy = 0;
+        while (policy < std::size(WAIT_POLICY_NAMES) && word != WAIT_POLICY_NAMES[policy])
+            ++policy;
+        if (policy == std::size(WAIT_POLICY_NAMES))
+        {
+            reportError(lineNumber, probe.column(),
+                        "Unknown timeout policy " + std::string(word) + ", expected CONTINUE, SKIP or STOP");
+            return false;
+        }
+        wait.policy = static_cast<WaitPolicy>(policy);
+        tokens = probe;
+    }
+    return true;
+}
+
+int ClickScript::subroutineIndex(std::string_view name)
+{
+    auto it = subLookup.find(std::string(name));
+    if (it != subLookup.end())
+    {
+        return it->second;
+    }
+    int index = static_cast<int>(subNames.size());
+    subNames.emplace_back(name);
+    subDefinitions.push_back(-1);
+    subLookup.emplace(subNames.back(), index);
+    return index;
+}
+
+void ClickScript::appendLinked(Behavior behavior)
+{
+    const int index = static_cast<int>(behaviors.size());
+    switch (behavior.action)
+    {
+    case SUB_BEGIN:
+        if (!openBlocks.empty() || subDefinitions[behavior.sub] >= 0)
+        {
+            // Keep the block so its END still matches, but never run the body
+            reportError(behavior.line, 1,
+                        openBlocks.empty() ? "Subroutine " + subNames[behavior.sub] + " is already defined"
+                                           : "SUB " + subNames[behavior.sub] + " must be defined outside other blocks");
+            behavior.action = REPEAT_BEGIN;
+            behavior.count = 0;
+            behavior.sub = -1;
+        }
+        else
+        {
+            subDefinitions[behavior.sub] = index;
+        }
+        openBlocks.push_back(static_cast<size_t>(index));
+        break;
+    case REPEAT_BEGIN:
+        openBlocks.push_back(static_cast<size_t>(index));
+        break;
+    case BLOCK_END:
+        if (openBlocks.empty())
+        {
+            reportError(behavior.line, 1, "END without REPEAT or SUB ignored");
+            return;
+        }
+        behaviors[openBlocks.back()].end = index;
+        openBlocks.pop_back();
+        break;
+    default:
+        break;
+    }
+    addBehavior(behavior);
+}
+
+void ClickScript::finishStructure()
+{
+    // Blocks still open at #end are closed there
+    while (!openBlocks.empty())
+    {
+        reportError(behaviors[openBlocks.back()].line, 1, "Block is missing its END, closed at the end of the script");
+        Behavior end;
+        end.action = BLOCK_END;
+        appendLinked(end);
+    }
+
+    // CALL targets must exist and must not call back into themselves
+    for (auto &behavior : behaviors)
+    {
+        if (behavior.action == CALL_SUB && subDefinitions[behavior.sub] < 0)
+        {
+            reportError(behavior.line, 1, "CALL of undefined subroutine " + subNames[behavior.sub] + " ignored");
+            behavior.action = NONE;
+        }
+    }
+
+    // Depth-first walk of the call graph: 0 unvisited, 1 on the current path, 2 done.
+    // Also computes how deep REPEAT / CALL nest at run time.
+    std::vector<int> state(subNames.size(), 0);
+    std::vector<size_t> depth(subNames.size(), 0);
+    std::function<size_t(size_t, size_t)> rangeDepth = [&](size_t begin, size_t end) -> size_t
+    {
+        size_t deepest = 0;
+        size_t nesting = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            Behavior &behavior = behaviors[i];
+            if (behavior.action == SUB_BEGIN)
+            {
+                i = behavior.end;
+            }
+            else if (behavior.action == REPEAT_BEGIN)
+            {
+                deepest = std::max(deepest, ++nesting);
+            }
+            else if (behavior.action == BLOCK_END && nesting > 0)
+            {
+                --nesting;
+            }
+            else if (behavior.action == CALL_SUB)
+            {
+                size_t sub = static_cast<size_t>(behavior.sub);
+                if (state[sub] == 1)
+                {
+                    reportError(behavior.line, 1, "Recursive CALL of " + subNames[sub] + " ignored");
+                    behavior.action = NONE;
+                    continue;
+                }
+                if (state[sub] == 0)
+                {
+                    state[sub] = 1;
+                    int definition = subDefinitions[sub];
+                    depth[sub] = rangeDepth(definition + 1, behaviors[definition].end);
+                    state[sub] = 2;
+                }
+                deepest = std::max(deepest, nesting + 1 + depth[sub]);
+            }
+        }
+        return deepest;
+    };
+
+    size_t deepest = rangeDepth(0, behaviors.size());
+    for (size_t sub = 0; sub < subNames.size(); ++sub)
+    {
+        if (subDefinitions[sub] >= 0 && state[sub] == 0)
+        {
+            state[sub] = 1;
+            depth[sub] = rangeDepth(subDefinitions[sub] + 1, behaviors[subDefinitions[sub]].end);
+            state[sub] = 2;
+        }
+    }
+    if (deepest > MAX_NESTING)
+    {
+        reportError(1, 1, "REPEAT / CALL nesting of " + std::to_string(deepest) + " levels exceeds the limit of " +
+                              std::to_string(MAX_NESTING));
+    }
+}
+
+void ClickScript::reportError(size_t lineNumber, size_t column, std::string message)
+{
+    ++lineErrors;
+    if (quietErrors)
+        return;
+    ScriptError error;
+    error.line = lineNumber;
+    error.column = column;
+    error.message = std::move(message);
+    MYLOG_WARNING("{}", error.toString(filename));
+    errors.push_back(std::move(error));
+}
+
 int ClickScript::get_loops()
 {
     std::cout << "Please enter the number of loops: ";
     std::cin >> loops;
-    MyLogger::getInstance().debug("Retrieving number of loops: " + std::to_string(loops));
+    MYLOG_DEBUG("Retrieving number of loops: {}", loops);
     return loops;
 }
 
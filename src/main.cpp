@@ -1,7 +1,6 @@
 // TODO: Description support for ClickScript
 // TODO: Log System
 // TODO: what if load task failed
-// TODO: make the countdown changeable
 // TODO: *clk* path support
 
 #define MAIN_RELEASE 1
@@ -15,14 +14,258 @@
 
 #if MAIN_RELEASE
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 #include "MyLogger.h"
 #include "Config.h"
 #include "system.h"
 #include "clickscript.h"
 
-int main()
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage:\n"
+                  << "  ClickScript                                  interactive menu\n"
+                  << "  ClickScript run <script> [options]           one headless run\n"
+                  << "  ClickScript batch <jobfile> [--config file]  one headless run per job line\n"
+                  << "  ClickScript precompile <directory> [threads] refresh the .clkc caches\n"
+                  << "Run options (also used on job lines):\n"
+                  << "  --loops N        rounds to execute (default 1)\n"
+                  << "  --start HH:MM    wait for this local time instead of the countdown\n"
+                  << "  --countdown S    seconds before the first round (default 0)\n"
+                  << "  --config file    configuration for this run\n"
+                  << "  --simulate       virtual-clock dry run before the real one\n";
+    }
+
+    // Split a job line on whitespace, "double quotes" keep paths with spaces together.
+    // A # that starts a word outside quotes comments out the rest of the line.
+    std::vector<std::string> splitArguments(const std::string &line)
+    {
+        std::vector<std::string> args;
+        std::string current;
+        bool quoted = false, pending = false;
+        for (char c : line)
+        {
+            if (c == '"')
+            {
+                quoted = !quoted;
+                pending = true;
+            }
+            else if (!quoted && !pending && c == '#')
+                break;
+            else if (!quoted && (c == ' ' || c == '\t' || c == '\r'))
+            {
+                if (pending)
+                    args.push_back(current);
+                current.clear();
+                pending = false;
+            }
+            else
+            {
+                current += c;
+                pending = true;
+            }
+        }
+        if (pending)
+            args.push_back(current);
+        return args;
+    }
+
+    // <script> [--loops N] [--start HH:MM] [--countdown S] [--config file] [--simulate]
+    bool parseRunArguments(const std::vector<std::string> &args, System::RunOptions &options, std::string &configFile,
+                           std::string &error)
+    {
+        options = System::RunOptions();
+        options.interactive = false;
+        options.loops = 1;
+        options.countdownSeconds = 0;
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            const std::string &arg = args[i];
+            bool hasValue = i + 1 < args.size();
+            try
+            {
+                if (arg == "--loops" && hasValue)
+                    options.loops = std::stoi(args[++i]);
+                else if (arg == "--countdown" && hasValue)
+                    options.countdownSeconds = std::stoi(args[++i]);
+                else if (arg == "--config" && hasValue)
+                    configFile = args[++i];
+                else if (arg == "--start" && hasValue)
+                {
+                    if (!System::parseStartTime(args[++i], options.startHour, options.startMinute))
+                    {
+                        error = "invalid start time " + args[i];
+                        return false;
+                    }
+                }
+                else if (arg == "--simulate")
+                    options.preflight = "ENABLE";
+                else if (arg.rfind("--", 0) == 0)
+                {
+                    error = "unknown or incomplete option " + arg;
+                    return false;
+                }
+                else if (options.script.empty())
+                    options.script = arg;
+                else
+                {
+                    error = "unexpected argument " + arg;
+                    return false;
+                }
+            }
+            catch (const std::exception &)
+            {
+                error = "invalid number for " + arg;
+                return false;
+            }
+        }
+        if (options.script.empty())
+        {
+            error = "no script given";
+            return false;
+        }
+        if (options.loops < 0 || options.countdownSeconds < 0)
+        {
+            error = "negative loops or countdown";
+            return false;
+        }
+        return true;
+    }
+
+    // run <script> [options]: one run without any prompt
+    int runHeadless(const std::vector<std::string> &args)
+    {
+        System::RunOptions options;
+        std::string configFile = "config.txt";
+        std::string error;
+        if (!parseRunArguments(args, options, configFile, error))
+        {
+            std::cerr << "run: " << error << std::endl;
+            printUsage();
+            return 2;
+        }
+        System system;
+        system.initialize(configFile);
+        return system.runScript(options) ? 0 : 1;
+    }
+
+    // batch <jobfile> [--config file]: one run per line with arguments, in order.
+    // ESC stops the current job and skips the rest.
+    int runBatch(const std::string &jobFile, const std::string &defaultConfig)
+    {
+        std::ifstream in(jobFile);
+        if (!in.is_open())
+        {
+            std::cerr << "batch: cannot open " << jobFile << std::endl;
+            return 2;
+        }
+
+        struct Job
+        {
+            int line;
+            System::RunOptions options;
+            std::string configFile;
+        };
+        std::vector<Job> jobs;
+        std::string line;
+        int lineNumber = 0;
+        bool valid = true;
+        while (std::getline(in, line))
+        {
+            ++lineNumber;
+            std::vector<std::string> args = splitArguments(line);
+            if (args.empty())
+                continue;
+            Job job{lineNumber, {}, defaultConfig};
+            std::string error;
+            if (!parseRunArguments(args, job.options, job.configFile, error))
+            {
+                std::cerr << jobFile << ":" << lineNumber << ": " << error << std::endl;
+                valid = false;
+                continue;
+            }
+            jobs.push_back(std::move(job));
+        }
+        // Reject the whole file up front rather than failing halfway through
+        if (!valid)
+            return 2;
+
+        System system;
+        system.initialize(defaultConfig);
+        MYLOG_INFO("Batch {}: {} jobs", jobFile, jobs.size());
+
+        std::vector<std::string> results(jobs.size(), "skipped");
+        int failed = 0;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            const Job &job = jobs[i];
+            std::cout << "\n=== Job " << (i + 1) << "/" << jobs.size() << ": " << job.options.script << " ===" << std::endl;
+            if (!system.loadConfig(job.configFile))
+            {
+                results[i] = "failed (config " + job.configFile + ")";
+                ++failed;
+                continue;
+            }
+            bool ok = system.runScript(job.options);
+            if (ok)
+            {
+                results[i] = "completed";
+                continue;
+            }
+            ++failed;
+            if (system.getRunToken().stopRequested())
+            {
+                results[i] = "stopped";
+                failed += static_cast<int>(jobs.size() - i - 1); // The rest stay skipped
+                break;
+            }
+            results[i] = "failed";
+        }
+
+        std::cout << "\n=== Batch summary (" << jobs.size() - failed << "/" << jobs.size() << " completed) ===" << std::endl;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            std::cout << "  line " << jobs[i].line << ": " << jobs[i].options.script << " - " << results[i] << std::endl;
+            MYLOG_INFO("Batch job line {} ({}): {}", jobs[i].line, jobs[i].options.script, results[i]);
+        }
+        MyLogger::getInstance().flush();
+        return failed == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char *argv[])
 {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    // precompile <directory> [threads]: refresh the .clkc cache of every script
+    if (args.size() >= 2 && args[0] == "precompile")
+    {
+        System system;
+        int threads = args.size() >= 3 ? std::atoi(args[2].c_str()) : 0;
+        return system.precompileScripts(args[1], threads) ? 0 : 1;
+    }
+    if (!args.empty() && args[0] == "run")
+    {
+        return runHeadless(std::vector<std::string>(args.begin() + 1, args.end()));
+    }
+    if (args.size() >= 2 && args[0] == "batch")
+    {
+        std::string configFile = "config.txt";
+        if (args.size() >= 4 && args[2] == "--config")
+            configFile = args[3];
+        return runBatch(args[1], configFile);
+    }
+    if (!args.empty())
+    {
+        printUsage();
+        return args[0] == "--help" || args[0] == "-h" ? 0 : 2;
+    }
+
     System system;
     system.initialize();
 
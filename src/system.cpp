@@ -1,33 +1,51 @@
 #include "system.h"
 
-// Global variables
-std::atomic<bool> g_isRunning{false};
-std::atomic<int> g_currentProgress{0};
-std::atomic<int> g_totalProgress{10};
-ITaskbarList3 *g_pTaskbarList = nullptr;
-HWND g_consoleWindow = nullptr;
 
-// Global emergency stop flag
-std::atomic<bool> g_emergencyStop{false};
-
-void System::initialize()
+void System::initialize(const std::string &configFile)
 {
     std::cout << "Initializing system..." << std::endl;
     MyLogger::getInstance().setLogFile("system.log");
     MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_DEBUG);
 
-    MyLogger::getInstance().info("Running initialization...");
+    MYLOG_INFO("Running initialization...");
+    config.setFilename(configFile);
     if (this->config.load())
     {
-        MyLogger::getInstance().debug("Configuration loaded successfully.");
+        MYLOG_DEBUG("Configuration loaded successfully.");
     }
     else
     {
-        MyLogger::getInstance().debug("Failed to load configuration.");
+        MYLOG_DEBUG("Failed to load configuration.");
         std::cout << "Failed to load configuration, creating an empty one..." << std::endl;
     }
 
-    MyLogger::getInstance().debug("System initialization finished.");
+    // Logging mode, asynchronous unless Log_Mode=SYNC
+    if (config.get("Log_Mode", "ASYNC") == "ASYNC")
+    {
+        std::string overflow = config.get("Log_Overflow", "BLOCK");
+        MyLogger::OverflowPolicy policy = MyLogger::OverflowPolicy::BLOCK;
+        if (overflow == "DROP")
+            policy = MyLogger::OverflowPolicy::DROP;
+        else if (overflow == "COUNT")
+            policy = MyLogger::OverflowPolicy::DROP_COUNT;
+
+        size_t queueSize = 8192;
+        try
+        {
+            queueSize = std::stoul(config.get("Log_Queue_Size", "8192"));
+        }
+        catch (const std::exception &)
+        {
+            MYLOG_WARNING("Invalid Log_Queue_Size, using 8192.");
+        }
+        MyLogger::getInstance().enableAsync(queueSize, policy);
+        MYLOG_DEBUG("Asynchronous logging enabled (queue {}, overflow {}).", queueSize, overflow);
+    }
+
+    // Measure how precisely this machine can sleep, used by DELAY
+    DelayScheduler::calibrate();
+
+    MYLOG_DEBUG("System initialization finished.");
     // Perform system initialization tasks
 }
 
@@ -41,7 +59,7 @@ void System::runMainLoop()
         if (choice == 0)
         {
             std::cout << "Exiting program..." << std::endl;
-            MyLogger::getInstance().info("Program exited by user.");
+            MYLOG_INFO("Program exited by user.");
             break;
         }
 
@@ -67,23 +85,23 @@ void System::executeChoice(int choice)
     switch (choice)
     {
     case 0:
-        system("cls");
+        platform::clearScreen();
         temporaryTask();
         break;
     case 1:
-        system("cls");
+        platform::clearScreen();
         startAutoclickScript();
         break;
     case 2:
-        system("cls");
+        platform::clearScreen();
         measureMousePosition();
         break;
     case 3:
-        system("cls");
+        platform::clearScreen();
         configInit();
         break;
     default:
-        system("cls");
+        platform::clearScreen();
         std::cout << "Invalid choice. Please try again." << std::endl;
         break;
     }
@@ -96,13 +114,6 @@ void System::executeChoice(int choice)
 
 void System::startAutoclickScript()
 {
-    MyLogger::getInstance().splitLine();
-    MyLogger::getInstance().info("Autoclick script started.");
-
-    // === Load ClickScript ===
-
-    ClickScript ClickScript;
-
     std::cout << "Please enter the task to be loaded (e.g., task1.clk --- default: task.clk): ";
     std::string filename;
     std::getline(std::cin, filename);
@@ -112,95 +123,232 @@ void System::startAutoclickScript()
         std::cout << "No input detected. Using default: " << filename << std::endl;
     }
 
+    RunOptions options;
+    options.script = filename;
+    runScript(options);
+}
+
+bool System::parseStartTime(const std::string &text, int &hour, int &minute)
+{
+    std::string spaced = text;
+    std::replace(spaced.begin(), spaced.end(), ':', ' ');
+    std::istringstream iss(spaced);
+    int h = -1, m = -1;
+    if (!(iss >> h >> m) || h < 0 || h >= 24 || m < 0 || m >= 60)
+        return false;
+    hour = h;
+    minute = m;
+    return true;
+}
+
+bool System::useStreaming(const std::string &script)
+{
+    std::string mode = config.get("Script_Streaming", "AUTO");
+    if (mode == "ENABLE")
+        return true;
+    if (mode != "AUTO")
+        return false;
+    uint64_t thresholdMb = 256;
+    try
+    {
+        thresholdMb = std::stoull(config.get("Script_Stream_Threshold_MB", "256"));
+    }
+    catch (const std::exception &)
+    {
+        MYLOG_WARNING("Invalid Script_Stream_Threshold_MB, using 256.");
+    }
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(script, ec);
+    return !ec && size >= thresholdMb * 1024 * 1024;
+}
+
+bool System::loadConfig(const std::string &path)
+{
+    config.setFilename(path);
+    if (!config.load())
+    {
+        MYLOG_ERROR("Failed to load configuration {}", path);
+        return false;
+    }
+    MYLOG_DEBUG("Configuration {} loaded.", path);
+    return true;
+}
+
+bool System::runScript(RunOptions options)
+{
+    MyLogger::getInstance().splitLine();
+    MYLOG_INFO("Autoclick script started ({}).", options.interactive ? "interactive" : "headless");
+
+    // === Load ClickScript ===
+
+    ClickScript ClickScript;
+
     int loops = 0;
     std::string path1 = config.get("PATH_1");
     std::string path2 = config.get("PATH_2");
 
-    ClickScript.load_ClickScript_fromfile(filename);
-    loops = ClickScript.get_loops();
-    ClickScript.print_ClickScript();
-    std::cout << "-----------------------------" << std::endl;
-    config.print();
-    std::cout << "-----------------------------" << std::endl;
-    std::cout << "Press Enter to confirm and start" << std::endl;
-    std::cin.clear();
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    ClickScript.setCacheEnabled(config.get("Script_Cache", "ENABLE") == "ENABLE");
+    ClickScript.setConfig(&config);
+    if (useStreaming(options.script))
+    {
+        size_t queueSize = 4096;
+        try
+        {
+            queueSize = std::stoul(config.get("Stream_Queue_Size", "4096"));
+        }
+        catch (const std::exception &)
+        {
+            MYLOG_WARNING("Invalid Stream_Queue_Size, using 4096.");
+        }
+        if (!ClickScript.openStream(options.script, queueSize))
+        {
+            std::cerr << "Failed to open " << options.script << " for streaming" << std::endl;
+            return false;
+        }
+        std::cout << "Streaming " << options.script << " (parsed while running, not held in memory)." << std::endl;
+    }
+    else
+    {
+        ClickScript.load_ClickScript_fromfile(options.script);
+    }
+    if (!options.interactive && !ClickScript.isStreaming() &&
+        (ClickScript.getProgram().size() == 0 || !ClickScript.getErrors().empty()))
+    {
+        // Nobody is there to look at the listing and decide, refuse the run
+        std::cerr << "Failed to load " << options.script << std::endl;
+        MYLOG_ERROR("Headless run of {} aborted, the script did not load cleanly.", options.script);
+        return false;
+    }
+    auto inputBackend = createInputBackend(config.get("Input_Backend"));
+    ClickScript.setInputBackend(inputBackend);
+    ClickScript.setTimingEnabled(config.get("Action_Timing", "ENABLE") == "ENABLE");
+    auto clipboard = createClipboardBackend(config.get("Clipboard_Backend"));
+    ClickScript.setClipboard(clipboard);
+    try
+    {
+        int settleMs = std::max(0, std::stoi(config.get("Paste_Settle_Ms", "50")));
+        ClickScript.setPasteSettleTime(std::chrono::milliseconds(settleMs));
+    }
+    catch (const std::exception &)
+    {
+        MYLOG_WARNING("Invalid Paste_Settle_Ms, using 50.");
+    }
+    auto screen = createScreenSource(config.get("Screen_Source"), config.get("Screen_File"));
+    ClickScript.setScreenSource(screen);
+    try
+    {
+        int pollMinMs = std::max(1, std::stoi(config.get("Screen_Poll_Min_Ms", "1")));
+        int pollMaxMs = std::max(1, std::stoi(config.get("Screen_Poll_Max_Ms", "50")));
+        ClickScript.setScreenPolling(std::chrono::milliseconds(pollMinMs), std::chrono::milliseconds(pollMaxMs));
+    }
+    catch (const std::exception &)
+    {
+        MYLOG_WARNING("Invalid Screen_Poll_Min_Ms / Screen_Poll_Max_Ms, using 1 / 50.");
+    }
+    MYLOG_INFO("Input backend: {}, clipboard: {}, screen: {} (pixel kernel {})", inputBackend->name(),
+               clipboard->name(), screen->name(), pixels::kernelName(pixels::best()));
+    if (options.loops < 0 && options.interactive)
+    {
+        loops = ClickScript.get_loops();
+    }
+    else
+    {
+        loops = std::max(0, options.loops);
+        ClickScript.set_loops(loops);
+    }
+    if (options.interactive && !ClickScript.isStreaming())
+    {
+        ClickScript.print_ClickScript();
+        std::cout << "-----------------------------" << std::endl;
+        config.print();
+        std::cout << "-----------------------------" << std::endl;
+    }
 
-    // Get console window handle
-    g_consoleWindow = GetConsoleWindow();
-    if (g_consoleWindow == NULL)
+    // Optional dry run on the virtual clock before anything is clicked
+    std::string preflight = options.preflight.empty() ? config.get("Preflight_Simulation", "ASK") : options.preflight;
+    if (preflight == "ASK" && options.interactive)
+    {
+        std::cout << "Simulate the run first? (y/N): ";
+        std::string answer;
+        std::getline(std::cin, answer);
+        if (answer == "y" || answer == "Y")
+        {
+            preflight = "ENABLE";
+        }
+    }
+    if (preflight == "ENABLE" && ClickScript.isStreaming())
+    {
+        std::cout << "Skipping the simulation, it would read the streamed script once per round." << std::endl;
+    }
+    else if (preflight == "ENABLE")
     {
-        std::cerr << "Failed to get console window handle!" << std::endl;
-        MyLogger::getInstance().error("Failed to get console window handle!");
-        return;
+        runPreflightSimulation(ClickScript, loops);
     }
 
-    // Initialize taskbar progress interface
-    bool taskbarInitialized = initializeTaskbarProgress();
-    if (!taskbarInitialized)
+    if (options.interactive)
     {
-        std::cerr << "Failed to initialize taskbar progress!" << std::endl;
-        MyLogger::getInstance().error("Failed to initialize taskbar progress!");
-        MyLogger::getInstance().warning("Continuing without taskbar progress.");
-        // Continue execution without progress bar
+        std::cout << "Press Enter to confirm and start" << std::endl;
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
 
     // ===== Initialize emergency stop listener =====
-    // Reset emergency stop flag
-    g_emergencyStop.store(false);
+    runToken.reset();
+    ClickScript.setCancellationToken(&runToken);
 
-    // Start ESC key listener thread
-    std::thread escapeThread(&System::escapeKeyListener, this);
-    escapeThread.detach(); // Detach thread to run in background
+    // The reactor watches ESC / Pause and publishes progress until the end of this run
+    ThreadManager &reactor = ThreadManager::getInstance();
+    if (!reactor.start())
+    {
+        std::cerr << "Failed to start the reactor thread, ESC / Pause are unavailable!" << std::endl;
+    }
+    reactor.beginRun(&runToken, loops);
+
+    // Progress is sampled on the reactor thread, the round loop only bumps counters
+    ProgressReporter progress(reactor);
+    progress.addSinks(config.get("Progress_Sinks", "TASKBAR,TITLE,TERMINAL"), config.get("Progress_File"));
+    int progressIntervalMs = 500;
+    try
+    {
+        progressIntervalMs = std::max(10, std::stoi(config.get("Progress_Interval_Ms", "500")));
+    }
+    catch (const std::exception &)
+    {
+        MYLOG_WARNING("Invalid Progress_Interval_Ms, using 500.");
+    }
 
     std::cout << std::endl
               << "=== EMERGENCY STOP ENABLED ===" << std::endl;
     std::cout << "Press ESC key at any time to immediately stop the procedure!" << std::endl;
-    MyLogger::getInstance().info("Emergency stop monitor activated - Press ESC to stop");
-
-    // Set total progress and current progress
-    g_totalProgress.store(loops);
-    g_currentProgress.store(0);
-
-    // Set running flag
-    g_isRunning.store(true);
-
-    // Set taskbar progress state to normal (green)
-    if (taskbarInitialized)
-    {
-        setTaskbarProgressState(TBPF_NORMAL);
-    }
+    std::cout << "Press Pause key to pause / resume between actions." << std::endl;
+    MYLOG_INFO("Emergency stop monitor activated - Press ESC to stop");
 
     std::cout << "ClickScript procedure will execute " << loops << " rounds." << std::endl
               << std::endl;
 
     MyLogger::getInstance().splitLine();
-    MyLogger::getInstance().info("ClickScript procedure will execute " + std::to_string(loops) + " rounds.");
+    MYLOG_INFO("ClickScript procedure will execute {} rounds.", loops);
 
     // ===== Execute loop and update progress =====
-    int waitSeconds = 5;
-    std::string inputTime;
-    std::cout << "Please enter the start time (HH MM, e.g. 16 45), or press Enter to start after 5 seconds: ";
-    std::getline(std::cin, inputTime);
-    int targetHour = -1, targetMin = -1;
-    bool validTime = false;
-    if (!inputTime.empty())
-    {
-        std::istringstream iss(inputTime);
-        if (iss >> targetHour >> targetMin)
+    if (options.interactive && options.startHour < 0)
+    {
+        std::string inputTime;
+        std::cout << "Please enter the start time (HH MM, e.g. 16 45), or press Enter to start after "
+                  << options.countdownSeconds << " seconds: ";
+        std::getline(std::cin, inputTime);
+        if (inputTime.empty() || !parseStartTime(inputTime, options.startHour, options.startMinute))
         {
-            if (targetHour >= 0 && targetHour < 24 && targetMin >= 0 && targetMin < 60)
-            {
-                validTime = true;
-            }
+            std::cout << "Press Enter to start countdown...";
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         }
     }
-    if (validTime)
+    if (options.startHour >= 0)
     {
+        int targetHour = options.startHour, targetMin = options.startMinute;
         std::cout << "Waiting until " << (targetHour < 10 ? "0" : "") << targetHour << ":" << (targetMin < 10 ? "0" : "") << targetMin << " to start..." << std::endl;
-        while (true)
+        while (runToken.waitFor(std::chrono::seconds(1)))
         {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
             auto now = std::chrono::system_clock::now();
             std::time_t now_c = std::chrono::system_clock::to_time_t(now);
             struct tm local_tm;
@@ -216,160 +364,472 @@ void System::startAutoclickScript()
         }
         std::cout << "Time reached. Starting now!" << std::endl;
     }
-    else
+    else if (options.countdownSeconds > 0)
     {
-        std::cout << "Press Enter to start countdown...";
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        countdown(waitSeconds);
+        countdown(options.countdownSeconds);
+    }
+    // Live file indexes for Number_of_Files_Check, kept current by change notifications
+    std::unique_ptr<DirectoryIndex> index1, index2;
+    if (config.get("Number_of_Files_Check") == "ENABLE")
+    {
+        index1 = std::make_unique<DirectoryIndex>(path1);
+        index2 = std::make_unique<DirectoryIndex>(path2);
+        index1->watch(reactor);
+        index2->watch(reactor);
+    }
+
+    // Content-level consistency of the configured directory groups
+    std::unique_ptr<ConsistencyChecker> consistency = createConsistencyChecker(path1, path2);
+
+    // Post-round verification runs on a worker and overlaps with the next rounds
+    std::unique_ptr<RoundVerifier> verifier;
+    if ((index1 && index2) || consistency)
+    {
+        RoundVerifier::Barrier barrier = RoundVerifier::parseBarrier(config.get("Verify_Barrier", "LAG"));
+        int lag = 2;
+        size_t queueSize = 4;
+        try
+        {
+            lag = std::stoi(config.get("Verify_Lag", "2"));
+            queueSize = std::stoul(config.get("Verify_Queue_Size", "4"));
+        }
+        catch (const std::exception &)
+        {
+            MYLOG_WARNING("Invalid Verify_Lag / Verify_Queue_Size, using 2 / 4.");
+        }
+        verifier = std::make_unique<RoundVerifier>(
+            [&](int round)
+            {
+                bool found = false;
+                if (index1 && index2)
+                {
+                    found |= reconcileFileCounts(*index1, *index2, "Path1", "Path2", round);
+                    found |= reconcileFileCounts(*index2, *index1, "Path2", "Path1", round);
+                }
+                if (consistency)
+                {
+                    found |= checkConsistency(*consistency, round);
+                }
+                return found;
+            },
+            queueSize, barrier, lag);
+        MYLOG_INFO("Post-round verification: barrier {}, lag {}, queue {}", RoundVerifier::barrierName(barrier), lag,
+                   queueSize);
+    }
+
+    // Timeline of the rounds, actions and background work for Perfetto
+    std::string traceFile = config.get("Trace_File");
+    if (!traceFile.empty())
+    {
+        Tracer::setThreadName("engine");
+        Tracer::getInstance().start();
+        MYLOG_INFO("Tracing to {}", traceFile);
     }
+
     bool completedNormally = true;
+    if (!runToken.stopRequested())
+    {
+        reactor.setRunState(ThreadManager::RunState::RUNNING);
+    }
+    platform::beginHighResolutionTimer();
+    auto *recorder = dynamic_cast<RecordingInputBackend *>(inputBackend.get());
+    ClickScript.resetExecutedActions();
+    auto runStart = std::chrono::steady_clock::now();
+    progress.begin(loops, &ClickScript.executedActionsCounter(), std::chrono::milliseconds(progressIntervalMs));
 
     for (int i = 0; i < loops; i++, ClickScript.setCurrentLoop(i))
     {
         // ===== Check emergency stop flag =====
-        if (g_emergencyStop.load())
+        if (runToken.stopRequested())
         {
+            runToken.acknowledgeStop();
             std::cout << "\n!!! EMERGENCY STOP TRIGGERED !!!" << std::endl;
             std::cout << "ClickScript procedure stopped by user (ESC key)!" << std::endl;
-            MyLogger::getInstance().warning("ClickScript procedure emergency stopped at round " + std::to_string(i + 1));
-
-            // Set progress bar to error state (red)
-            if (taskbarInitialized)
-            {
-                setTaskbarProgressState(TBPF_ERROR);
-            }
+            MYLOG_WARNING("ClickScript procedure emergency stopped at round {}", i + 1);
 
             completedNormally = false;
             break;
         }
 
-        // Check normal interrupt flag
-        if (!g_isRunning.load())
+        if (verifier)
         {
-            std::cout << "ClickScript procedure interrupted!" << std::endl;
-            MyLogger::getInstance().info("ClickScript procedure interrupted at round " + std::to_string(i + 1));
-
-            if (taskbarInitialized)
-            {
-                setTaskbarProgressState(TBPF_PAUSED);
-            }
-
-            completedNormally = false;
-            break;
+            verifier->beforeRound(i + 1);
         }
 
-        std::cout << "=== Executing ClickScript round " << (i + 1) << " of " << loops << " ===" << std::endl;
-        std::cout << "Press ESC to emergency stop..." << std::endl;
-
-        MyLogger::getInstance().debug("=== Executing ClickScript round " + std::to_string(i + 1) + " of " + std::to_string(loops) + " ===");
-
-        // Update progress
-        g_currentProgress.store(i + 1);
-        if (taskbarInitialized)
-        {
-            updateTaskbarProgress(i + 1, loops);
-        }
+        MYLOG_DEBUG("=== Executing ClickScript round {} of {} ===", i + 1, loops);
 
         // Execute click script (this may take a long time, should support emergency stop inside)
-        if (!g_emergencyStop.load() && g_isRunning.load())
+        if (!runToken.stopRequested())
         {
+            if (recorder)
+            {
+                recorder->resetSubmissions();
+            }
             ClickScript.execute();
+            if (recorder)
+            {
+                MYLOG_DEBUG("Round {} made {} input submissions", i + 1, recorder->submissions());
+            }
+            if (ClickScript.streamFailed())
+            {
+                std::cerr << "Streaming " << options.script << " failed in round " << i + 1 << ":" << std::endl;
+                for (const ScriptError &error : ClickScript.getErrors())
+                    std::cerr << "  " << error.toString(options.script) << std::endl;
+                MYLOG_ERROR("Streaming failed in round {}, run aborted", i + 1);
+                completedNormally = false;
+                break;
+            }
+            if (ClickScript.runAborted())
+            {
+                std::cerr << "Run stopped: " << ClickScript.getAbortReason() << std::endl;
+                completedNormally = false;
+                break;
+            }
         }
         else
         {
             break; // Emergency stop check
         }
 
-        if (config.get("Number_of_Files_Check") == "ENABLE")
+        // A round cut short by a stop is not counted
+        if (!runToken.stopRequested())
         {
-            while (ClickScript.count_FilesInPath(path1) > ClickScript.count_FilesInPath(path2))
-            {
-                std::cout << "---" << std::endl;
-                std::cout << "Warning: Path1 has more files than Path2." << std::endl;
-                std::cout << "Execute auto-delete." << std::endl;
-                ClickScript.deleteLatestFileInPath(path1);
-            }
-            while (ClickScript.count_FilesInPath(path1) < ClickScript.count_FilesInPath(path2))
+            if (verifier)
             {
-                std::cout << "---" << std::endl;
-                std::cout << "Warning: Path2 has more files than Path1." << std::endl;
-                std::cout << "Execute auto-delete." << std::endl;
-                ClickScript.deleteLatestFileInPath(path2);
+                verifier->submit(i + 1);
             }
+            progress.roundFinished(i + 1);
+            reactor.setProgress(i + 1, loops);
         }
     }
-    // ===== Completion handling =====
-    if (completedNormally && g_isRunning.load() && !g_emergencyStop.load())
+    platform::endHighResolutionTimer();
+    ClickScript.restoreClipboard();
+    if (verifier)
     {
-        std::cout << "\n=== ALL ROUNDS COMPLETED SUCCESSFULLY! ===" << std::endl;
-        MyLogger::getInstance().info("All rounds completed successfully!");
+        verifier->finish();
+        double waitedMs = std::chrono::duration<double, std::milli>(verifier->barrierWait()).count();
+        std::cout << "Verified " << verifier->verifiedRounds() << " rounds, " << verifier->discrepancies()
+                  << " with discrepancies, round loop waited " << std::fixed << std::setprecision(1) << waitedMs
+                  << " ms for verification." << std::endl;
+        MYLOG_INFO("Verified {} rounds, {} with discrepancies, waited {} ms", verifier->verifiedRounds(),
+                   verifier->discrepancies(), waitedMs);
+    }
+    if (runToken.stopRequested())
+    {
+        completedNormally = false;
+    }
+    reactor.endRun(completedNormally ? ThreadManager::RunState::FINISHED : ThreadManager::RunState::STOPPED);
+    progress.finish(completedNormally);
 
-        // Set progress bar to completed state (green, 100%)
-        if (taskbarInitialized)
-        {
-            setTaskbarProgressState(TBPF_NORMAL);
-            updateTaskbarProgress(loops, loops);
+    if (runToken.hasStopLatency())
+    {
+        double latencyMs = std::chrono::duration<double, std::milli>(runToken.stopLatency()).count();
+        std::cout << "Emergency stop took effect after " << std::fixed << std::setprecision(3) << latencyMs
+                  << " ms." << std::endl;
+        MYLOG_INFO("Emergency stop latency: {} ms", latencyMs);
+    }
+
+    // ===== Engine throughput =====
+    double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    uint64_t executedActions = ClickScript.getExecutedActions();
+    std::ostringstream throughput;
+    throughput << "Executed " << executedActions << " actions in " << std::fixed << std::setprecision(3)
+               << runSeconds << " s (" << std::setprecision(0)
+               << (runSeconds > 0 ? executedActions / runSeconds : 0.0) << " actions/sec)";
+    std::cout << throughput.str() << std::endl;
+    MYLOG_INFO("{}", throughput.str());
+
+    std::ostringstream jitter;
+    ClickScript.getScheduler().report(jitter);
+    std::cout << jitter.str();
+    MYLOG_INFO("\n{}", jitter.str());
+
+    // ===== Where the round time went =====
+    std::ostringstream timing;
+    ClickScript.reportTimings(timing);
+    std::cout << timing.str();
+    MYLOG_INFO("\n{}", timing.str());
+    std::string timingFile = config.get("Timing_Report_File", "timing_report.json");
+    if (!timingFile.empty() && ClickScript.writeTimingReport(timingFile, loops))
+    {
+        MYLOG_INFO("Timing report written to {}", timingFile);
+    }
 
-            // Keep completed state visible for 3 seconds
-            std::cout << "Keeping progress bar visible for 3 seconds..." << std::endl;
-            Sleep(3000);
+    if (!traceFile.empty())
+    {
+        Tracer &tracer = Tracer::getInstance();
+        tracer.stop();
+        if (tracer.write(traceFile))
+        {
+            std::cout << "Trace with " << tracer.eventCount() << " events written to " << traceFile
+                      << " (open in https://ui.perfetto.dev)." << std::endl;
+            MYLOG_INFO("Trace: {} events, {} dropped, written to {}", tracer.eventCount(), tracer.droppedEvents(),
+                       traceFile);
         }
     }
-    else if (g_emergencyStop.load())
+
+    std::string recordFile = config.get("Input_Record_File");
+    if (recorder && !recordFile.empty() && recorder->save(recordFile))
+    {
+        MYLOG_INFO("Recorded {} input events in {} submissions to {}", recorder->events().size(),
+                   recorder->totalSubmissions(), recordFile);
+    }
+
+    // ===== Completion handling =====
+    if (completedNormally)
+    {
+        std::cout << "\n=== ALL ROUNDS COMPLETED SUCCESSFULLY! ===" << std::endl;
+        MYLOG_INFO("All rounds completed successfully!");
+    }
+    else if (ClickScript.runAborted())
+    {
+        std::cout << "\n=== PROCEDURE STOPPED BY A FAILED WAIT ===" << std::endl;
+        MYLOG_ERROR("Procedure stopped: {}", ClickScript.getAbortReason());
+    }
+    else if (!runToken.stopRequested())
+    {
+        std::cout << "\n=== PROCEDURE ABORTED BY A SCRIPT ERROR ===" << std::endl;
+        MYLOG_ERROR("Procedure aborted by a script error");
+    }
+    else
     {
         std::cout << "\n=== PROCEDURE TERMINATED BY EMERGENCY STOP ===" << std::endl;
-        MyLogger::getInstance().warning("Procedure terminated by emergency stop");
+        MYLOG_WARNING("Procedure terminated by emergency stop");
+    }
+
+    // Keep the final taskbar state (green / red) visible for 3 seconds
+    if (options.interactive && progress.showsFinalState())
+    {
+        std::cout << "Keeping progress bar visible for 3 seconds..." << std::endl;
+        platform::sleepMs(3000);
+    }
+
+    // ===== Cleanup progress sinks =====
+    progress.close();
+    platform::setConsoleTitle("ClickScript - Ready");
+
+    // Join the reactor, no thread outlives the run
+    reactor.stop();
+    reactor.setRunState(ThreadManager::RunState::IDLE);
 
-        // Keep error state visible for 3 seconds
-        if (taskbarInitialized)
+    std::cout << "ClickScript procedure completed." << std::endl;
+    MYLOG_INFO("ClickScript procedure completed.");
+    MyLogger::getInstance().splitLine();
+
+    MYLOG_DEBUG("Resources cleaned up.");
+    MYLOG_INFO("Autoclick script completed.");
+    MyLogger::getInstance().flush();
+    return completedNormally;
+}
+
+bool System::reconcileFileCounts(DirectoryIndex &larger, DirectoryIndex &smaller, const char *largerName,
+                                 const char *smallerName, int round)
+{
+    TraceSpan span("verify", "reconcile file counts", "round", round);
+    bool found = false;
+    while (larger.count() > smaller.count())
+    {
+        found = true;
+        std::cout << "--- [round " << round << "]" << std::endl;
+        std::cout << "Warning: " << largerName << " has more files than " << smallerName << "." << std::endl;
+        std::cout << "Execute auto-delete." << std::endl;
+        std::string deleted;
+        if (!larger.deleteNewest(&deleted))
         {
-            std::cout << "Emergency stop indication on taskbar for 3 seconds..." << std::endl;
-            Sleep(3000);
+            std::cerr << "Failed to delete latest file in path: " << larger.path() << std::endl;
+            break;
         }
+        std::cout << "Deleted latest file: " << deleted << std::endl;
+        MYLOG_INFO("[round {}] Deleted latest file: {}", round, deleted);
+    }
+    return found;
+}
+
+void System::runPreflightSimulation(ClickScript &script, int loops)
+{
+    std::string timelineFile = config.get("Simulation_Timeline_File");
+    std::shared_ptr<RecordingInputBackend> timeline;
+    if (!timelineFile.empty())
+    {
+        timeline = std::make_shared<RecordingInputBackend>();
     }
 
-    // ===== Cleanup progress bar =====
-    if (taskbarInitialized)
+    ClickScript::SimulationReport report = script.simulate(loops, timeline);
+
+    auto seconds = [](std::chrono::nanoseconds ns)
+    { return std::chrono::duration<double>(ns).count(); };
+    double total = seconds(report.total);
+    long long whole = static_cast<long long>(total);
+    std::cout << "=== Simulation (virtual clock) ===" << std::endl;
+    if (!report.valid)
     {
-        setTaskbarProgressState(TBPF_NOPROGRESS);
+        std::cout << "Warning: the script has " << script.getErrors().size()
+                  << " errors or compiled to nothing, the prediction is unreliable." << std::endl;
     }
-    SetConsoleTitle("ClickScript - Ready");
+    std::cout << "Rounds: " << report.rounds << ", actions: " << report.actions;
+    if (timeline)
+    {
+        std::cout << ", input events: " << report.events;
+    }
+    std::cout << std::endl;
+    std::cout << "Predicted duration: " << std::setfill('0') << std::setw(2) << whole / 3600 << ":"
+              << std::setw(2) << whole / 60 % 60 << ":" << std::setw(2) << whole % 60 << std::setfill(' ')
+              << std::fixed << std::setprecision(3) << " (" << total << " s)" << std::endl;
+    std::cout << "Per round: min " << seconds(report.minRound) << " s, avg "
+              << (report.rounds > 0 ? total / report.rounds : 0.0) << " s, max " << seconds(report.maxRound)
+              << " s" << std::endl;
+    std::cout << "Simulated in " << report.wallSeconds * 1000 << " ms" << std::endl;
+    MYLOG_INFO("Simulation: {} rounds, {} actions, predicted {} s, simulated in {} s", report.rounds, report.actions,
+               total, report.wallSeconds);
+
+    if (timeline && timeline->save(timelineFile))
+    {
+        std::cout << "Event timeline written to " << timelineFile << std::endl;
+    }
+}
 
-    // Stop all running flags
-    g_isRunning.store(false);
-    g_emergencyStop.store(true); // Notify emergency stop thread to exit
+std::unique_ptr<ConsistencyChecker> System::createConsistencyChecker(const std::string &path1,
+                                                                    const std::string &path2)
+{
+    ConsistencyChecker::Level level;
+    std::string levelName = config.get("Consistency_Check", "OFF");
+    if (!ConsistencyChecker::parseLevel(levelName, level))
+    {
+        if (levelName != "OFF")
+            MYLOG_WARNING("Unknown Consistency_Check '{}', consistency check disabled.", levelName);
+        return nullptr;
+    }
 
-    // Give emergency stop thread some time to exit naturally
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int threads = 0;
+    try
+    {
+        threads = std::stoi(config.get("Consistency_Threads", "0"));
+    }
+    catch (const std::exception &)
+    {
+        MYLOG_WARNING("Invalid Consistency_Threads, using one per core.");
+    }
 
-    // Cleanup COM interface
-    if (taskbarInitialized)
+    // Consistency_Group_1, Consistency_Group_2, ... each "dirA;dirB[;dirC...]"
+    auto checker = std::make_unique<ConsistencyChecker>(level, threads);
+    for (int n = 1;; ++n)
     {
-        cleanupTaskbarProgress();
+        std::string key = "Consistency_Group_" + std::to_string(n);
+        std::string directories = config.get(key);
+        if (directories.empty())
+            break;
+        checker->addGroup(key, directories);
     }
+    if (checker->groups().empty() && !path1.empty() && !path2.empty())
+    {
+        checker->addGroup("PATH_1/PATH_2", path1 + ";" + path2);
+    }
+    if (checker->groups().empty())
+    {
+        MYLOG_WARNING("Consistency_Check is {} but no directory group is configured.", levelName);
+        return nullptr;
+    }
+    MYLOG_INFO("Consistency check {} on {} directory groups", levelName, checker->groups().size());
+    return checker;
+}
 
-    std::cout << "ClickScript procedure completed." << std::endl;
-    MyLogger::getInstance().info("ClickScript procedure completed.");
-    MyLogger::getInstance().splitLine();
+bool System::checkConsistency(ConsistencyChecker &checker, int round)
+{
+    TraceSpan span("verify", "consistency check", "round", round);
+    bool found = false;
+    for (size_t g = 0; g < checker.groups().size(); ++g)
+    {
+        ConsistencyChecker::Report report = checker.check(g);
+        const std::string &group = checker.groups()[g].name;
+        for (const auto &mismatch : report.appeared)
+        {
+            std::cout << "--- [round " << round << "] " << group << ": " << mismatch.relative << " "
+                      << mismatch.detail << std::endl;
+            MYLOG_WARNING("[round {}] {}: {} {}", round, group, mismatch.relative, mismatch.detail);
+        }
+        if (report.resolved > 0)
+        {
+            MYLOG_INFO("[round {}] {}: {} mismatches resolved", round, group, report.resolved);
+        }
+        MYLOG_DEBUG("[round {}] {}: {} mismatches, {} bytes hashed", round, group, report.total,
+                    report.bytesHashed);
+        found |= !report.appeared.empty();
+    }
+    return found;
+}
+
+bool System::precompileScripts(const std::string &directory, int threads)
+{
+    namespace fs = std::filesystem;
+
+    MyLogger::getInstance().setLogFile("precompile.log");
+    MYLOG_INFO("Precompiling scripts in {}", directory);
+
+    std::vector<std::string> scripts;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (it->is_regular_file() && it->path().extension() == ".clk")
+        {
+            scripts.push_back(it->path().string());
+        }
+    }
+    if (ec)
+    {
+        std::cerr << "Failed to scan " << directory << ": " << ec.message() << std::endl;
+        return false;
+    }
 
-    // Reset console window handle
-    g_consoleWindow = nullptr;
-    // Reset taskbar list interface
-    if (g_pTaskbarList)
+    if (threads <= 0)
     {
-        g_pTaskbarList->Release();
-        g_pTaskbarList = nullptr;
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
     }
-    // Uninitialize COM
-    CoUninitialize();
-    MyLogger::getInstance().debug("Resources cleaned up.");
-    MyLogger::getInstance().info("Autoclick script completed.");
+    threads = std::min<int>(threads, static_cast<int>(std::max<size_t>(scripts.size(), 1)));
+
+    // Workers take the next script index until all are done
+    std::atomic<size_t> next{0};
+    std::atomic<int> failed{0};
+    auto worker = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < scripts.size(); i = next.fetch_add(1))
+        {
+            ClickScript script;
+            script.load_ClickScript_fromfile(scripts[i]);
+            if (!script.getErrors().empty())
+            {
+                ++failed;
+                MYLOG_ERROR("Failed to precompile {}: {} errors", scripts[i], script.getErrors().size());
+            }
+            else if (!fs::exists(ProgramCache::cachePathFor(scripts[i])))
+            {
+                ++failed;
+                MYLOG_ERROR("Failed to precompile {}", scripts[i]);
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    for (auto &thread : pool)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Precompiled " << scripts.size() - failed.load() << " of " << scripts.size() << " scripts in "
+              << std::fixed << std::setprecision(3) << seconds << " s using " << threads << " threads." << std::endl;
+    MYLOG_INFO("Precompiled {} of {} scripts", scripts.size() - failed.load(), scripts.size());
+    MyLogger::getInstance().flush();
+    return failed.load() == 0;
 }
 
 void System::printMainMenu()
 {
-    system("cls");
+    platform::clearScreen();
     printSplitLine();
     std::cout << "Main Menu" << std::endl;
     printSplitLine();
@@ -389,7 +849,7 @@ void System::printSplitLine()
 
 void System::temporaryTask()
 {
-    system("cls");
+    platform::clearScreen();
     std::cout << "Debug Only" << std::endl;
     std::cout << "No temporary task implemented." << std::endl;
 }
@@ -399,7 +859,11 @@ void System::countdown(int seconds)
     for (int i = seconds; i > 0; --i)
     {
         std::cout << "Countdown: " << i << " seconds remaining..." << std::endl;
-        Sleep(1000);
+        if (!runToken.waitFor(std::chrono::seconds(1)))
+        {
+            std::cout << "Countdown interrupted!" << std::endl;
+            return;
+        }
     }
     std::cout << "Countdown finished!" << std::endl;
 }
@@ -416,10 +880,10 @@ void System::measureMousePosition()
         {
             break;
         }
-        POINT p;
-        if (GetCursorPos(&p))
+        int x, y;
+        if (platform::getCursorPosition(x, y))
         {
-            std::cout << "Current Mouse Position: (" << p.x << ", " << p.y << ")" << std::endl;
+            std::cout << "Current Mouse Position: (" << x << ", " << y << ")" << std::endl;
         }
         else
         {
@@ -428,116 +892,6 @@ void System::measureMousePosition()
     }
 }
 
-// Initialize COM and taskbar interface
-bool System::initializeTaskbarProgress()
-{
-    HRESULT hr = CoInitialize(nullptr);
-    if (FAILED(hr))
-    {
-        std::cerr << "Failed to initialize COM" << std::endl;
-        return false;
-    }
-
-    hr = CoCreateInstance(CLSID_TaskbarList, nullptr, CLSCTX_INPROC_SERVER,
-                          IID_ITaskbarList3, (void **)&g_pTaskbarList);
-    if (FAILED(hr))
-    {
-        std::cerr << "Failed to create taskbar list interface" << std::endl;
-        CoUninitialize();
-        return false;
-    }
-
-    hr = g_pTaskbarList->HrInit();
-    if (FAILED(hr))
-    {
-        std::cerr << "Failed to initialize taskbar list" << std::endl;
-        g_pTaskbarList->Release();
-        g_pTaskbarList = nullptr;
-        CoUninitialize();
-        return false;
-    }
-
-    return true;
-}
-
-// Update taskbar progress
-void System::updateTaskbarProgress(int current, int total)
-{
-    if (g_pTaskbarList && g_consoleWindow)
-    {
-        if (current == 0)
-        {
-            // Set progress state to normal
-            g_pTaskbarList->SetProgressState(g_consoleWindow, TBPF_NORMAL);
-        }
-
-        // Update progress value
-        g_pTaskbarList->SetProgressValue(g_consoleWindow, current, total);
-
-        // Update window title with progress
-        char title[256];
-        sprintf_s(title, sizeof(title),
-                  "ClickScript - Progress: %d/%d (%.1f%%)",
-                  current, total, (float)current / total * 100);
-        SetConsoleTitle(title);
-    }
-}
-
-// Set taskbar progress state
-void System::setTaskbarProgressState(TBPFLAG state)
-{
-    if (g_pTaskbarList && g_consoleWindow)
-    {
-        g_pTaskbarList->SetProgressState(g_consoleWindow, state);
-    }
-}
-
-// Cleanup taskbar progress
-void System::cleanupTaskbarProgress()
-{
-    if (g_pTaskbarList)
-    {
-        if (g_consoleWindow)
-        {
-            g_pTaskbarList->SetProgressState(g_consoleWindow, TBPF_NOPROGRESS);
-        }
-        g_pTaskbarList->Release();
-        g_pTaskbarList = nullptr;
-    }
-    CoUninitialize();
-}
-void System::escapeKeyListener()
-{
-    while (!g_emergencyStop.load())
-    {
-        // Check if ESC key is pressed
-        if (GetAsyncKeyState(VK_ESCAPE) & 0x8000)
-        {
-            std::cout << "\n=== EMERGENCY STOP ACTIVATED ===\n"
-                      << std::endl;
-            std::cout << "ESC key detected! Stopping all operations..." << std::endl;
-
-            MyLogger::getInstance().info("Emergency stop activated by ESC key.");
-
-            // Set emergency stop flag
-            g_emergencyStop.store(true);
-
-            // Also set system running flag to false
-            g_isRunning.store(false);
-
-            // Play system warning sound
-            MessageBeep(MB_ICONWARNING);
-
-            break;
-        }
-
-        // Short sleep to reduce CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-
-    std::cout << "Emergency stop monitor thread terminated." << std::endl;
-}
-
 void System::configInit()
 {
     if (config.load())
@@ -0,0 +1,83 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+// C++ standard library headers
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Minimal harness shared by the test_* executables, run by ctest. CHECK logs a
+// failed condition and carries on, finish() turns the failures into the exit code.
+namespace test
+{
+    inline int &failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(bool condition, const char *expression, const char *file, int line)
+    {
+        if (!condition)
+        {
+            std::cerr << file << ":" << line << ": CHECK failed: " << expression << std::endl;
+            ++failures();
+        }
+        return condition;
+    }
+
+    // Compare two texts, printing both on a mismatch
+    inline bool checkText(const std::string &actual, const std::string &expected, const char *file, int line)
+    {
+        if (actual == expected)
+            return true;
+        std::cerr << file << ":" << line << ": text differs\n--- expected\n"
+                  << expected << "--- actual\n"
+                  << actual << "---" << std::endl;
+        ++failures();
+        return false;
+    }
+
+    inline int finish(const char *name)
+    {
+        if (failures() == 0)
+            std::cerr << name << ": all checks passed" << std::endl;
+        else
+            std::cerr << name << ": " << failures() << " check(s) failed" << std::endl;
+        return failures() == 0 ? 0 : 1;
+    }
+
+    // Write a script file with the given command lines between #start and #end
+    inline void writeScript(const std::filesystem::path &file, const std::string &lines)
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out << "#start\n" << lines << "#end\n";
+    }
+
+    // Scratch directory under the system temp directory, removed again on destruction
+    class ScratchDirectory
+    {
+    public:
+        explicit ScratchDirectory(const std::string &name)
+            : path(std::filesystem::temp_directory_path() / ("clickscript_test_" + name))
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+            std::filesystem::create_directories(path);
+        }
+        ~ScratchDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+
+        const std::filesystem::path path;
+    };
+}
+
+#define CHECK(condition) test::check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_TEXT(actual, expected) test::checkText((actual), (expected), __FILE__, __LINE__)
+
+#endif // TEST_HARNESS_H
@@ -0,0 +1,69 @@
+// Compiled .clkc cache: written for clean scripts and used on the next load,
+// never written for a script with errors, which must report them on every load,
+// and stale when the script changed after it was read.
+
+#include "MyLogger.h"
+#include "ProgramCache.h"
+#include "TestHarness.h"
+#include "clickscript.h"
+
+int main()
+{
+    test::ScratchDirectory scratch("cache");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+
+    // Clean script: the first load writes the cache, the second one reads it back
+    std::filesystem::path good = scratch.path / "good.clk";
+    test::writeScript(good, "LEFT 1 2\nDELAY 5\nENTER\n");
+    const std::string goodCache = ProgramCache::cachePathFor(good.string());
+    {
+        ClickScript script;
+        script.load_ClickScript_fromfile(good.string());
+        CHECK(script.getErrors().empty());
+        CHECK(std::filesystem::exists(goodCache));
+        Program cached;
+        CHECK(ProgramCache::load(good.string(), cached) && cached.size() == script.getProgram().size());
+    }
+
+    // Script with an unknown command: no cache, and the errors come back on the second load
+    std::filesystem::path bad = scratch.path / "bad.clk";
+    test::writeScript(bad, "LEFT 1 2\nBOGUS 1\n");
+    for (int load = 0; load < 2; ++load)
+    {
+        ClickScript script;
+        script.load_ClickScript_fromfile(bad.string());
+        CHECK(script.getErrors().size() == 1);
+        CHECK(!std::filesystem::exists(ProgramCache::cachePathFor(bad.string())));
+    }
+
+    // Breaking a cached script makes the old cache stale, the errors are reported
+    test::writeScript(good, "LEFT 1 2\nDELAY\n");
+    {
+        ClickScript script;
+        script.load_ClickScript_fromfile(good.string());
+        CHECK(script.getErrors().size() == 1);
+        Program cached;
+        CHECK(!ProgramCache::load(good.string(), cached));
+    }
+
+    // An edit between reading a script and saving its cache: the cache carries the stamp
+    // from before the read, so the edited script does not get the old program
+    std::filesystem::path edited = scratch.path / "edited.clk";
+    test::writeScript(edited, "LEFT 1 2\n");
+    {
+        ProgramCache::SourceStamp before;
+        CHECK(ProgramCache::stamp(edited.string(), before));
+        std::string source = "#start\nLEFT 1 2\n#end\n";
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.load_ClickScript_fromfile(edited.string());
+
+        test::writeScript(edited, "LEFT 3 4\n"); // Same size, new content
+        std::filesystem::last_write_time(edited, std::filesystem::last_write_time(edited) + std::chrono::seconds(2));
+        CHECK(ProgramCache::save(edited.string(), before, source, script.getProgram()));
+        Program cached;
+        CHECK(!ProgramCache::load(edited.string(), cached));
+    }
+    return test::finish("test_cache");
+}
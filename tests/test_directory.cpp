@@ -0,0 +1,85 @@
+// DirectoryIndex on the reactor: notifications keep the count current, a watch
+// that fails on the reactor thread leaves the reactor before its handle is closed,
+// so a later index that gets the same handle number keeps its notifications.
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "DirectoryIndex.h"
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "ThreadManager.h"
+
+namespace
+{
+    // Poll until condition holds, false after two seconds
+    template <typename Condition>
+    bool eventually(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void touch(const std::filesystem::path &file)
+    {
+        std::ofstream out(file);
+        out << "x";
+    }
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("directory");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+    ThreadManager &reactor = ThreadManager::getInstance();
+    CHECK(reactor.start());
+
+    std::filesystem::path first = scratch.path / "first";
+    std::filesystem::path second = scratch.path / "second";
+    std::filesystem::create_directories(first);
+    std::filesystem::create_directories(second);
+
+    auto index = std::make_unique<DirectoryIndex>(first.string());
+    std::atomic<int> firstChanges{0};
+    index->onChange([&]
+                    { ++firstChanges; });
+    index->watch(reactor);
+    CHECK(index->isWatching());
+    touch(first / "a.txt");
+    CHECK(eventually([&]
+                     { return firstChanges.load() > 0; }));
+    CHECK(index->count() == 1);
+
+    // Removing the directory fails the watch from the reactor callback
+    std::filesystem::remove_all(first);
+    CHECK(eventually([&]
+                     { return !index->isWatching(); }));
+    CHECK(index->count() == 0);
+
+    // The next watch most likely reuses the closed handle number
+    DirectoryIndex other(second.string());
+    std::atomic<int> secondChanges{0};
+    other.onChange([&]
+                   { ++secondChanges; });
+    other.watch(reactor);
+    CHECK(other.isWatching());
+
+    // Destroying the failed index must not take the new watch out of the reactor
+    index.reset();
+    touch(second / "b.txt");
+    CHECK(eventually([&]
+                     { return secondChanges.load() > 0; }));
+    CHECK(other.count() == 1);
+
+    reactor.stop();
+    return test::finish("test_directory");
+}
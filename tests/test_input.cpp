@@ -0,0 +1,83 @@
+// RECORDING input backend: the exact event stream of a short script, how it is
+// split into submissions, and the text format written by RecordingInputBackend.
+
+#include <memory>
+#include <vector>
+
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "clickscript.h"
+
+int main()
+{
+    test::ScratchDirectory scratch("input");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_WARNING);
+
+    std::filesystem::path file = scratch.path / "input.clk";
+    test::writeScript(file, "LEFT 10 20\n"
+                            "RIGHT 30 40\n"
+                            "ENTER\n"
+                            "DELAY 20\n"
+                            "LEFT 5 6\n"
+                            "LOOP_NUMBER_KEY\n");
+
+    ClickScript script;
+    script.setCacheEnabled(false);
+    script.setTimingEnabled(false);
+    script.load_ClickScript_fromfile(file.string());
+    CHECK(script.getErrors().empty());
+    auto recording = std::make_shared<RecordingInputBackend>();
+    script.setInputBackend(recording);
+    script.setCurrentLoop(12);
+    script.execute();
+
+    // Clicks carry their absolute position on every event, the loop number is typed as digits
+    std::ostringstream events;
+    recording->write(events, false);
+    CHECK_TEXT(events.str(), "MOVE 10 20\n"
+                             "DOWN LEFT 10 20\n"
+                             "UP LEFT 10 20\n"
+                             "MOVE 30 40\n"
+                             "DOWN RIGHT 30 40\n"
+                             "UP RIGHT 30 40\n"
+                             "KEY_DOWN 13\n"
+                             "KEY_UP 13\n"
+                             "MOVE 5 6\n"
+                             "DOWN LEFT 5 6\n"
+                             "UP LEFT 5 6\n"
+                             "KEY_DOWN 49\n"
+                             "KEY_UP 49\n"
+                             "KEY_DOWN 50\n"
+                             "KEY_UP 50\n");
+
+    // Input before the DELAY goes out in one submission, the rest at the end of the round
+    std::vector<uint64_t> submissions;
+    for (const auto &record : recording->events())
+        submissions.push_back(record.submission);
+    CHECK(submissions == std::vector<uint64_t>({0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1}));
+    CHECK(recording->totalSubmissions() == 2);
+
+    // Events of one submission share a timestamp, the second comes after the DELAY. Its
+    // deadline counts from the round start, so the first submission's own time comes off.
+    const auto &recorded = recording->events();
+    CHECK(recorded.size() == 15 && recorded[0].timestampNs == recorded[7].timestampNs);
+    CHECK(recorded.size() == 15 && recorded[8].timestampNs - recorded[0].timestampNs >= 10000000);
+
+    // A second round is recorded after the first, with the round number typed
+    script.setCurrentLoop(3);
+    script.execute();
+    CHECK(recording->events().size() == 28 && recording->events().back().event.key == '3');
+    CHECK(recording->totalSubmissions() == 4);
+
+    // The timestamped format prefixes every line with the time and the submission index
+    std::ostringstream stamped;
+    recording->write(stamped, true);
+    std::string firstLine = stamped.str().substr(0, stamped.str().find('\n'));
+    CHECK(firstLine == std::to_string(recorded[0].timestampNs) + " 0 MOVE 10 20");
+
+    recording->clear();
+    CHECK(recording->events().empty() && recording->totalSubmissions() == 0);
+    return test::finish("test_input");
+}
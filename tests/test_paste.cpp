@@ -0,0 +1,113 @@
+// PASTE on the MEMORY clipboard: the text is on the clipboard when Ctrl+V goes
+// out, what the clipboard held before is put back, and a DELAY after a paste that
+// had to wait for the previous one to settle still lasts its full length.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ClipboardBackend.h"
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "clickscript.h"
+
+namespace
+{
+    // Records the input and the clipboard text at every submission
+    class SnapshotBackend : public RecordingInputBackend
+    {
+    public:
+        explicit SnapshotBackend(std::shared_ptr<ClipboardBackend> clipboard) : clipboard(std::move(clipboard)) {}
+
+        void submit(const InputEvent *events, size_t count) override
+        {
+            RecordingInputBackend::submit(events, count);
+            std::string text;
+            snapshots.push_back(clipboard->getText(text) ? text : "<empty>");
+        }
+
+        std::vector<std::string> snapshots;
+
+    private:
+        std::shared_ptr<ClipboardBackend> clipboard;
+    };
+
+    int64_t submissionTime(const RecordingInputBackend &recording, uint64_t submission)
+    {
+        for (const auto &record : recording.events())
+        {
+            if (record.submission == submission)
+                return record.timestampNs;
+        }
+        return -1;
+    }
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("paste");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+
+    // Two pastes back to back, the second waits out the settle time of the first
+    std::filesystem::path file = scratch.path / "paste.clk";
+    test::writeScript(file, "PASTE \"hello {loop}\"\n"
+                            "PASTE \"second\"\n"
+                            "DELAY 100\n"
+                            "LEFT 1 1\n");
+    {
+        auto clipboard = std::make_shared<MemoryClipboardBackend>();
+        clipboard->setText("original");
+        auto recording = std::make_shared<SnapshotBackend>(clipboard);
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        CHECK(script.getErrors().empty());
+        script.setInputBackend(recording);
+        script.setClipboard(clipboard);
+        script.setPasteSettleTime(std::chrono::milliseconds(150));
+        script.setCurrentLoop(0); // {loop} is the round number, one more
+        script.execute();
+
+        // Ctrl+V as one submission per paste, the click after the DELAY as the third
+        std::ostringstream events;
+        recording->write(events, false);
+        const std::string ctrlV = "KEY_DOWN 17\nKEY_DOWN 86\nKEY_UP 86\nKEY_UP 17\n";
+        CHECK_TEXT(events.str(), ctrlV + ctrlV + "MOVE 1 1\nDOWN LEFT 1 1\nUP LEFT 1 1\n");
+        CHECK(recording->snapshots == std::vector<std::string>({"hello 1", "second", "second"}));
+
+        // The settle wait does not eat into the DELAY after it. Deadlines are absolute, the
+        // time the first paste took to inject comes off the DELAY, so allow a few ms for it.
+        int64_t first = submissionTime(*recording, 0);
+        int64_t second = submissionTime(*recording, 1);
+        int64_t click = submissionTime(*recording, 2);
+        CHECK(second - first >= 150000000);
+        CHECK(click - second >= 90000000);
+
+        // The second paste is not settled yet at the end of the round, restoring waits for it
+        std::string text;
+        CHECK(clipboard->getText(text) && text == "second");
+        script.restoreClipboard();
+        CHECK(clipboard->getText(text) && text == "original");
+    }
+
+    // A DELAY longer than the settle time restores within the round, an empty clipboard stays empty
+    test::writeScript(file, "PASTE \"payload\"\nDELAY 50\n");
+    {
+        auto clipboard = std::make_shared<MemoryClipboardBackend>();
+        auto recording = std::make_shared<SnapshotBackend>(clipboard);
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.load_ClickScript_fromfile(file.string());
+        script.setInputBackend(recording);
+        script.setClipboard(clipboard);
+        script.setPasteSettleTime(std::chrono::milliseconds(10));
+        script.execute();
+        CHECK(recording->snapshots == std::vector<std::string>({"payload"}));
+        std::string text;
+        CHECK(!clipboard->getText(text));
+        CHECK(clipboard->writes() == 1);
+    }
+    return test::finish("test_paste");
+}
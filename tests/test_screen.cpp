@@ -0,0 +1,126 @@
+// WAIT_PIXEL / WAIT_REGION_CHANGE on a MemoryScreenSource: met and timed out
+// waits, a region off the screen, the timing of a DELAY after a wait, and the
+// SIMD region compare kernels against the scalar one.
+
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "PixelKernels.h"
+#include "ScreenSource.h"
+#include "TestHarness.h"
+#include "clickscript.h"
+
+namespace
+{
+    struct Run
+    {
+        std::shared_ptr<RecordingInputBackend> recording = std::make_shared<RecordingInputBackend>();
+        std::shared_ptr<MemoryScreenSource> screen = std::make_shared<MemoryScreenSource>(64, 48);
+        std::unique_ptr<ClickScript> script = std::make_unique<ClickScript>();
+
+        explicit Run(const std::filesystem::path &file)
+        {
+            script->setCacheEnabled(false);
+            script->load_ClickScript_fromfile(file.string());
+            CHECK(script->getErrors().empty());
+            script->setInputBackend(recording);
+            script->setScreenSource(screen);
+        }
+
+        // Timestamp of the first event at x, -1 if there is none
+        int64_t clickAt(int x) const
+        {
+            for (const auto &record : recording->events())
+            {
+                if (record.event.type == InputEventType::MOUSE_MOVE && record.event.x == x)
+                    return record.timestampNs;
+            }
+            return -1;
+        }
+    };
+
+    constexpr int64_t MS = 1000000;
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("screen");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+    std::filesystem::path file = scratch.path / "screen.clk";
+
+    // Every kernel agrees with the scalar loop, including the tails past the vector width
+    {
+        std::mt19937 random(7);
+        std::vector<uint32_t> a(1037), b(1037);
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            a[i] = random();
+            b[i] = i % 3 ? a[i] ^ (random() & 0x0F0F0F0F) : a[i];
+        }
+        for (size_t count : {size_t(0), size_t(3), size_t(17), a.size()})
+        {
+            for (uint8_t tolerance : {uint8_t(0), uint8_t(8), uint8_t(255)})
+            {
+                size_t expected = pixels::countDifferent(a.data(), b.data(), count, tolerance, pixels::Kernel::SCALAR);
+                for (pixels::Kernel kernel : {pixels::Kernel::SSE2, pixels::Kernel::AVX2})
+                {
+                    if (pixels::supported(kernel))
+                        CHECK(pixels::countDifferent(a.data(), b.data(), count, tolerance, kernel) == expected);
+                }
+            }
+        }
+        CHECK(pixels::countDifferent(a.data(), b.data(), a.size(), 255) == 0);
+    }
+
+    // A pixel painted by another thread ends the wait, the DELAY after it runs in full
+    test::writeScript(file, "LEFT 1 1\nWAIT_PIXEL 10 10 #00FF00 4 5000\nDELAY 100\nLEFT 2 2\n");
+    {
+        Run run(file);
+        std::thread painter([&]
+                            {
+                                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                                run.screen->setPixel(10, 10, 0xFF02FD01); });
+        run.script->execute();
+        painter.join();
+        int64_t gap = run.clickAt(2) - run.clickAt(1);
+        CHECK(gap >= 190 * MS && gap < 2000 * MS);
+        CHECK(!run.script->runAborted());
+    }
+
+    // Timed out region wait with CONTINUE: the DELAY counts from the end of the wait
+    test::writeScript(file, "LEFT 1 1\nWAIT_REGION_CHANGE 0 0 32 32 0 150 CONTINUE\nDELAY 100\nLEFT 2 2\n");
+    {
+        Run run(file);
+        run.script->execute();
+        int64_t gap = run.clickAt(2) - run.clickAt(1);
+        CHECK(gap >= 240 * MS);
+        const auto &stats = run.script->getScheduler().delayStats();
+        CHECK(stats.size() == 1 && stats[0].maxErrorNs < 50 * MS);
+    }
+
+    // A change within the tolerance does not count, SKIP then ends the round
+    test::writeScript(file, "WAIT_REGION_CHANGE 0 0 32 32 16 50 SKIP\nLEFT 2 2\n");
+    {
+        Run run(file);
+        std::thread painter([&]
+                            {
+                                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                                run.screen->fill(0, 0, 32, 32, 0xFF101010); });
+        run.script->execute();
+        painter.join();
+        CHECK(run.recording->events().empty() && !run.script->runAborted());
+    }
+
+    // A region off the screen stops the run
+    test::writeScript(file, "WAIT_PIXEL 100 100 000000 0 50\nLEFT 2 2\n");
+    {
+        Run run(file);
+        run.script->execute();
+        CHECK(run.recording->events().empty() && run.script->runAborted());
+    }
+    return test::finish("test_screen");
+}
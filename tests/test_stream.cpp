@@ -0,0 +1,123 @@
+// Streaming mode: the same input as the loaded program for nested and skipped
+// REPEAT blocks, memory that does not grow with the number of repetitions, and
+// parse errors handed from the parser thread to the executing thread.
+
+#include <memory>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "clickscript.h"
+
+namespace
+{
+    // Event stream of rounds 1..rounds, loaded or streamed
+    std::string record(const std::filesystem::path &file, bool streamed, int rounds)
+    {
+        ClickScript script;
+        script.setCacheEnabled(false);
+        script.setTimingEnabled(false);
+        if (streamed)
+            script.openStream(file.string(), 64);
+        else
+            script.load_ClickScript_fromfile(file.string());
+        auto recording = std::make_shared<RecordingInputBackend>();
+        script.setInputBackend(recording);
+        for (int round = 1; round <= rounds; ++round)
+        {
+            script.setCurrentLoop(round);
+            script.execute();
+            CHECK(!script.streamFailed());
+        }
+        std::ostringstream events;
+        recording->write(events, false);
+        return events.str();
+    }
+
+#ifndef _WIN32
+    long peakKilobytes()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+#endif
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("stream");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+
+    // Nested, skipped and back to back blocks, more actions than the queue holds
+    std::filesystem::path nested = scratch.path / "nested.clk";
+    test::writeScript(nested, "LEFT 1 1\n"
+                              "REPEAT 3\n"
+                              "  RIGHT 2 2\n"
+                              "  REPEAT 40\n"
+                              "    LEFT 3 3\n"
+                              "    LOOP_NUMBER_KEY\n"
+                              "  END\n"
+                              "  REPEAT 0\n"
+                              "    LEFT 9 9\n"
+                              "    REPEAT 5\n"
+                              "      LEFT 9 9\n"
+                              "    END\n"
+                              "  END\n"
+                              "  DELAY 0\n"
+                              "END\n"
+                              "REPEAT 2\n"
+                              "  ENTER\n"
+                              "END\n");
+    std::string loaded = record(nested, false, 2);
+    CHECK(!loaded.empty());
+    CHECK_TEXT(record(nested, true, 2), loaded);
+
+    // Two million actions from a few lines: memory does not follow the repetitions
+    std::filesystem::path large = scratch.path / "large.clk";
+    test::writeScript(large, "REPEAT 1000\nREPEAT 2000\nDELAY 0\nEND\nEND\n");
+    {
+        ClickScript script;
+        script.setTimingEnabled(false);
+        script.setInputBackend(createInputBackend("NULL"));
+        CHECK(script.openStream(large.string()));
+#ifndef _WIN32
+        long before = peakKilobytes();
+#endif
+        script.setCurrentLoop(1);
+        script.execute();
+        CHECK(!script.streamFailed());
+        CHECK(script.getExecutedActions() == 2000000);
+#ifndef _WIN32
+        CHECK(peakKilobytes() - before < 16 * 1024);
+#endif
+    }
+
+    // Errors found on the parser thread arrive with the failure, line numbers intact
+    std::filesystem::path bad = scratch.path / "bad.clk";
+    test::writeScript(bad, "LEFT 1 1\nREPEAT 2\nENTER\nBOGUS 1\nEND\n");
+    {
+        ClickScript script;
+        script.setInputBackend(createInputBackend("NULL"));
+        CHECK(script.openStream(bad.string()));
+        script.execute();
+        CHECK(script.streamFailed());
+        CHECK(script.getErrors().size() == 1 && script.getErrors()[0].line == 5);
+    }
+    std::filesystem::path open = scratch.path / "open.clk";
+    test::writeScript(open, "REPEAT 2\nENTER\n");
+    {
+        ClickScript script;
+        script.setInputBackend(createInputBackend("NULL"));
+        CHECK(script.openStream(open.string()));
+        script.execute();
+        CHECK(script.streamFailed());
+        CHECK(script.getErrors().size() == 1 && script.getErrors()[0].message == "REPEAT without END");
+    }
+    return test::finish("test_stream");
+}
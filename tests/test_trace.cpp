@@ -0,0 +1,90 @@
+// Tracer with the async logger: a new start() drops everything recorded before it,
+// including a span still open on another thread, and the process exits cleanly
+// while the logger's writer thread holds a trace buffer (run it under
+// -DCLICKSCRIPT_SANITIZER=address to check the exit).
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "Tracer.h"
+
+namespace
+{
+    // Poll until condition holds, false after two seconds
+    template <typename Condition>
+    bool eventually(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::string readFile(const std::filesystem::path &file)
+    {
+        std::ifstream in(file);
+        std::ostringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("trace");
+    MyLogger &logger = MyLogger::getInstance();
+    logger.setLogFile((scratch.path / "test.log").string());
+    logger.setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+    logger.enableAsync();
+
+    // The Tracer is built after the logger, as in a run, so it would be destroyed first
+    Tracer &tracer = Tracer::getInstance();
+    Tracer::setThreadName("test");
+    tracer.start();
+    {
+        TraceSpan span("test", "previous run");
+    }
+    MYLOG_ERROR("Logged while tracing");
+    logger.flush();
+    CHECK(eventually([&]
+                     { return tracer.eventCount() >= 3; })); // The span, the flush and the writer's batch
+
+    // A span opened before start() and closed after it belongs to the previous trace
+    std::atomic<bool> opened{false}, restarted{false};
+    std::thread worker([&]
+                       {
+                           TraceSpan span("test", "stale");
+                           opened = true;
+                           while (!restarted)
+                               std::this_thread::yield(); });
+    while (!opened)
+        std::this_thread::yield();
+    tracer.start();
+    restarted = true;
+    worker.join();
+    CHECK(tracer.eventCount() == 0 && tracer.droppedEvents() == 0);
+
+    {
+        TraceSpan span("test", "current run");
+    }
+    CHECK(tracer.eventCount() == 1);
+    std::filesystem::path file = scratch.path / "trace.json";
+    CHECK(tracer.write(file.string()));
+    std::string trace = readFile(file);
+    CHECK(trace.find("\"current run\"") != std::string::npos);
+    CHECK(trace.find("\"previous run\"") == std::string::npos && trace.find("\"stale\"") == std::string::npos);
+    CHECK(trace.find("\"logger\"") == std::string::npos); // Its buffer has nothing in this trace
+
+    // Exit with tracing on and the async writer still running: ~MyLogger joins it
+    // during static destruction and its buffer is retired after that
+    MYLOG_ERROR("Logged at exit");
+    return test::finish("test_trace");
+}
@@ -0,0 +1,98 @@
+// WAIT_FILE / WAIT_FILE_COUNT: met and timed out waits with their policies, and
+// the timing of a DELAY after a wait, which must last its full length from the
+// end of the wait however long the wait took.
+
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "InputBackend.h"
+#include "MyLogger.h"
+#include "TestHarness.h"
+#include "ThreadManager.h"
+#include "clickscript.h"
+
+namespace
+{
+    struct Run
+    {
+        std::shared_ptr<RecordingInputBackend> recording = std::make_shared<RecordingInputBackend>();
+        std::unique_ptr<ClickScript> script = std::make_unique<ClickScript>();
+
+        explicit Run(const std::filesystem::path &file)
+        {
+            script->setCacheEnabled(false);
+            script->load_ClickScript_fromfile(file.string());
+            CHECK(script->getErrors().empty());
+            script->setInputBackend(recording);
+        }
+
+        // Timestamp of the first event at x, -1 if there is none
+        int64_t clickAt(int x) const
+        {
+            for (const auto &record : recording->events())
+            {
+                if (record.event.type == InputEventType::MOUSE_MOVE && record.event.x == x)
+                    return record.timestampNs;
+            }
+            return -1;
+        }
+    };
+
+    constexpr int64_t MS = 1000000;
+}
+
+int main()
+{
+    test::ScratchDirectory scratch("wait");
+    MyLogger::getInstance().setLogFile((scratch.path / "test.log").string());
+    MyLogger::getInstance().setLogLevel(MyLogger::LogLevel::LOG_ERROR);
+    ThreadManager::getInstance().start();
+    std::filesystem::path directory = scratch.path / "out";
+    std::filesystem::create_directories(directory);
+    const std::string quoted = "\"" + directory.string() + "\"";
+    std::filesystem::path file = scratch.path / "wait.clk";
+
+    // Timed out wait, then a DELAY: the DELAY counts from the end of the wait
+    test::writeScript(file, "LEFT 1 1\nWAIT_FILE_COUNT " + quoted + " 5 200 CONTINUE\nDELAY 100\nLEFT 2 2\n");
+    {
+        Run run(file);
+        run.script->execute();
+        int64_t gap = run.clickAt(2) - run.clickAt(1);
+        CHECK(gap >= 290 * MS);
+        const auto &stats = run.script->getScheduler().delayStats();
+        CHECK(stats.size() == 1 && stats[0].maxErrorNs < 50 * MS);
+    }
+
+    // Met wait: another program writes the file of this round while the script waits
+    test::writeScript(file, "LEFT 1 1\nWAIT_FILE " + quoted + " \"report_{loop}.*\" 5000\nDELAY 100\nLEFT 2 2\n");
+    {
+        Run run(file);
+        std::thread writer([&]
+                           {
+                               std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                               std::ofstream(directory / "report_1.csv") << "done"; });
+        run.script->execute();
+        writer.join();
+        int64_t gap = run.clickAt(2) - run.clickAt(1);
+        CHECK(gap >= 190 * MS && gap < 2000 * MS);
+        CHECK(!run.script->runAborted());
+    }
+
+    // SKIP ends the round at the wait, STOP ends the run with a reason
+    test::writeScript(file, "WAIT_FILE_COUNT " + quoted + " 100 20 SKIP\nLEFT 2 2\n");
+    {
+        Run run(file);
+        run.script->execute();
+        CHECK(run.recording->events().empty() && !run.script->runAborted());
+    }
+    test::writeScript(file, "WAIT_FILE_COUNT " + quoted + " +1 20 STOP\nLEFT 2 2\n");
+    {
+        Run run(file);
+        run.script->execute();
+        CHECK(run.recording->events().empty() && run.script->runAborted());
+    }
+
+    ThreadManager::getInstance().stop();
+    return test::finish("test_wait");
+}